@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+#include <Eigen/Dense>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "trackmap.h"
+
+/**
+ * Synthetic track: concentric corridors of 60 pixels width with
+ * some blocking islands, similar to the lernfahrer tracks.
+ */
+static Eigen::MatrixXi createTrack( long width, long height )
+{
+    Eigen::MatrixXi map( height, width );
+    for( long m = 0; m < height; m++ )
+    {
+        for( long n = 0; n < width; n++ )
+        {
+            double r = std::hypot( m - height / 2.0, n - width / 2.0 );
+            bool corridor = int( r / 60.0 ) % 2 == 0;
+            bool island = std::hypot( std::fmod( m, 300.0 ) - 150.0, std::fmod( n, 300.0 ) - 150.0 ) < 12.0;
+            map(m, n) = corridor && !island ? 1 : 0;
+        }
+    }
+    return map;
+}
+
+static std::vector<Eigen::Vector2d> validPositions( const TrackMap& map, size_t count )
+{
+    std::mt19937 gen( 5 );
+    std::uniform_real_distribution<double> px( 0.0, map.getWidth() - 1 );
+    std::uniform_real_distribution<double> py( 0.0, map.getHeight() - 1 );
+
+    std::vector<Eigen::Vector2d> pos;
+    while( pos.size() < count )
+    {
+        Eigen::Vector2d p( px(gen), py(gen) );
+        if( map.isPositionValid( p ) > 0 )
+            pos.push_back( p );
+    }
+    return pos;
+}
+
+// Args: map width, map height
+static void BM_TrackMapIsPositionValid(benchmark::State& state)
+{
+    TrackMap map( createTrack( state.range(0), state.range(1) ) );
+
+    std::mt19937 gen( 3 );
+    std::uniform_real_distribution<double> px( 0.0, state.range(0) - 1 );
+    std::uniform_real_distribution<double> py( 0.0, state.range(1) - 1 );
+    std::vector<Eigen::Vector2d> pos( 4096 );
+    for( Eigen::Vector2d& p : pos )
+        p = Eigen::Vector2d( px(gen), py(gen) );
+
+    for( auto _ : state )
+    {
+        int valid = 0;
+        for( const Eigen::Vector2d& p : pos )
+            valid += map.isPositionValid( p ) > 0;
+        benchmark::DoNotOptimize( valid );
+    }
+
+    state.counters["lookups/s"] = benchmark::Counter( double(state.iterations()) * pos.size(), benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_TrackMapIsPositionValid)
+    ->ArgNames({"width", "height"})
+    ->Args({1200, 800})->Args({4800, 3200});
+
+// Sensor rays of 1200 cars, 7 sensors each, as measured in every simulation step.
+// Args: map width, map height
+static void BM_TrackMapSensorRays(benchmark::State& state)
+{
+    TrackMap map( createTrack( state.range(0), state.range(1) ) );
+    std::vector<Eigen::Vector2d> pos = validPositions( map, 1200 );
+
+    std::vector<Eigen::Vector2d> dirs;
+    for( double a : {-80.0, -50.0, -15.0, 0.0, 15.0, 50.0, 80.0} )
+        dirs.push_back( Eigen::Vector2d( std::cos( a / 180.0 * M_PI ), std::sin( a / 180.0 * M_PI ) ) );
+
+    for( auto _ : state )
+    {
+        double sum = 0.0;
+        for( const Eigen::Vector2d& p : pos )
+            for( const Eigen::Vector2d& d : dirs )
+                sum += map.distanceToEdge( p, d );
+        benchmark::DoNotOptimize( sum );
+    }
+
+    state.counters["rays/s"] = benchmark::Counter( double(state.iterations()) * pos.size() * dirs.size(), benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_TrackMapSensorRays)
+    ->ArgNames({"width", "height"})
+    ->Args({1200, 800})->Args({4800, 3200})
+    ->Unit(benchmark::kMillisecond);
@@ -1,4 +1,3 @@
-
 #include "car.h"
 #include "genetic.h"
 #include "layer.h"
@@ -6,9 +5,26 @@
 #include <iostream>
 #include <Eigen/Geometry>
 
-Car::Car(): m_rotationToOriginal(0.0), m_mapSet(false), m_droveDistance(0.0),
-    m_formerDistance(0.0), m_accumulatedRotation(0.0), m_carSize{4}
+Car::Car(): Car( NetworkPtr( new Network( {8,4,2} ) ) )
+{
+}
+
+Car::Car( NetworkPtr network ): Car( network, std::make_shared<CarPopulation>() )
+{
+}
+
+Car::Car( NetworkPtr network, std::shared_ptr<CarPopulation> population ): m_population(population),
+    m_mapSet(false), m_measured(false), m_carSize{4}
 {
+    m_slot = m_population->allocate();
+
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+    s.droveDistance[l] = 0.0;
+    s.formerDistance[l] = 0.0;
+    s.accumulatedRotation[l] = 0.0;
+    s.lastSuicideCheck[l] = 0.0;
+
     setSpeed( 0.0 );
     setPosition( Eigen::Vector2d(0.0, 0.0));
     setAcceleration(0.0);
@@ -17,111 +33,176 @@ Car::Car(): m_rotationToOriginal(0.0), m_mapSet(false), m_droveDistance(0.0),
 
     setMeasureAngles( {-80, -50.0, -15.0, 0.0, 15.0, 50.0, 80} );
 
-    std::vector<unsigned int> map = {8,4,2};
-    m_network = NetworkPtr( new Network(map) );
-
-    m_killer.start();
+    m_network = network;
 }
 
 Car::~Car()
 {
-
+    m_population->release(m_slot);
 }
 
 double Car::getSpeed() const
 {
-    return m_speed;
+    return m_slot.block->speed[m_slot.lane];
 }
 
 void Car::setSpeed(double speed)
 {
-    m_speed = speed;
+    m_slot.block->speed[m_slot.lane] = speed;
 }
 
-const Eigen::Vector2d &Car::getPosition() const
+Eigen::Vector2d Car::getPosition() const
 {
-    return m_position;
+    return Eigen::Vector2d( m_slot.block->posX[m_slot.lane], m_slot.block->posY[m_slot.lane] );
 }
 
 void Car::setPosition(const Eigen::Vector2d &position)
 {
-    m_position = position;
+    m_slot.block->posX[m_slot.lane] = position(0);
+    m_slot.block->posY[m_slot.lane] = position(1);
 }
 
 double Car::getAcceleration() const
 {
-    return m_acceleration;
+    return m_slot.block->acceleration[m_slot.lane];
 }
 
 void Car::setAcceleration(double acceleration)
 {
-    m_acceleration = acceleration;
+    m_slot.block->acceleration[m_slot.lane] = acceleration;
 }
 
-const Eigen::Vector2d &Car::getDirection() const
+Eigen::Vector2d Car::getDirection() const
 {
-    return m_direction;
+    return Eigen::Vector2d( m_slot.block->dirX[m_slot.lane], m_slot.block->dirY[m_slot.lane] );
 }
 
 void Car::setDirection(const Eigen::Vector2d &direction)
 {
-    m_direction = direction;
-    m_direction.normalize();
-    m_rotationToOriginal = computeAngleBetweenVectors(Eigen::Vector2d(1.0,0.0), m_direction);
+    Eigen::Vector2d d = direction.normalized();
+    m_slot.block->dirX[m_slot.lane] = d(0);
+    m_slot.block->dirY[m_slot.lane] = d(1);
 }
 
 void Car::update()
 {
-    double animTime = getTimeSinceLastUpdate();
+    Car* self = this;
+    CarPopulation::step( &self, 1, getStepDuration() );
+}
+
+void Car::beginStep(double dt)
+{
+    m_stepDuration = dt;
+}
+
+void Car::endStep(double dt)
+{
+    m_clock += dt;
+    m_steps++;
+}
+
+void Car::move(double dt)
+{
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
 
     // rotate first
-    double thisRotation =  m_rotationSpeedRad * animTime;
-    Eigen::Rotation2D<double> r( thisRotation );
-    m_direction = r.toRotationMatrix() * m_direction;
-    Eigen::Vector2d(1.0,0.0);
-    m_rotationToOriginal = computeAngleBetweenVectors(Eigen::Vector2d(1.0,0.0), m_direction);
+    double thisRotation = s.rotationSpeedRad[l] * dt;
+    double c = std::cos(thisRotation);
+    double sn = std::sin(thisRotation);
+    double dx = c * s.dirX[l] - sn * s.dirY[l];
+    double dy = sn * s.dirX[l] + c * s.dirY[l];
+    s.dirX[l] = dx;
+    s.dirY[l] = dy;
+    s.stepRotation[l] = thisRotation;
 
     // adjust speed
-    double newSpeed = std::max(m_speed + animTime*getAcceleration(), 0.0);
+    double newSpeed = std::max(s.speed[l] + dt*s.acceleration[l], 0.0);
     newSpeed = std::min(newSpeed,600.0);
-    Eigen::Vector2d effectiveSpeed = m_direction * (newSpeed + m_speed) * 0.5;
+    double effectiveSpeed = (newSpeed + s.speed[l]) * 0.5;
+    s.nextSpeed[l] = newSpeed;
 
-    // set new position
-    Eigen::Vector2d newPosition = m_position + animTime * effectiveSpeed;
-    newPosition = handleCollision(m_position, newPosition);
+    // candidate position, collision is handled in the next phase
+    s.nextX[l] = s.posX[l] + dt * (dx * effectiveSpeed);
+    s.nextY[l] = s.posY[l] + dt * (dy * effectiveSpeed);
+}
+
+void Car::collideAndMeasure()
+{
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+
+    Eigen::Vector2d position( s.posX[l], s.posY[l] );
+    Eigen::Vector2d newPosition = handleCollision(position, Eigen::Vector2d(s.nextX[l], s.nextY[l]));
+    s.nextX[l] = newPosition(0);
+    s.nextY[l] = newPosition(1);
 
     // adjust drove distance and accumulated rotation
-    m_droveDistance += (newPosition - getPosition()).norm();
-    m_accumulatedRotation += std::abs(thisRotation);
+    s.droveDistance[l] += (newPosition - position).norm();
+    s.accumulatedRotation[l] += std::abs(s.stepRotation[l]);
+
+    // important: measure distances before navigate, from the position before the move
+    for( size_t k = 0; k < m_measureAngles.size(); k++ )
+    {
+        Eigen::Vector2d measureDir( m_sensorCos[k] * s.dirX[l] - m_sensorSin[k] * s.dirY[l],
+                                    m_sensorSin[k] * s.dirX[l] + m_sensorCos[k] * s.dirY[l] );
 
-    // important: measure distances before navigate and post move collision
-    m_measuredDistances = measureDistances();
-    navigate();
+        double dist = distanceToEdge(position,measureDir);
 
-    // update
-    m_speed = newSpeed;
-    m_position = newPosition;
+        s.sensorDistance[k][l] = dist;
+        s.sensorX[k][l] = position(0) + measureDir(0) * dist;
+        s.sensorY[k][l] = position(1) + measureDir(1) * dist;
+    }
+    m_measured = true;
+}
+
+void Car::commit()
+{
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+
+    s.speed[l] = s.nextSpeed[l];
+    s.posX[l] = s.nextX[l];
+    s.posY[l] = s.nextY[l];
 }
 
 double Car::getFitness()
 {
-    return m_droveDistance;
+    return m_slot.block->droveDistance[m_slot.lane];
+}
+
+void Car::reset()
+{
+    Simulation::reset();
+
+    setSpeed( 0.0 );
+    setAcceleration(0.0);
+    setDirection(Eigen::Vector2d(1.0, 0.0));
+    setRotationSpeed(0.0);
+
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+    s.droveDistance[l] = 0.0;
+    s.formerDistance[l] = 0.0;
+    s.accumulatedRotation[l] = 0.0;
+    s.lastSuicideCheck[l] = 0.0;
+    m_measured = false;
 }
 
 double Car::getRotationSpeed() const
 {
-    return m_rotationSpeed;
+    return m_slot.block->rotationSpeed[m_slot.lane];
 }
 
 void Car::setRotationSpeed(double rotationSpeed)
 {
-    m_rotationSpeed = rotationSpeed;
-    m_rotationSpeedRad = -(M_PI / 180.0 * m_rotationSpeed);
+    m_slot.block->rotationSpeed[m_slot.lane] = rotationSpeed;
+    m_slot.block->rotationSpeedRad[m_slot.lane] = -(M_PI / 180.0 * rotationSpeed);
 }
 
 double Car::getRotationRelativeToInitial() const
 {
-    return m_rotationToOriginal;
+    return computeAngleBetweenVectors(Eigen::Vector2d(1.0,0.0), getDirection());
 }
 
 double Car::computeAngleBetweenVectors(const Eigen::Vector2d &a, const Eigen::Vector2d &b) const
@@ -170,37 +251,12 @@ Eigen::Vector2d Car::handleCollision(const Eigen::Vector2d& from, const Eigen::V
     return to;
 }
 
-void Car::handlePostMoveCollision()
-{
-    for(size_t k = 0; k < m_measuredDistances.rows(); k++)
-    {
-        if( m_measuredDistances(k,0) < m_carSize )
-        {
-            this->kill();
-            return;
-        }
-    }
-}
-
 double Car::distanceToEdge(const Eigen::Vector2d &pos, const Eigen::Vector2d &direction) const
 {
     if( !m_mapSet )
         return 0.0;
 
-    Eigen::Vector2d d = direction.normalized();
-    Eigen::Vector2d end = pos;
-
-    bool goOn = true;
-
-    int minDistToEdge = m_map->isPositionValid(end);
-
-    while(minDistToEdge  > 0)
-    {
-        end = end + (d * minDistToEdge);
-        minDistToEdge = m_map->isPositionValid(end);
-    }
-
-    return (end-pos).norm();
+    return m_map->distanceToEdge(pos, direction);
 }
 
 const std::vector<double> &Car::getMeasureAngles() const
@@ -210,47 +266,62 @@ const std::vector<double> &Car::getMeasureAngles() const
 
 void Car::setMeasureAngles(const std::vector<double> &measureAngles)
 {
+    if( measureAngles.size() > size_t(CarPopulation::MaxSensors) )
+    {
+        std::cout << "Error: At most " << CarPopulation::MaxSensors << " measure angles supported" << std::endl;
+        return;
+    }
+
     m_measureAngles = measureAngles;
-}
 
-Eigen::MatrixXd Car::measureDistances() const
-{
-    // distance, xP, yP
-    Eigen::MatrixXd angs( m_measureAngles.size(), 3);
+    // sensor rotations are fixed, only the car direction changes
+    m_sensorCos.resize( m_measureAngles.size() );
+    m_sensorSin.resize( m_measureAngles.size() );
     for( size_t k = 0; k < m_measureAngles.size(); k++ )
     {
         double aRad = -(M_PI / 180.0 * m_measureAngles[k]);
-        Eigen::Rotation2D<double> r( aRad );
-        Eigen::Vector2d measureDir = r.toRotationMatrix() * m_direction;
-
-        double dist = distanceToEdge(getPosition(),measureDir);
-
-        Eigen::Vector2d edgePos = getPosition() + measureDir * dist;
-        angs(k,0) = dist;
-        angs(k,1) = edgePos(0);
-        angs(k,2) = edgePos(1);
+        m_sensorCos[k] = std::cos(aRad);
+        m_sensorSin[k] = std::sin(aRad);
     }
 
-    return angs;
+    m_nnInput.resize( m_measureAngles.size() + 1, 1 ); // additional input for speed
+    m_measured = false;
 }
 
 Eigen::MatrixXd Car::getMeasuredDistances() const
 {
-    return m_measuredDistances;
+    if( !m_measured )
+        return Eigen::MatrixXd();
+
+    // distance, xP, yP
+    const CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+    Eigen::MatrixXd angs( m_measureAngles.size(), 3);
+    for( size_t k = 0; k < m_measureAngles.size(); k++ )
+    {
+        angs(k,0) = s.sensorDistance[k][l];
+        angs(k,1) = s.sensorX[k][l];
+        angs(k,2) = s.sensorY[k][l];
+    }
+
+    return angs;
 }
 
 void Car::considerSuicide()
 {
-    if(( getAge() > 1.0 && m_droveDistance < 3.0) || m_droveDistance < m_formerDistance * 1.01 )
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+
+    if(( getAge() > 1.0 && s.droveDistance[l] < 3.0) || s.droveDistance[l] < s.formerDistance[l] * 1.01 )
     {
         m_alive = false;
     }
     else
     {
-        m_formerDistance = m_droveDistance;
+        s.formerDistance[l] = s.droveDistance[l];
     }
 
-    if( m_accumulatedRotation / getAge() > M_PI / 2.0) //90° per seconds average
+    if( s.accumulatedRotation[l] / getAge() > M_PI / 2.0) //90° per seconds average
     {
         m_alive = false;
     }
@@ -258,17 +329,21 @@ void Car::considerSuicide()
 
 void Car::navigate()
 {
-    // decide what to do next
-    Eigen::MatrixXd nnInput = m_measuredDistances.col(0);
-    nnInput.conservativeResize(m_measuredDistances.rows()+1, 1); // additional input for speed
-    nnInput(nnInput.rows()-1,0) = m_speed;
+    CarPopulation::Block& s = *m_slot.block;
+    const int l = m_slot.lane;
+
+    // decide what to do next, speed of the step start is the additional input
+    const Eigen::Index nbrSensors = Eigen::Index( m_measureAngles.size() );
+    for( Eigen::Index k = 0; k < nbrSensors; k++ )
+        m_nnInput(k,0) = s.sensorDistance[k][l];
+    m_nnInput(nbrSensors,0) = s.speed[l];
 
     // normalize input -> all values are positive -> scale them on a range -1 to +1
-    double maxValInput = nnInput.maxCoeff();
-    nnInput = (nnInput * 2.0/maxValInput).array() - 1.0;
+    double maxValInput = m_nnInput.maxCoeff();
+    m_nnInput = (m_nnInput * 2.0/maxValInput).array() - 1.0;
 
-    m_network->feedForward(nnInput);
-    Eigen::MatrixXd nnOut = m_network->getOutputActivation();
+    m_network->feedForward(m_nnInput);
+    const Eigen::MatrixXd& nnOut = m_network->getOutputActivation();
 
     double maxRotationSpeed = 720.0;
     double maxAcceleration = 100.0;
@@ -279,9 +354,10 @@ void Car::navigate()
     setAcceleration(maxAcceleration*speedActivation);
     setRotationSpeed(maxRotationSpeed*rotationActivation);
 
-    if( m_killer.elapsed() > 1000 )
+    // once per simulated second
+    if( getAge() - s.lastSuicideCheck[l] > 1.0 )
     {
         considerSuicide();
-        m_killer.restart();
+        s.lastSuicideCheck[l] = getAge();
     }
 }
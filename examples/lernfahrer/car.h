@@ -3,27 +3,49 @@
 
 #include "simulation.h"
 #include "trackmap.h"
+#include "carpopulation.h"
 
-#include <QTime>
 #include <Eigen/Dense>
 #include <chrono>
 
 
+/**
+ * Car controlled by a neuronal network. The state of the car is
+ * stored in a CarPopulation, the car object is a handle to it.
+ */
 class Car: public Simulation
 {
 public:
     Car();
+
+    /**
+     * Car controlled by the given network. The network
+     * needs 8 inputs and 2 outputs.
+     * @param network NN
+     */
+    explicit Car( NetworkPtr network );
+
+    /**
+     * Car with its state in the given population.
+     * @param network NN
+     * @param population Population shared with other cars.
+     */
+    Car( NetworkPtr network, std::shared_ptr<CarPopulation> population );
+
     virtual ~Car();
 
+    Car( const Car& ) = delete;
+    Car& operator=( const Car& ) = delete;
+
 public:
 
     double getAcceleration() const;
     void setAcceleration(double acceleration);
-    const Eigen::Vector2d &getPosition() const;
+    Eigen::Vector2d getPosition() const;
     void setPosition(const Eigen::Vector2d &position);
     double getSpeed() const;
     void setSpeed(double speed);
-    const Eigen::Vector2d &getDirection() const;
+    Eigen::Vector2d getDirection() const;
     void setDirection(const Eigen::Vector2d &direction);
 
     /**
@@ -46,6 +68,8 @@ public:
 
     double getFitness() override;
 
+    void reset() override;
+
     double computeAngleBetweenVectors( const Eigen::Vector2d& a, const Eigen::Vector2d& b ) const;
 
     std::shared_ptr<TrackMap> getMap() const;
@@ -56,40 +80,50 @@ public:
 
     const std::vector<double> &getMeasureAngles() const;
 
+    /**
+     * Sensor angles in degree, at most CarPopulation::MaxSensors.
+     * @param measureAngles
+     */
     void setMeasureAngles(const std::vector<double>& measureAngles);
 
+    /**
+     * Distance and edge position of each sensor.
+     * @return Matrix with columns distance, xP, yP. Empty before the first step.
+     */
     Eigen::MatrixXd getMeasuredDistances() const;
 
 
 private:
+    friend class CarPopulation;
+
     void update() override;
+
+    // simulation phases, see CarPopulation::step
+    void move(double dt);
+    void collideAndMeasure();
+    void navigate();
+    void commit();
+
+    // step bookkeeping of Simulation, for steps run by CarPopulation
+    void beginStep(double dt);
+    void endStep(double dt);
+
     Eigen::Vector2d handleCollision(const Eigen::Vector2d& from, const Eigen::Vector2d& to);
-    void handlePostMoveCollision();
-    Eigen::MatrixXd measureDistances() const;
     void considerSuicide();
-    void navigate();
 
 
 private:
-    Eigen::Vector2d m_direction;
-    Eigen::Vector2d m_position;
-    double m_acceleration;
-    double m_speed;
-    double m_rotationSpeed;
-    double m_rotationSpeedRad;
-    double m_rotationToOriginal;
+    std::shared_ptr<CarPopulation> m_population;
+    CarPopulation::Slot m_slot;
 
     std::shared_ptr<TrackMap> m_map;
     bool m_mapSet;
 
     std::vector<double> m_measureAngles;
-    Eigen::MatrixXd m_measuredDistances;
-
-    double m_droveDistance;
-    double m_accumulatedRotation;
-
-    QTime m_killer;
-    double m_formerDistance;
+    std::vector<double> m_sensorCos;
+    std::vector<double> m_sensorSin;
+    bool m_measured;
+    Eigen::MatrixXd m_nnInput;
 
     double m_carSize;
 };
@@ -11,6 +11,7 @@
 CarFactory::CarFactory(std::shared_ptr<TrackMap> map)
 {
     m_map = map;
+    m_population = std::make_shared<CarPopulation>();
 }
 
 CarFactory::~CarFactory()
@@ -20,25 +21,68 @@ CarFactory::~CarFactory()
 
 std::shared_ptr<Simulation> CarFactory::createRandomSimulation()
 {
-    std::shared_ptr<Car> car( new Car( ) );
+    NetworkPtr net( new Network( {8,4,2} ) );
+    setAllBiasToZero(net);
 
-    car->setMap(m_map);
-    car->setPosition(Eigen::Vector2d(400,345) );
-    car->setDirection(Eigen::Vector2d(1,0));
+    return createSimulation(net);
+}
 
-    setAllBiasToZero(car->getNetwork());
+SimulationPtr CarFactory::createSimulation( NetworkPtr network )
+{
+    std::shared_ptr<Car> car( new Car( network, m_population ) );
+
+    car->setMap(m_map);
+    placeAtStart(*car);
 
     return car;
 }
 
+void CarFactory::placeAtStart(Car& car) const
+{
+    car.setPosition(Eigen::Vector2d(400,345) );
+    car.setDirection(Eigen::Vector2d(1,0));
+}
+
 SimulationPtr CarFactory::createCrossover(SimulationPtr a, SimulationPtr b, double mutationRate)
 {
     NetworkPtr cr = Genetic::crossover(a->getNetwork(), b->getNetwork(), Genetic::CrossoverMethod::Uniform, mutationRate);
     setAllBiasToZero(cr);
 
-    SimulationPtr crs = createRandomSimulation();
-    crs->setNetwork(cr);
-    return crs;
+    return createSimulation(cr);
+}
+
+SimulationPtr CarFactory::recycleCrossover(SimulationPtr recycled, SimulationPtr a, SimulationPtr b, double mutationRate)
+{
+    std::shared_ptr<Car> car = std::dynamic_pointer_cast<Car>( recycled );
+    if( !car || !Genetic::crossoverInto(car->getNetwork(), a->getNetwork(), b->getNetwork(), Genetic::CrossoverMethod::Uniform, mutationRate) )
+        return createCrossover(a, b, mutationRate);
+
+    setAllBiasToZero(car->getNetwork());
+
+    car->reset();
+    car->setMap(m_map);
+    placeAtStart(*car);
+
+    return car;
+}
+
+SimulationPtr CarFactory::recycleWithParameters( SimulationPtr recycled, SimulationPtr prototype, const Eigen::VectorXd& parameters )
+{
+    // the biases are part of the parameters, the car has to drive with the
+    // sampled ones for the strategy to learn from its fitness
+    std::shared_ptr<Car> car = std::dynamic_pointer_cast<Car>( recycled );
+    if( !car || !Genetic::setParameterVector( car->getNetwork(), parameters ) )
+    {
+        NetworkPtr net( new Network( *(prototype->getNetwork()) ) );
+        Genetic::setParameterVector( net, parameters );
+        return createSimulation( net );
+    }
+
+    car->reset();
+    car->setMap(m_map);
+    placeAtStart(*car);
+
+    return car;
 }
 
 void CarFactory::setAllBiasToZero(NetworkPtr net)
@@ -47,9 +91,30 @@ void CarFactory::setAllBiasToZero(NetworkPtr net)
         net->getLayer(i)->setBias(0.0);
 }
 
-SimulationPtr CarFactory::copy( SimulationPtr a )
+bool CarFactory::doSteps( const std::vector<SimulationPtr>& sims, size_t start, size_t end, double dt )
 {
-    SimulationPtr crs = createRandomSimulation();
-    crs->setNetwork(a->getNetwork());
-    return crs;
+    if( dt <= 0.0 )
+        return SimulationFactory::doSteps( sims, start, end, dt );
+
+    thread_local std::vector<Car*> cars;
+    cars.clear();
+
+    bool anyAlive = false;
+    for( size_t k = start; k < end; k++ )
+    {
+        Simulation* s = sims[k].get();
+        if( !s->isAlive() )
+            continue;
+
+        anyAlive = true;
+        Car* car = dynamic_cast<Car*>( s );
+        if( car )
+            cars.push_back( car );
+        else
+            s->doStep( dt );
+    }
+
+    CarPopulation::doSteps( cars.data(), cars.size(), dt );
+
+    return anyAlive;
 }
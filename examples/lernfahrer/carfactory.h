@@ -9,6 +9,8 @@
 #include "simulation.h"
 
 class TrackMap;
+class Car;
+class CarPopulation;
 
 class CarFactory: public SimulationFactory
 {
@@ -19,13 +21,25 @@ public:
 
     std::shared_ptr<Simulation> createRandomSimulation() override;
 
+    SimulationPtr createSimulation( NetworkPtr network ) override;
+
     SimulationPtr createCrossover( SimulationPtr a, SimulationPtr b, double mutationRate) override;
 
-    SimulationPtr copy( SimulationPtr a ) override;
+    SimulationPtr recycleCrossover( SimulationPtr recycled, SimulationPtr a, SimulationPtr b, double mutationRate ) override;
+
+    SimulationPtr recycleWithParameters( SimulationPtr recycled, SimulationPtr prototype, const Eigen::VectorXd& parameters ) override;
+
+    /**
+     * Steps the cars together, phase by phase (CarPopulation::doSteps).
+     * Real-time steps are done car by car.
+     */
+    bool doSteps( const std::vector<SimulationPtr>& sims, size_t start, size_t end, double dt ) override;
 
 private:
     void setAllBiasToZero(NetworkPtr net);
+    void placeAtStart(Car& car) const;
     std::shared_ptr<TrackMap> m_map;
+    std::shared_ptr<CarPopulation> m_population;
 
 };
 
@@ -0,0 +1,83 @@
+#include "carpopulation.h"
+#include "car.h"
+
+#include <cassert>
+#include <cstdint>
+
+// new Block() must respect alignas(64), which needs the C++17 aligned new
+#if !defined(__cpp_aligned_new) || __cpp_aligned_new < 201606L
+#error "CarPopulation needs C++17 aligned allocation"
+#endif
+
+CarPopulation::CarPopulation(): m_nbrOfCars(0)
+{
+}
+
+CarPopulation::~CarPopulation()
+{
+}
+
+CarPopulation::Slot CarPopulation::allocate()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( m_free.empty() )
+    {
+        m_blocks.emplace_back( new Block() );
+        Block* block = m_blocks.back().get();
+        assert( reinterpret_cast<uintptr_t>( block ) % alignof(Block) == 0 );
+
+        // lanes handed out in increasing order
+        for( int lane = BlockSize - 1; lane >= 0; lane-- )
+            m_free.push_back( {block, lane} );
+    }
+
+    Slot slot = m_free.back();
+    m_free.pop_back();
+    m_nbrOfCars++;
+
+    return slot;
+}
+
+void CarPopulation::release(const Slot& slot)
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_free.push_back( slot );
+    m_nbrOfCars--;
+}
+
+size_t CarPopulation::getNumberOfCars() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_nbrOfCars;
+}
+
+void CarPopulation::step(Car* const* cars, size_t n, double dt)
+{
+    // pure arithmetic on the car states
+    for( size_t i = 0; i < n; i++ )
+        cars[i]->move( dt );
+
+    // map lookups: collision along the move and sensor rays
+    for( size_t i = 0; i < n; i++ )
+        cars[i]->collideAndMeasure();
+
+    // network evaluation
+    for( size_t i = 0; i < n; i++ )
+        cars[i]->navigate();
+
+    for( size_t i = 0; i < n; i++ )
+        cars[i]->commit();
+}
+
+void CarPopulation::doSteps(Car* const* cars, size_t n, double dt)
+{
+    for( size_t i = 0; i < n; i++ )
+        cars[i]->beginStep( dt );
+
+    step( cars, n, dt );
+
+    for( size_t i = 0; i < n; i++ )
+        cars[i]->endStep( dt );
+}
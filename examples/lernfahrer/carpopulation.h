@@ -0,0 +1,97 @@
+#ifndef EIDNN_CARPOPULATION_H
+#define EIDNN_CARPOPULATION_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Car;
+
+/**
+ * Holds the state of many cars as structure of arrays and steps them
+ * in phases. The cars are stored in blocks of BlockSize lanes. Blocks
+ * never move, so cars can be created and stepped concurrently.
+ */
+class CarPopulation
+{
+public:
+    static const int BlockSize = 16;
+    static const int MaxSensors = 16;
+
+    struct alignas(64) Block
+    {
+        double posX[BlockSize];
+        double posY[BlockSize];
+        double dirX[BlockSize];
+        double dirY[BlockSize];
+        double speed[BlockSize];
+        double acceleration[BlockSize];
+        double rotationSpeed[BlockSize];    // degree per second
+        double rotationSpeedRad[BlockSize]; // -rad per second
+        double droveDistance[BlockSize];
+        double accumulatedRotation[BlockSize];
+        double formerDistance[BlockSize];
+        double lastSuicideCheck[BlockSize];
+
+        // state of the current step
+        double nextX[BlockSize];
+        double nextY[BlockSize];
+        double nextSpeed[BlockSize];
+        double stepRotation[BlockSize];
+
+        // measured distance and edge position per sensor
+        double sensorDistance[MaxSensors][BlockSize];
+        double sensorX[MaxSensors][BlockSize];
+        double sensorY[MaxSensors][BlockSize];
+    };
+
+    struct Slot
+    {
+        Block* block;
+        int lane;
+    };
+
+    CarPopulation();
+    virtual ~CarPopulation();
+
+    /**
+     * Reserves the state of a new car. Thread safe.
+     */
+    Slot allocate();
+
+    /**
+     * Frees the state of a destroyed car. Thread safe.
+     */
+    void release(const Slot& slot);
+
+    /**
+     * Number of cars currently in the population.
+     */
+    size_t getNumberOfCars() const;
+
+    /**
+     * One simulation step of several cars: moving, collision, sensors,
+     * steering. Each phase runs for all cars before the next phase.
+     * The cars may belong to different populations.
+     * @param cars Alive cars
+     * @param dt Step duration in seconds.
+     */
+    static void step(Car* const* cars, size_t n, double dt);
+
+    /**
+     * Like step, but also advances the simulation clock of the cars,
+     * as Simulation::doStep does for a single simulation.
+     * @param cars Alive cars
+     * @param dt Step duration in seconds.
+     */
+    static void doSteps(Car* const* cars, size_t n, double dt);
+
+private:
+    std::vector<std::unique_ptr<Block>> m_blocks;
+    std::vector<Slot> m_free;
+    size_t m_nbrOfCars;
+    mutable std::mutex m_mutex;
+};
+
+
+#endif //EIDNN_CARPOPULATION_H
@@ -19,6 +19,13 @@ GLWidget::GLWidget(QWidget *parent)
     initTracks();
 }
 
+GLWidget::~GLWidget()
+{
+    // the evolution thread writes the snapshots
+    if( m_evo )
+        m_evo->stop();
+}
+
 void GLWidget::animate()
 {
     elapsed = (elapsed + qobject_cast<QTimer*>(sender())->interval()) % 1000;
@@ -27,16 +34,9 @@ void GLWidget::animate()
 
 void GLWidget::paintEvent(QPaintEvent *event)
 {
-    // update simulation
-    if( m_doSimulation )
-    {
-        if (m_evo->isEpochOver())
-            m_evo->breed();
-        
-        m_evo->doStep();
-    }
-
-    std::vector<SimulationPtr> simRes = m_evo->getSimulationsOrderedByFitness();
+    // the simulation runs on the evolution thread, only its latest state is drawn
+    m_snapshots.update();
+    const RenderSnapshot& snapshot = m_snapshots.getReadBuffer();
 
     // draw the simulation
 
@@ -45,32 +45,29 @@ void GLWidget::paintEvent(QPaintEvent *event)
     painter.setRenderHint(QPainter::Antialiasing);
     painter.fillRect(event->rect(), QBrush(QColor(64, 32, 64)));
 
-    m_currentTrack->draw(&painter, simRes);
+    m_currentTrack->draw(&painter, snapshot);
 
     // draw text
     QFont font = painter.font() ;
     font.setPointSize(25);
     painter.setFont(font);
     painter.setPen(QColor(255,255,255));
-    auto stat = m_evo->getNumberAliveAndDead();
     int menuYOffset = 550;
     int menuXOffset = 940;
-    painter.drawText(QPoint(menuXOffset,menuYOffset), QString{"Alive: %1   Dead: %2"}.arg(stat.first).arg(stat.second));
-    painter.drawText(QPoint(menuXOffset,menuYOffset+30), QString{"Average age: %1"}.arg(m_evo->getSimulationsAverageAge(), 0, 'f', 2 ));
-    painter.drawText(QPoint(menuXOffset,menuYOffset+60), QString{"Epoch: %1"}.arg(m_evo->getNumberOfEpochs()));
-    painter.drawText(QPoint(menuXOffset,menuYOffset+90), QString{"FPS: %1"}.arg(m_evo->getSimulationStepsPerSecond(), 0, 'f', 2 ));
+    painter.drawText(QPoint(menuXOffset,menuYOffset), QString{"Alive: %1   Dead: %2"}.arg(snapshot.nbrAlive).arg(snapshot.nbrDead));
+    painter.drawText(QPoint(menuXOffset,menuYOffset+30), QString{"Average age: %1"}.arg(snapshot.averageAge, 0, 'f', 2 ));
+    painter.drawText(QPoint(menuXOffset,menuYOffset+60), QString{"Epoch: %1"}.arg(snapshot.epoch));
+    painter.drawText(QPoint(menuXOffset,menuYOffset+90), QString{"Steps/s: %1"}.arg(snapshot.stepsPerSecond, 0, 'f', 2 ));
 
-    if( simRes.size() > 0 )
+    if( snapshot.best != RenderSnapshot::NoCar )
     {
-        std::shared_ptr<Car> leader = std::dynamic_pointer_cast<Car>( simRes[0] );
-
         font.setPointSize(20);
         painter.setFont(font);
-        painter.drawText(QPoint(menuXOffset,menuYOffset+140), QString{"Leader: %1"}.arg(leader->isAlive() ? "Driving" : "Crashed"));
-        painter.drawText(QPoint(menuXOffset,menuYOffset+160), QString{"Distance: %1 px"}.arg((int)leader->getFitness()));
-        painter.drawText(QPoint(menuXOffset,menuYOffset+180), QString{"Speed: %1 px/s"}.arg((int)leader->getSpeed()));
-        painter.drawText(QPoint(menuXOffset,menuYOffset+200), QString{"Acceleration : %1 px/s^2"}.arg((int)leader->getAcceleration()));
-        painter.drawText(QPoint(menuXOffset,menuYOffset+220), QString{"Rotation : %1 °/s"}.arg((int)leader->getRotationSpeed()));
+        painter.drawText(QPoint(menuXOffset,menuYOffset+140), QString{"Leader: %1"}.arg(snapshot.cars[snapshot.best].alive ? "Driving" : "Crashed"));
+        painter.drawText(QPoint(menuXOffset,menuYOffset+160), QString{"Distance: %1 px"}.arg((int)snapshot.leaderFitness));
+        painter.drawText(QPoint(menuXOffset,menuYOffset+180), QString{"Speed: %1 px/s"}.arg((int)snapshot.leaderSpeed));
+        painter.drawText(QPoint(menuXOffset,menuYOffset+200), QString{"Acceleration : %1 px/s^2"}.arg((int)snapshot.leaderAcceleration));
+        painter.drawText(QPoint(menuXOffset,menuYOffset+220), QString{"Rotation : %1 °/s"}.arg((int)snapshot.leaderRotationSpeed));
 
     }
 
@@ -84,21 +81,39 @@ void GLWidget::doNewEpoch()
 
 void GLWidget::startRace(std::shared_ptr<Track> t)
 {
-    m_doSimulation = false;
-
-    m_currentTrack = t;
-
     if( m_evo )
     {
+        m_evo->stop();
         m_evo->killAllSimulations();
         m_evo->resetFactory(t->getFactory());
     }
     else
     {
         m_evo.reset( new Evolution(1200, 100, t->getFactory(), 8) );
+
+        // cars driving laps would never end the epoch
+        Evolution::EpochTermination termination;
+        termination.maxSimulatedTime = 60.0;
+        m_evo->setEpochTermination(termination);
     }
 
-    m_doSimulation = true;
+    m_currentTrack = t;
+
+    // simulated time advances independently of the frame rate
+    const double dt = 0.02;
+    m_evo->setFixedTimeStep(dt);
+
+    Evolution* evo = m_evo.get();
+    m_evo->start( [this, evo, t, dt]( const std::vector<SimulationPtr>& sims )
+    {
+        t->animate(dt);
+
+        RenderSnapshot& snapshot = m_snapshots.getWriteBuffer();
+        snapshot.capture(sims, *t->getTrackMap());
+        snapshot.epoch = evo->getNumberOfEpochs();
+        snapshot.stepsPerSecond = evo->getSimulationStepsPerSecond();
+        m_snapshots.publish();
+    } );
 }
 
 void GLWidget::nextTrack()
@@ -4,7 +4,9 @@
 
 #include "car.h"
 #include "evolution.h"
+#include "rendersnapshot.h"
 #include "track.h"
+#include "tripleBuffer.h"
 
 #include <QOpenGLWidget>
 #include <QTime>
@@ -18,6 +20,7 @@ Q_OBJECT
 
 public:
     GLWidget(QWidget *parent);
+    ~GLWidget() override;
 
 public slots:
     void animate();
@@ -38,7 +41,7 @@ private:
     int elapsed;
 
     std::shared_ptr<Evolution> m_evo;
-    std::atomic_bool m_doSimulation;
+    TripleBuffer<RenderSnapshot> m_snapshots; // written by the evolution thread
     std::vector<std::shared_ptr<Track>> m_tracks;
     std::shared_ptr<Track> m_currentTrack;
     size_t m_currentTrackIdx;
@@ -0,0 +1,546 @@
+// Runs the car evolution without display, as fast as the cores allow.
+
+#include "trackloader.h"
+#include "trackmap.h"
+#include "carfactory.h"
+#include "evolution.h"
+#include "genetic.h"
+#include "helpers.h"
+#include "islandModel.h"
+#include "multiSimulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct RunnerOptions
+{
+    std::vector<std::string> tracks;  // several -> each car is evaluated on all of them
+    bool aggregateMin = false;     // fitness over the tracks: mean or worst
+    size_t maxEpochs = 0;          // 0 -> unlimited
+    double maxSeconds = 0.0;       // wall-clock budget, 0 -> unlimited
+    size_t population = 1200;
+    size_t offsprings = 100;
+    unsigned int threads = std::max( 1u, std::thread::hardware_concurrency() );
+    double mutationRate = 0.05;
+    long elitism = -1;             // best copied unchanged, -1 -> 2, none with an evolution strategy
+    double timeStep = 0.02;        // simulated seconds per step, 0 -> real-time
+    double maxEpochTime = 60.0;    // simulated seconds until an epoch is stopped
+    double maxEpochWallTime = 0.0; // wall-clock seconds until an epoch is stopped, 0 -> unlimited
+    double cutoffDead = 0.0;       // fraction of dead cars to stop an epoch with converged leader, 0 -> disabled
+    size_t cutoffSteps = 0;        // steps without leader improvement to consider it converged
+    size_t maxCarSteps = 0;        // steps until a car is stopped, 0 -> unlimited
+    bool seeded = false;
+    unsigned int seed = 0;
+    std::string cacheDir;          // track map cache, empty -> no caching
+    std::string checkpoint;        // prefix, empty -> no checkpoints
+    size_t checkpointInterval = 10;
+    std::string populationFile;    // whole population at checkpoints, empty -> not saved
+    std::string resume;            // population file to continue from, empty -> random start
+    bool steadyState = false;      // no generations, dead cars are replaced right away
+    size_t archiveSize = 20;
+    std::string selection = "top2"; // parents of the offsprings
+    size_t selectionSize = 3;      // tournament size or number of elites
+    double targetFitness = 0.0;    // reports the epoch reaching it, 0 -> disabled
+    std::string strategy;          // evolution strategy instead of crossover, empty -> crossover
+    double sigma = 1.0;            // initial step size of the evolution strategy
+    size_t islands = 0;            // number of island processes, 0 -> no migration
+    size_t islandId = 0;
+    std::string islandDir;         // socket files of the islands
+    size_t migrationInterval = 5;
+    size_t migrants = 2;
+    bool ringTopology = true;
+};
+
+static void printUsage( const char* name )
+{
+    std::cout << "Usage: " << name << " track.png [track2.png ...] [options]" << std::endl
+              << "  --aggregate A          fitness over several tracks: mean or min (mean)" << std::endl
+              << "  --epochs N             stop after N epochs" << std::endl
+              << "  --seconds S            stop after S seconds wall-clock time" << std::endl
+              << "  --population N         random cars of the first epoch (1200)" << std::endl
+              << "  --offsprings N         offsprings of further epochs (100)" << std::endl
+              << "  --threads N            number of threads (all cores)" << std::endl
+              << "  --mutation R           mutation rate (0.05)" << std::endl
+              << "  --elitism N            best cars copied unchanged to the next epoch (2, 0 with --strategy)" << std::endl
+              << "  --dt S                 simulated time step in seconds, 0 -> real-time (0.02)" << std::endl
+              << "  --max-epoch-time S     simulated seconds after which an epoch is stopped (60)" << std::endl
+              << "  --max-epoch-wall S     wall-clock seconds after which an epoch is stopped (unlimited)" << std::endl
+              << "  --cutoff-dead F        stop the epoch if fraction F of the cars is dead and" << std::endl
+              << "  --cutoff-steps N       the leader did not improve within N steps (disabled)" << std::endl
+              << "  --max-car-steps N      steps after which a car is stopped (unlimited)" << std::endl
+              << "  --seed N               seed, makes a fixed time step run reproducible" << std::endl
+              << "  --cache DIR            cache the track map in DIR, later starts load it from there" << std::endl
+              << "  --checkpoint PREFIX    save the two best to PREFIX_a.net and PREFIX_b.net" << std::endl
+              << "  --checkpoint-every N   checkpoint interval in epochs (10)" << std::endl
+              << "  --save-population FILE save the whole population and random state at checkpoints" << std::endl
+              << "  --resume FILE          continue the run saved with --save-population" << std::endl
+              << "  --steady-state 1       replace dead cars right away, an epoch is reported" << std::endl
+              << "                         every 'offsprings' replacements, cars die at max-epoch-time" << std::endl
+              << "  --archive N            elite archive size in steady state (20)" << std::endl
+              << "  --selection S          parents of each offspring: top2, tournament, rank," << std::endl
+              << "                         proportional or elite (top2)" << std::endl
+              << "  --selection-size K     tournament size or number of elites (3)" << std::endl
+              << "  --strategy S           breed with an evolution strategy: cma or sep-cma (diagonal)" << std::endl
+              << "  --sigma S              initial step size of the evolution strategy (1.0)" << std::endl
+              << "  --target-fitness F     report the first epoch reaching fitness F" << std::endl
+              << "  --islands N            this process is one of N islands exchanging their best cars," << std::endl
+              << "  --island-id K          this is island K (0 - N-1)" << std::endl
+              << "  --island-dir DIR       directory of the socket files, same for all islands" << std::endl
+              << "  --migrate-every N      migration interval in epochs (5)" << std::endl
+              << "  --migrants N           best cars sent per migration (2)" << std::endl
+              << "  --topology T           ring or full (ring)" << std::endl;
+}
+
+static bool parseOptions( int argc, char* argv[], RunnerOptions& opt )
+{
+    for( int k = 1; k < argc; k++ )
+    {
+        std::string arg = argv[k];
+
+        if( arg.compare( 0, 2, "--" ) != 0 )
+        {
+            opt.tracks.push_back( arg );
+            continue;
+        }
+
+        if( k + 1 >= argc )
+        {
+            std::cout << "Error: Missing value for " << arg << std::endl;
+            return false;
+        }
+
+        const char* val = argv[++k];
+
+        if( arg == "--aggregate" )
+        {
+            if( std::strcmp( val, "mean" ) != 0 && std::strcmp( val, "min" ) != 0 )
+            {
+                std::cout << "Error: Unknown aggregation " << val << std::endl;
+                return false;
+            }
+            opt.aggregateMin = std::strcmp( val, "min" ) == 0;
+        }
+        else if( arg == "--epochs" )
+            opt.maxEpochs = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--seconds" )
+            opt.maxSeconds = std::atof( val );
+        else if( arg == "--population" )
+            opt.population = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--offsprings" )
+            opt.offsprings = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--threads" )
+            opt.threads = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--mutation" )
+            opt.mutationRate = std::atof( val );
+        else if( arg == "--elitism" )
+            opt.elitism = std::strtol( val, nullptr, 10 );
+        else if( arg == "--dt" )
+            opt.timeStep = std::atof( val );
+        else if( arg == "--max-epoch-time" )
+            opt.maxEpochTime = std::atof( val );
+        else if( arg == "--max-epoch-wall" )
+            opt.maxEpochWallTime = std::atof( val );
+        else if( arg == "--cutoff-dead" )
+            opt.cutoffDead = std::atof( val );
+        else if( arg == "--cutoff-steps" )
+            opt.cutoffSteps = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--max-car-steps" )
+            opt.maxCarSteps = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--seed" )
+        {
+            opt.seeded = true;
+            opt.seed = std::strtoul( val, nullptr, 10 );
+        }
+        else if( arg == "--cache" )
+            opt.cacheDir = val;
+        else if( arg == "--checkpoint" )
+            opt.checkpoint = val;
+        else if( arg == "--checkpoint-every" )
+            opt.checkpointInterval = std::max( 1ul, std::strtoul( val, nullptr, 10 ) );
+        else if( arg == "--save-population" )
+            opt.populationFile = val;
+        else if( arg == "--resume" )
+            opt.resume = val;
+        else if( arg == "--steady-state" )
+            opt.steadyState = std::strtoul( val, nullptr, 10 ) != 0;
+        else if( arg == "--archive" )
+            opt.archiveSize = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--selection" )
+            opt.selection = val;
+        else if( arg == "--selection-size" )
+            opt.selectionSize = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--strategy" )
+        {
+            if( std::strcmp( val, "cma" ) != 0 && std::strcmp( val, "sep-cma" ) != 0 )
+            {
+                std::cout << "Error: Unknown strategy " << val << std::endl;
+                return false;
+            }
+            opt.strategy = val;
+        }
+        else if( arg == "--sigma" )
+            opt.sigma = std::atof( val );
+        else if( arg == "--target-fitness" )
+            opt.targetFitness = std::atof( val );
+        else if( arg == "--islands" )
+            opt.islands = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--island-id" )
+            opt.islandId = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--island-dir" )
+            opt.islandDir = val;
+        else if( arg == "--migrate-every" )
+            opt.migrationInterval = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--migrants" )
+            opt.migrants = std::strtoul( val, nullptr, 10 );
+        else if( arg == "--topology" )
+        {
+            if( std::strcmp( val, "ring" ) != 0 && std::strcmp( val, "full" ) != 0 )
+            {
+                std::cout << "Error: Unknown topology " << val << std::endl;
+                return false;
+            }
+            opt.ringTopology = std::strcmp( val, "ring" ) == 0;
+        }
+        else
+        {
+            std::cout << "Error: Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if( opt.tracks.empty() )
+    {
+        std::cout << "Error: No track given" << std::endl;
+        return false;
+    }
+
+    if( opt.population < 2 || opt.offsprings < 2 )
+    {
+        std::cout << "Error: At least two cars are needed" << std::endl;
+        return false;
+    }
+
+    if( opt.islands > 0 )
+    {
+        if( opt.islandId >= opt.islands || opt.islandDir.empty() )
+        {
+            std::cout << "Error: Islands need --island-id and --island-dir" << std::endl;
+            return false;
+        }
+
+        if( opt.steadyState || opt.maxEpochs == 0 )
+        {
+            std::cout << "Error: Islands need the generational mode and --epochs" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::shared_ptr<Selection> createSelection( const RunnerOptions& opt )
+{
+    if( opt.selection == "top2" )
+        return std::shared_ptr<Selection>( new TopTwoSelection() );
+    if( opt.selection == "tournament" )
+        return std::shared_ptr<Selection>( new TournamentSelection( opt.selectionSize ) );
+    if( opt.selection == "rank" )
+        return std::shared_ptr<Selection>( new RankSelection() );
+    if( opt.selection == "proportional" )
+        return std::shared_ptr<Selection>( new FitnessProportionalSelection() );
+    if( opt.selection == "elite" )
+        return std::shared_ptr<Selection>( new EliteSelection( opt.selectionSize ) );
+
+    std::cout << "Error: Unknown selection " << opt.selection << std::endl;
+    return std::shared_ptr<Selection>();
+}
+
+static const char* epochEndName( Evolution::EpochEnd end )
+{
+    switch( end )
+    {
+        case Evolution::EpochEnd::AllDead: return "all crashed";
+        case Evolution::EpochEnd::SimulatedTime: return "simulated time";
+        case Evolution::EpochEnd::WallTime: return "wall time";
+        case Evolution::EpochEnd::Converged: return "converged";
+        default: return "running";
+    }
+}
+
+static bool saveCheckpoint( Evolution& evo, const RunnerOptions& opt )
+{
+    bool saved = true;
+
+    // written while the next epoch runs, fails if the former one was not written
+    if( !opt.populationFile.empty() && !evo.saveCheckpointAsync( opt.populationFile ) )
+    {
+        std::cout << "Error: Could not save population " << opt.populationFile << std::endl;
+        saved = false;
+    }
+
+    if( !opt.checkpoint.empty() && !evo.save( opt.checkpoint + "_a.net", opt.checkpoint + "_b.net" ) )
+    {
+        std::cout << "Error: Could not save checkpoint " << opt.checkpoint << std::endl;
+        saved = false;
+    }
+
+    return saved;
+}
+
+static bool waitForCheckpoint( Evolution& evo, const RunnerOptions& opt )
+{
+    if( !evo.waitForCheckpoint() )
+    {
+        std::cout << "Error: Could not save population " << opt.populationFile << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool runSteadyState( Evolution& evo, const RunnerOptions& opt )
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point runStart = Clock::now();
+    size_t totalSteps = 0;
+    bool saved = true;
+
+    for( size_t epoch = 1; opt.maxEpochs == 0 || epoch <= opt.maxEpochs; epoch++ )
+    {
+        Clock::time_point epochStart = Clock::now();
+        size_t steps = 0;
+
+        size_t target = evo.getNumberOfReplacements() + opt.offsprings;
+        while( evo.getNumberOfReplacements() < target )
+        {
+            evo.doStep();
+            steps++;
+        }
+
+        double epochSeconds = std::chrono::duration<double>( Clock::now() - epochStart ).count();
+        double runSeconds = std::chrono::duration<double>( Clock::now() - runStart ).count();
+        totalSteps += steps;
+
+        std::vector<SimulationPtr> archive = evo.getArchive();
+        double fitness = archive.empty() ? 0.0 : archive.front()->getFitness();
+
+        std::cout << "Epoch " << epoch
+                  << ": " << steps << " steps in " << epochSeconds << " s"
+                  << " (" << steps / std::max( epochSeconds, 1e-9 ) << " steps/s)"
+                  << ", " << evo.getNumberOfReplacements() << " replacements"
+                  << ", archive best " << fitness << std::endl;
+
+        bool lastEpoch = ( opt.maxEpochs != 0 && epoch == opt.maxEpochs ) ||
+                         ( opt.maxSeconds > 0.0 && runSeconds >= opt.maxSeconds );
+
+        if( ( lastEpoch || epoch % opt.checkpointInterval == 0 ) && !saveCheckpoint( evo, opt ) )
+            saved = false;
+
+        if( lastEpoch )
+            break;
+    }
+
+    if( !waitForCheckpoint( evo, opt ) )
+        saved = false;
+
+    double runSeconds = std::chrono::duration<double>( Clock::now() - runStart ).count();
+    std::vector<SimulationPtr> archive = evo.getArchive();
+    std::cout << "Done: " << totalSteps << " steps in " << runSeconds << " s ("
+              << totalSteps / std::max( runSeconds, 1e-9 ) << " steps/s, "
+              << evo.getNumberOfReplacements() / std::max( runSeconds, 1e-9 ) << " cars/s), best fitness "
+              << ( archive.empty() ? 0.0 : archive.front()->getFitness() ) << std::endl;
+
+    return saved;
+}
+
+int main( int argc, char* argv[] )
+{
+    RunnerOptions opt;
+    if( !parseOptions( argc, argv, opt ) )
+    {
+        printUsage( argv[0] );
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<TrackMap>> maps;
+    for( const std::string& track : opt.tracks )
+    {
+        std::shared_ptr<TrackMap> map = TrackLoader::load( track, opt.cacheDir );
+        if( !map )
+            return 1;
+        maps.push_back( map );
+    }
+    double loadSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - loadStart ).count();
+
+    // before the initial population is created
+    if( opt.seeded )
+        Helpers::seedRandomGenerator( opt.seed );
+
+    // one car per genome and track, stepped track by track
+    SimFactoryPtr factory;
+    if( maps.size() == 1 )
+    {
+        factory.reset( new CarFactory( maps.front() ) );
+    }
+    else
+    {
+        std::vector<SimFactoryPtr> trackFactories;
+        for( const std::shared_ptr<TrackMap>& map : maps )
+            trackFactories.push_back( SimFactoryPtr( new CarFactory( map ) ) );
+        factory.reset( new MultiSimulationFactory( trackFactories, opt.aggregateMin ? MultiSimulation::Min : MultiSimulation::Mean ) );
+    }
+    std::shared_ptr<Evolution> evolution( new Evolution( opt.population, opt.offsprings, factory, opt.threads ) );
+    Evolution& evo = *evolution;
+    evo.setMutationRate( opt.mutationRate );
+
+    std::shared_ptr<Selection> selection = createSelection( opt );
+    if( !selection )
+        return 1;
+    evo.setSelection( selection );
+
+    if( !opt.strategy.empty() )
+    {
+        // the random networks are distributed around 0 with deviation 1
+        size_t n = Genetic::getNumberOfParameters( evo.getFittest().front()->getNetwork() );
+        EvolutionStrategy::Covariance covariance = opt.strategy == "cma" ? EvolutionStrategy::Full : EvolutionStrategy::Diagonal;
+        if( !evo.setEvolutionStrategy( std::make_shared<EvolutionStrategy>( Eigen::VectorXd::Zero( n ), opt.sigma, covariance ) ) )
+            return 1;
+        evo.setKeepParents( false );
+    }
+    if( opt.elitism >= 0 )
+        evo.setElitism( size_t( opt.elitism ) );
+    evo.setFixedTimeStep( opt.timeStep );
+
+    // cars driving laps would never end the epoch
+    Evolution::EpochTermination termination;
+    termination.maxSimulatedTime = opt.maxEpochTime;
+    termination.maxWallTime = opt.maxEpochWallTime;
+    termination.deadFraction = opt.cutoffDead;
+    termination.convergenceSteps = opt.cutoffSteps;
+    termination.maxStepsPerSimulation = opt.maxCarSteps;
+    evo.setEpochTermination( termination );
+
+    // continues with the population, settings and random state of the checkpoint
+    size_t firstEpoch = 1;
+    if( !opt.resume.empty() )
+    {
+        if( !evo.loadCheckpoint( opt.resume ) )
+            return 1;
+
+        firstEpoch = evo.getNumberOfEpochs() + 1;
+        std::cout << "Resuming after epoch " << evo.getNumberOfEpochs() << " from " << opt.resume << std::endl;
+    }
+
+    for( size_t k = 0; k < maps.size(); k++ )
+        std::cout << "Track " << opt.tracks[k] << " (" << maps[k]->getWidth() << "x" << maps[k]->getHeight() << ")" << std::endl;
+    std::cout << "Using " << opt.threads << " threads, time step " << opt.timeStep << " s, loaded in " << loadSeconds * 1000.0 << " ms" << std::endl;
+
+    if( opt.steadyState )
+    {
+        evo.setSteadyState( true );
+        evo.setArchiveSize( opt.archiveSize );
+        evo.setMaxSimulationAge( opt.maxEpochTime );
+        return runSteadyState( evo, opt ) ? 0 : 1;
+    }
+
+    // other processes run the other islands, migration replaces breeding every few epochs
+    std::unique_ptr<Island> island;
+    if( opt.islands > 0 )
+    {
+        std::shared_ptr<SocketMigrationChannel> channel( new SocketMigrationChannel( opt.islandDir, opt.islandId ) );
+        if( !channel->isListening() )
+            return 1;
+
+        std::shared_ptr<MigrationTopology> topology;
+        if( opt.ringTopology )
+            topology.reset( new RingTopology() );
+        else
+            topology.reset( new FullyConnectedTopology() );
+
+        island.reset( new Island( opt.islandId, opt.islands, evolution, topology, channel ) );
+        island->setNumberOfMigrants( opt.migrants );
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point runStart = Clock::now();
+    size_t totalSteps = 0;
+    double bestFitness = 0.0;
+    size_t targetEpoch = 0;
+    bool saved = true;
+
+    // the checkpoint was saved before breeding
+    if( evo.isEpochOver() )
+        evo.breed();
+
+    for( size_t epoch = firstEpoch; opt.maxEpochs == 0 || epoch <= opt.maxEpochs; epoch++ )
+    {
+        Clock::time_point epochStart = Clock::now();
+        size_t steps = 0;
+
+        while( !evo.isEpochOver() )
+        {
+            evo.doStep();
+            steps++;
+        }
+
+        double epochSeconds = std::chrono::duration<double>( Clock::now() - epochStart ).count();
+        double runSeconds = std::chrono::duration<double>( Clock::now() - runStart ).count();
+        totalSteps += steps;
+
+        double fitness = evo.getFittest().front()->getFitness();
+        bestFitness = std::max( bestFitness, fitness );
+
+        std::vector<Evolution::EpochStatistics> epochStats = evo.getEpochStatistics( 1 );
+        double median = epochStats.empty() ? 0.0 : epochStats.front().fitnessPercentiles[2];
+        if( targetEpoch == 0 && opt.targetFitness > 0.0 && fitness >= opt.targetFitness )
+            targetEpoch = epoch;
+
+        std::cout << "Epoch " << epoch
+                  << ": " << steps << " steps in " << epochSeconds << " s"
+                  << " (" << steps / std::max( epochSeconds, 1e-9 ) << " steps/s)"
+                  << ", simulated " << evo.getEpochSimulatedTime() << " s"
+                  << " (" << epochEndName( evo.getLastEpochEnd() ) << ")"
+                  << ", best fitness " << fitness
+                  << ", median " << median
+                  << ", best overall " << bestFitness << std::endl;
+
+        bool lastEpoch = ( opt.maxEpochs != 0 && epoch == opt.maxEpochs ) ||
+                         ( opt.maxSeconds > 0.0 && runSeconds >= opt.maxSeconds );
+
+        // save before breeding, the fitness is reset afterwards
+        if( ( lastEpoch || epoch % opt.checkpointInterval == 0 ) && !saveCheckpoint( evo, opt ) )
+            saved = false;
+
+        if( lastEpoch )
+            break;
+
+        if( island && opt.migrationInterval > 0 && epoch % opt.migrationInterval == 0 )
+            island->breedAndMigrate();
+        else
+            evo.breed();
+    }
+
+    if( !waitForCheckpoint( evo, opt ) )
+        saved = false;
+
+    double runSeconds = std::chrono::duration<double>( Clock::now() - runStart ).count();
+    std::cout << "Done: " << totalSteps << " steps in " << runSeconds << " s ("
+              << totalSteps / std::max( runSeconds, 1e-9 ) << " steps/s), best fitness " << bestFitness << std::endl;
+
+    if( opt.targetFitness > 0.0 )
+    {
+        if( targetEpoch > 0 )
+            std::cout << "Target fitness " << opt.targetFitness << " reached in epoch " << targetEpoch << std::endl;
+        else
+            std::cout << "Target fitness " << opt.targetFitness << " not reached" << std::endl;
+    }
+
+    return saved ? 0 : 1;
+}
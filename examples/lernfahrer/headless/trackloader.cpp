@@ -0,0 +1,68 @@
+#include "trackloader.h"
+#include "trackmap.h"
+#include "trackmapcache.h"
+
+#include <png.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+std::shared_ptr<TrackMap> TrackLoader::load( const std::string& path, const std::string& cacheDir )
+{
+    std::ifstream file( path, std::ios::binary );
+    std::vector<char> content( (std::istreambuf_iterator<char>( file )), std::istreambuf_iterator<char>() );
+    if( !file.good() && !file.eof() )
+    {
+        std::cout << "Error: Could not read track " << path << std::endl;
+        return std::shared_ptr<TrackMap>();
+    }
+
+    uint64_t key = TrackMapCache::hash( content.data(), content.size() );
+    if( !cacheDir.empty() )
+    {
+        std::shared_ptr<TrackMap> cached = TrackMapCache::load( cacheDir, key );
+        if( cached )
+            return cached;
+    }
+
+    png_image image;
+    std::memset( &image, 0, sizeof(image) );
+    image.version = PNG_IMAGE_VERSION;
+
+    if( !png_image_begin_read_from_memory( &image, content.data(), content.size() ) )
+    {
+        std::cout << "Error: Could not read track " << path << ": " << image.message << std::endl;
+        return std::shared_ptr<TrackMap>();
+    }
+
+    image.format = PNG_FORMAT_RGB;
+    std::vector<png_byte> pixels( PNG_IMAGE_SIZE(image) );
+
+    if( !png_image_finish_read( &image, nullptr, pixels.data(), 0, nullptr ) )
+    {
+        std::cout << "Error: Could not decode track " << path << ": " << image.message << std::endl;
+        png_image_free( &image );
+        return std::shared_ptr<TrackMap>();
+    }
+
+    Eigen::MatrixXi map = Eigen::MatrixXi::Zero( image.height, image.width );
+    for( Eigen::Index m = 0; m < map.rows(); m++ )
+    {
+        const png_byte* line = &pixels[ 3 * m * image.width ];
+        for( Eigen::Index n = 0; n < map.cols(); n++ )
+        {
+            const png_byte* px = line + 3 * n;
+            if( TrackMap::isTrackColor( px[0], px[1], px[2] ) )
+                map(m,n) = 1;
+        }
+    }
+
+    std::shared_ptr<TrackMap> trackMap( new TrackMap( map ) );
+
+    if( !cacheDir.empty() )
+        TrackMapCache::save( cacheDir, key, *trackMap );
+
+    return trackMap;
+}
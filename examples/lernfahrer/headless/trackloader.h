@@ -0,0 +1,26 @@
+#ifndef EIDNN_TRACKLOADER_H
+#define EIDNN_TRACKLOADER_H
+
+#include <memory>
+#include <string>
+
+class TrackMap;
+
+/**
+ * Loads track images without Qt.
+ */
+class TrackLoader
+{
+public:
+    /**
+     * Creates the track map of a PNG track image. Pixels in the
+     * track color (TrackMap::isTrackColor) are drivable.
+     * @param path Path to the PNG file.
+     * @param cacheDir Directory for TrackMapCache files. Empty -> no caching.
+     * @return Track map or NULL if the image could not be read.
+     */
+    static std::shared_ptr<TrackMap> load( const std::string& path, const std::string& cacheDir = "" );
+};
+
+
+#endif //EIDNN_TRACKLOADER_H
@@ -0,0 +1,77 @@
+#include "rendersnapshot.h"
+#include "car.h"
+
+void RenderSnapshot::capture( const std::vector<SimulationPtr>& sims, const TrackMap& map )
+{
+    cars.clear();
+    sensorEnds.clear();
+    obstacles = map.getDynamicObstacles();
+
+    best = NoCar;
+    secondBest = NoCar;
+    double bestFitness = 0.0;
+    double secondFitness = 0.0;
+    const Car* leader = nullptr;
+
+    nbrAlive = 0;
+    nbrDead = 0;
+    double ageSum = 0.0;
+
+    for( const SimulationPtr& s : sims )
+    {
+        const Car* car = dynamic_cast<const Car*>( s.get() );
+        if( !car )
+            continue;
+
+        CarSnapshot c;
+        c.position = car->getPosition();
+        c.alive = car->isAlive();
+        c.firstSensor = sensorEnds.size();
+        c.nbrOfSensors = 0;
+
+        // sensors are only drawn for alive cars
+        if( c.alive )
+        {
+            Eigen::MatrixXd distances = car->getMeasuredDistances();
+            for( Eigen::Index i = 0; i < distances.rows(); i++ )
+                sensorEnds.push_back( Eigen::Vector2d( distances(i,1), distances(i,2) ) );
+            c.nbrOfSensors = size_t( distances.rows() );
+            nbrAlive++;
+        }
+        else
+        {
+            nbrDead++;
+        }
+
+        ageSum += car->getAge();
+
+        // two best without sorting the population
+        double fitness = s->getFitness();
+        size_t idx = cars.size();
+        if( best == NoCar || fitness > bestFitness )
+        {
+            secondBest = best;
+            secondFitness = bestFitness;
+            best = idx;
+            bestFitness = fitness;
+            leader = car;
+        }
+        else if( secondBest == NoCar || fitness > secondFitness )
+        {
+            secondBest = idx;
+            secondFitness = fitness;
+        }
+
+        cars.push_back( c );
+    }
+
+    averageAge = cars.empty() ? 0.0 : ageSum / double( cars.size() );
+
+    if( leader )
+    {
+        leaderFitness = bestFitness;
+        leaderSpeed = leader->getSpeed();
+        leaderAcceleration = leader->getAcceleration();
+        leaderRotationSpeed = leader->getRotationSpeed();
+    }
+}
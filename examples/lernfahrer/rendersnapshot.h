@@ -0,0 +1,61 @@
+#ifndef EIDNN_RENDERSNAPSHOT_H
+#define EIDNN_RENDERSNAPSHOT_H
+
+#include "simulation.h"
+#include "trackmap.h"
+
+#include <Eigen/Dense>
+#include <vector>
+
+/**
+ * State of a car needed to draw it.
+ */
+struct CarSnapshot
+{
+    Eigen::Vector2d position;
+    bool alive;
+    size_t firstSensor; // index into RenderSnapshot::sensorEnds
+    size_t nbrOfSensors;
+};
+
+/**
+ * Everything needed to draw the race, copied from the simulations on the
+ * evolution thread. The GUI thread only reads snapshots, never the
+ * simulations themselves. Snapshots are reused, so capturing does not
+ * allocate once the vectors have grown.
+ */
+struct RenderSnapshot
+{
+    static const size_t NoCar = size_t(-1);
+
+    std::vector<CarSnapshot> cars;
+    std::vector<Eigen::Vector2d> sensorEnds;
+    std::vector<DynamicObstacle> obstacles;
+
+    // indices into cars
+    size_t best = NoCar;
+    size_t secondBest = NoCar;
+
+    // leader
+    double leaderFitness = 0.0;
+    double leaderSpeed = 0.0;
+    double leaderAcceleration = 0.0;
+    double leaderRotationSpeed = 0.0;
+
+    size_t nbrAlive = 0;
+    size_t nbrDead = 0;
+    double averageAge = 0.0;
+    size_t epoch = 0;
+    double stepsPerSecond = 0.0;
+
+    /**
+     * Copies the state of the cars and obstacles. Evolution statistics
+     * (epoch, stepsPerSecond) are set by the caller.
+     * @param sims Simulations, all of them cars.
+     * @param map Track map with the dynamic obstacles.
+     */
+    void capture( const std::vector<SimulationPtr>& sims, const TrackMap& map );
+};
+
+
+#endif //EIDNN_RENDERSNAPSHOT_H
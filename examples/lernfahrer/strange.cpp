@@ -3,10 +3,11 @@
 //
 
 #include "strange.h"
+#include "trackmap.h"
 
 Strange::Strange(const QString &name, const QString &rscPath) : Track(name, rscPath), m_anim(0.0)
 {
-    m_originalMap = createMap(getTrackImg());
+    m_obstacle = m_trackMap->addDynamicObstacle({650, 310, 30, 100});
 }
 
 Strange::~Strange()
@@ -14,27 +15,14 @@ Strange::~Strange()
 
 }
 
-void Strange::draw(QPainter *painter, const std::vector<SimulationPtr > &simRes)
+void Strange::animate(double dt)
 {
-    drawMap(painter);
+    // move obstacle
+    int obstStartPosX = 650;
+    int obstStartPosY = 310;
+    int obstaclePos = std::sin(m_anim) * 120.0 + obstStartPosY;
 
-    // draw moving obstacle
-    size_t obstStartPosX = 650;
-    size_t obstStartPosY = 310;
-    size_t obstaclePos = std::sin(m_anim) * 120.0 + obstStartPosY;
+    m_anim = m_anim + 1.0 * dt;
 
-    m_anim = m_anim + 0.02;
-
-    Eigen::MatrixXi newDynMap = m_trackMap->createAllValidMap();
-
-    for( size_t m = 0; m < 100; m++ )
-        for( size_t n = 0; n < 30; n++ )
-            newDynMap(obstaclePos+m, obstStartPosX+n) = 0;
-
-    m_trackMap->setDynamicMap(newDynMap);
-
-    painter->setBrush(QBrush(Qt::blue));
-    painter->drawRect(QRect(obstStartPosX,obstaclePos,30,100));
-
-    drawAllCars(painter, simRes);
+    m_trackMap->moveDynamicObstacle(m_obstacle, obstStartPosX, obstaclePos);
 }
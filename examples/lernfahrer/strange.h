@@ -13,11 +13,11 @@ public:
     Strange(const QString &name, const QString &rscPath);
     virtual ~Strange();
 
-    void draw(QPainter *painter, const std::vector<SimulationPtr > &simRes) override;
+    void animate(double dt) override;
 
 private:
-    Eigen::MatrixXi m_originalMap;
     double m_anim;
+    size_t m_obstacle;
 };
 
 
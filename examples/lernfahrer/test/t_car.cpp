@@ -22,10 +22,19 @@
 *****************************************************************************/
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <chrono>
 #include <thread>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
 #include "car.h"
+#include "carfactory.h"
+#include "carpopulation.h"
+#include "rendersnapshot.h"
 #include "trackmap.h"
+#include "trackmapcache.h"
 #include "helpers.h"
 
 TEST(Car, Init)
@@ -88,6 +97,24 @@ TEST(Car, Accelerate)
     delete c;
 }
 
+TEST(Car, AccelerateFixedTimeStep)
+{
+    auto c = new Car();
+
+    c->setDirection(Eigen::Vector2d(1,0));
+    c->setSpeed(0.0);
+    c->setAcceleration(10.0);
+
+    // no waiting, the step is simulated
+    c->doStep(1.0);
+
+    ASSERT_DOUBLE_EQ(c->getSpeed(),10.0);
+    ASSERT_DOUBLE_EQ(c->getPosition()(0),5.0);
+    ASSERT_DOUBLE_EQ(c->getAge(),1.0);
+
+    delete c;
+}
+
 TEST(Car, Rotation)
 {
     auto c = new Car();
@@ -270,4 +297,233 @@ TEST(Car, DistanceMapHeavyComp)
     }
 }
 
+TEST(Car, EuclideanDistanceMap)
+{
+    Eigen::MatrixXi map(5,5);
+    map.fill(1);
+
+    Eigen::MatrixXf dmap = TrackMap::computeEuclideanDistanceMap(map);
+
+    ASSERT_FLOAT_EQ(dmap(2,2), 3.0);
+    ASSERT_FLOAT_EQ(dmap(1,2), 2.0);
+    ASSERT_FLOAT_EQ(dmap(0,0), 1.0);
+    ASSERT_FLOAT_EQ(dmap(4,4), 1.0);
+
+    map(1,1) = 0;
+    dmap = TrackMap::computeEuclideanDistanceMap(map);
+
+    ASSERT_FLOAT_EQ(dmap(1,1), 0.0);
+    ASSERT_FLOAT_EQ(dmap(2,2), std::sqrt(2.0));
+    ASSERT_FLOAT_EQ(dmap(1,3), 2.0);
+    ASSERT_FLOAT_EQ(dmap(3,3), 2.0);
+}
+
+TEST(Car, DistanceToEdgeMatchesPixelMarch)
+{
+    // track with round and square obstacles
+    Eigen::MatrixXi map(300,400);
+    map.fill(1);
+    for( long m = 0; m < map.rows(); m++ )
+    {
+        for( long n = 0; n < map.cols(); n++ )
+        {
+            if( std::hypot(m - 150.0, n - 200.0) < 40.0 || std::hypot(m - 60.0, n - 320.0) < 15.0 )
+                map(m,n) = 0;
+            if( m > 200 && m < 230 && n > 50 && n < 70 )
+                map(m,n) = 0;
+        }
+    }
+    map.row(100).segment(0, 150).setZero(); // thin wall
+
+    TrackMap tmap(map);
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> px(0.0, map.cols()-1);
+    std::uniform_real_distribution<double> py(0.0, map.rows()-1);
+    std::uniform_real_distribution<double> angle(0.0, 2.0*M_PI);
+
+    for( int k = 0; k < 2000; k++ )
+    {
+        Eigen::Vector2d pos(px(gen), py(gen));
+        double a = angle(gen);
+        Eigen::Vector2d dir(std::cos(a), std::sin(a));
+
+        // pixel by pixel
+        Eigen::Vector2d end = pos;
+        while( tmap.isPositionValid(end) > 0 )
+            end = end + dir;
+        double naive = (end - pos).norm();
+
+        ASSERT_NEAR(tmap.distanceToEdge(pos, dir), naive, 1.0);
+    }
+}
+
+TEST(Car, DynamicObstacle)
+{
+    Eigen::MatrixXi map(100,100);
+    map.fill(1);
 
+    TrackMap tmap(map);
+    size_t idx = tmap.addDynamicObstacle({50, 40, 10, 20});
+
+    ASSERT_EQ(tmap.isPositionValid(Eigen::Vector2d(55,50)), 0);
+    ASSERT_GT(tmap.isPositionValid(Eigen::Vector2d(55,39)), 0);
+    ASSERT_NEAR(tmap.distanceToEdge(Eigen::Vector2d(10,50), Eigen::Vector2d(1,0)), 40.0, 0.1);
+    ASSERT_NEAR(tmap.distanceToEdge(Eigen::Vector2d(55,10), Eigen::Vector2d(0,1)), 30.0, 0.1);
+
+    tmap.moveDynamicObstacle(idx, 70, 40);
+    ASSERT_GT(tmap.isPositionValid(Eigen::Vector2d(55,50)), 0);
+    ASSERT_NEAR(tmap.distanceToEdge(Eigen::Vector2d(10,50), Eigen::Vector2d(1,0)), 60.0, 0.1);
+
+    tmap.clearDynamicObstacles();
+    ASSERT_NEAR(tmap.distanceToEdge(Eigen::Vector2d(10,50), Eigen::Vector2d(1,0)), 90.0, 0.1);
+}
+
+TEST(Car, ClearanceTiles)
+{
+    // size not a multiple of the tile size
+    Eigen::MatrixXi map(37,613);
+    map.fill(1);
+    map.block(10, 20, 5, 7).setZero();
+    map(30, 600) = 0;
+
+    TrackMap tmap(map);
+    Eigen::MatrixXf dmap = TrackMap::computeEuclideanDistanceMap(map);
+
+    for( long m = 0; m < map.rows(); m++ )
+        for( long n = 0; n < map.cols(); n++ )
+            ASSERT_EQ(tmap.isPositionValid(Eigen::Vector2d(n, m)), std::min(255, (int)std::floor(dmap(m, n))));
+}
+
+TEST(Car, TrackMapCache)
+{
+    const char text[] = "a";
+    ASSERT_EQ(TrackMapCache::hash(text, 1), 0xaf63dc4c8601ec8cull);
+
+    Eigen::MatrixXi map(50,70);
+    map.fill(1);
+    map.block(10, 20, 5, 30).setZero();
+
+    std::string dir = std::filesystem::temp_directory_path().string();
+    uint64_t key = TrackMapCache::hash(map.data(), map.size() * sizeof(int));
+
+    TrackMap original(map);
+    ASSERT_TRUE(TrackMapCache::save(dir, key, original));
+
+    std::shared_ptr<TrackMap> cached = TrackMapCache::load(dir, key);
+    ASSERT_TRUE(cached);
+    ASSERT_FALSE(TrackMapCache::load(dir, key + 1));
+
+    ASSERT_EQ(cached->getWidth(), 70);
+    ASSERT_EQ(cached->getHeight(), 50);
+    ASSERT_EQ(cached->getMap(), map);
+    for( long m = 0; m < map.rows(); m++ )
+        for( long n = 0; n < map.cols(); n++ )
+            ASSERT_EQ(cached->isPositionValid(Eigen::Vector2d(n, m)), original.isPositionValid(Eigen::Vector2d(n, m)));
+
+    // concurrent starts caching the same track write separate temporary files
+    std::vector<std::thread> writers;
+    std::vector<char> saved(4, 0);
+    for( size_t k = 0; k < saved.size(); k++ )
+        writers.emplace_back([&, k]() { saved[k] = TrackMapCache::save(dir, key, original); });
+    for( std::thread& t : writers )
+        t.join();
+    for( char s : saved )
+        ASSERT_TRUE(s);
+    cached = TrackMapCache::load(dir, key);
+    ASSERT_TRUE(cached);
+    ASSERT_EQ(cached->getMap(), map);
+
+    std::remove(TrackMapCache::cacheFile(dir, key).c_str());
+}
+
+TEST(Car, PopulationStepMatchesSingleStep)
+{
+    Eigen::MatrixXi map(200,200);
+    map.fill(0);
+    map.block(20,20,160,160).fill(1);
+    std::shared_ptr<TrackMap> tmap(new TrackMap(map));
+
+    CarFactory factory(tmap);
+    std::vector<SimulationPtr> batched;
+    std::vector<std::shared_ptr<Car>> single;
+    for( int k = 0; k < 40; k++ )
+    {
+        NetworkPtr net( new Network( {8,4,2} ) );
+        batched.push_back( factory.createSimulation( net ) );
+
+        std::shared_ptr<Car> c( new Car( NetworkPtr( new Network( *net ) ) ) );
+        c->setMap(tmap);
+        single.push_back( c );
+
+        for( auto car : { std::dynamic_pointer_cast<Car>(batched.back()), c } )
+        {
+            car->setPosition(Eigen::Vector2d(100,100));
+            car->setDirection(Eigen::Vector2d(std::cos(k*0.3),std::sin(k*0.3)));
+        }
+    }
+
+    for( int i = 0; i < 100; i++ )
+    {
+        factory.doSteps(batched, 0, batched.size(), 0.02);
+        for( auto& c : single )
+            c->doStep(0.02);
+    }
+
+    for( size_t k = 0; k < single.size(); k++ )
+    {
+        std::shared_ptr<Car> b = std::dynamic_pointer_cast<Car>(batched[k]);
+        ASSERT_EQ(b->isAlive(), single[k]->isAlive());
+        ASSERT_DOUBLE_EQ(b->getAge(), single[k]->getAge());
+        ASSERT_DOUBLE_EQ(b->getFitness(), single[k]->getFitness());
+        ASSERT_DOUBLE_EQ(b->getPosition()(0), single[k]->getPosition()(0));
+        ASSERT_DOUBLE_EQ(b->getPosition()(1), single[k]->getPosition()(1));
+    }
+}
+
+TEST(Car, RenderSnapshot)
+{
+    Eigen::MatrixXi map(200,200);
+    map.fill(1);
+    std::shared_ptr<TrackMap> tmap(new TrackMap(map));
+    tmap->addDynamicObstacle({150, 150, 10, 10});
+
+    CarFactory factory(tmap);
+    std::vector<SimulationPtr> sims;
+    for( int k = 0; k < 3; k++ )
+        sims.push_back( factory.createSimulation( NetworkPtr( new Network( {8,4,2} ) ) ) );
+
+    for( int k = 0; k < 3; k++ )
+    {
+        std::shared_ptr<Car> c = std::dynamic_pointer_cast<Car>(sims[k]);
+        c->setPosition(Eigen::Vector2d(50,50+10*k));
+        c->setSpeed(10.0*(k+1));
+        c->setAcceleration(0.0);
+    }
+
+    for( int i = 0; i < 3; i++ )
+        factory.doSteps(sims, 0, sims.size(), 0.1);
+    sims[0]->kill();
+
+    RenderSnapshot snap;
+    snap.capture(sims, *tmap);
+
+    ASSERT_EQ(snap.cars.size(), 3u);
+    ASSERT_EQ(snap.obstacles.size(), 1u);
+    ASSERT_EQ(snap.nbrAlive, 2u);
+    ASSERT_EQ(snap.nbrDead, 1u);
+    ASSERT_FALSE(snap.cars[0].alive);
+    ASSERT_EQ(snap.cars[0].nbrOfSensors, 0u);
+    ASSERT_EQ(snap.cars[1].nbrOfSensors, 7u);
+    ASSERT_EQ(snap.sensorEnds.size(), 14u);
+    ASSERT_DOUBLE_EQ(snap.cars[2].position(0), std::dynamic_pointer_cast<Car>(sims[2])->getPosition()(0));
+
+    // best by fitness, without reordering the simulations
+    std::vector<std::pair<double,size_t>> order;
+    for( size_t k = 0; k < sims.size(); k++ )
+        order.push_back( {sims[k]->getFitness(), k} );
+    std::sort(order.rbegin(), order.rend());
+    ASSERT_EQ(snap.best, order[0].second);
+    ASSERT_EQ(snap.secondBest, order[1].second);
+    ASSERT_DOUBLE_EQ(snap.leaderFitness, order[0].first);
+}
@@ -5,12 +5,17 @@
 #include "track.h"
 #include "trackmap.h"
 #include "carfactory.h"
+#include "trackmapcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
 
 Track::Track(const QString &name, const QString &rscPath): m_name(name)
 {
     m_trackImg = new QPixmap(rscPath);
 
-    m_trackMap.reset(new TrackMap(createMap(m_trackImg)));
+    m_trackMap = loadTrackMap(rscPath);
     m_factory.reset(new CarFactory(m_trackMap));
 }
 
@@ -34,27 +39,66 @@ QPixmap* Track::getTrackImg() const
     return m_trackImg;
 }
 
+std::shared_ptr<TrackMap> Track::getTrackMap() const
+{
+    return m_trackMap;
+}
+
+void Track::animate(double /*dt*/)
+{
+    // static track
+}
+
 Eigen::MatrixXi Track::createMap(QPixmap* imgP) const
 {
-    QImage img = imgP->toImage();
+    QImage img = imgP->toImage().convertToFormat(QImage::Format_RGB32);
     Eigen::MatrixXi map = Eigen::MatrixXi(img.height(), img.width());
     map.setZero();
-    for( size_t m = 0; m < map.rows(); m++)
+    for( int m = 0; m < map.rows(); m++)
     {
-        for( size_t n = 0; n < map.cols(); n++ )
+        const QRgb* line = reinterpret_cast<const QRgb*>(img.constScanLine(m));
+        for( int n = 0; n < map.cols(); n++ )
         {
-            QRgb color = img.pixel(n,m);
-            if( qRed(color) == 165 && qGreen(color) == 172 && qBlue(color) == 182 ) // Color of the racing track
+            QRgb color = line[n];
+            if( TrackMap::isTrackColor( qRed(color), qGreen(color), qBlue(color) ) )
                 map(m,n) = 1;
         }
     }
     return map;
 }
 
-void Track::draw(QPainter *painter, const std::vector<SimulationPtr>& simRes)
+std::shared_ptr<TrackMap> Track::loadTrackMap(const QString &rscPath) const
+{
+    QByteArray content;
+    QFile file(rscPath);
+    if( file.open(QIODevice::ReadOnly) )
+        content = file.readAll();
+
+    uint64_t key = TrackMapCache::hash(content.constData(), size_t(content.size()));
+
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    bool useCache = !content.isEmpty() && !cacheDir.isEmpty() && QDir().mkpath(cacheDir);
+
+    if( useCache )
+    {
+        std::shared_ptr<TrackMap> cached = TrackMapCache::load(cacheDir.toStdString(), key);
+        if( cached )
+            return cached;
+    }
+
+    std::shared_ptr<TrackMap> map(new TrackMap(createMap(m_trackImg)));
+
+    if( useCache )
+        TrackMapCache::save(cacheDir.toStdString(), key, *map);
+
+    return map;
+}
+
+void Track::draw(QPainter *painter, const RenderSnapshot& snapshot)
 {
     drawMap(painter);
-    drawAllCars(painter, simRes);
+    drawDynamicObstacles(painter, snapshot);
+    drawAllCars(painter, snapshot);
 }
 
 void Track::drawMap(QPainter *painter)
@@ -62,41 +106,35 @@ void Track::drawMap(QPainter *painter)
     painter->drawPixmap(0,0,*getTrackImg());
 }
 
-void Track::drawAllCars(QPainter *painter, const std::vector<SimulationPtr > &simRes)
+void Track::drawAllCars(QPainter *painter, const RenderSnapshot& snapshot)
 {
-    for( size_t k = 0; k < simRes.size(); k++ )
-    {
-        std::shared_ptr<Car> thisCar = std::dynamic_pointer_cast<Car>( simRes[k] );
-        drawCar(painter, thisCar, Qt::green);
-    }
+    for( size_t k = 0; k < snapshot.cars.size(); k++ )
+        drawCar(painter, snapshot, k, Qt::green);
 
     // specially mark the two best
-    if( simRes.size() >= 0 )
-        drawCar(painter, std::dynamic_pointer_cast<Car>( simRes[1] ), Qt::yellow);
+    if( snapshot.secondBest != RenderSnapshot::NoCar )
+        drawCar(painter, snapshot, snapshot.secondBest, Qt::yellow);
 
-    if( simRes.size() >= 1 )
-        drawCar(painter, std::dynamic_pointer_cast<Car>( simRes[0] ), Qt::red);
+    if( snapshot.best != RenderSnapshot::NoCar )
+        drawCar(painter, snapshot, snapshot.best, Qt::red);
 }
 
-void Track::drawCar(QPainter *painter, std::shared_ptr<Car> car, QColor color)
+void Track::drawCar(QPainter *painter, const RenderSnapshot& snapshot, size_t idx, QColor color)
 {
-    QPointF carPos( car->getPosition()(0,0),car->getPosition()(1,0) );
+    const CarSnapshot& car = snapshot.cars[idx];
+    QPointF carPos( car.position(0), car.position(1) );
     painter->setBrush(QBrush(color));
 
-    if( car->isAlive() )
+    if( car.alive )
     {
         int carSize = 8;
         painter->drawEllipse(carPos, carSize, carSize);
 
         // draw distances
-        if( true )
+        for( size_t i = 0; i < car.nbrOfSensors; i++ )
         {
-            Eigen::MatrixXd distances = car->getMeasuredDistances();
-            for (size_t i = 0; i < distances.rows(); i++)
-            {
-                QPointF distEnd(distances(i, 1), distances(i, 2));
-                painter->drawLine(carPos, distEnd);
-            }
+            const Eigen::Vector2d& end = snapshot.sensorEnds[car.firstSensor + i];
+            painter->drawLine(carPos, QPointF(end(0), end(1)));
         }
     }
     else
@@ -106,13 +144,9 @@ void Track::drawCar(QPainter *painter, std::shared_ptr<Car> car, QColor color)
     }
 }
 
-void Track::addDynamicSquare(QPainter *painter, Eigen::MatrixXi &dynMap, size_t px, size_t py, size_t width, size_t height)
+void Track::drawDynamicObstacles(QPainter *painter, const RenderSnapshot& snapshot)
 {
-    for( size_t m = 0; m < height; m++ )
-        for( size_t n = 0; n < width; n++ )
-            dynMap(py+m, px+n) = 0;
-
     painter->setBrush(QBrush(Qt::blue));
-    painter->drawRect(QRect(px,py,width,height));
+    for( const DynamicObstacle& o : snapshot.obstacles )
+        painter->drawRect(QRect(o.x, o.y, o.width, o.height));
 }
-
@@ -6,6 +6,7 @@
 #define EIDNN_TRACK_H
 
 #include "car.h"
+#include "rendersnapshot.h"
 
 #include <QString>
 #include <QPixmap>
@@ -24,15 +25,32 @@ public:
     std::shared_ptr<CarFactory> getFactory() const;
     QString getName() const;
     QPixmap* getTrackImg() const;
+    std::shared_ptr<TrackMap> getTrackMap() const;
 
-    virtual void draw(QPainter *painter, const std::vector<SimulationPtr>& simRes);
+    /**
+     * Advances the moving parts of the track. Called on the evolution
+     * thread after each simulation step.
+     * @param dt Simulated seconds of the step.
+     */
+    virtual void animate(double dt);
+
+    /**
+     * Draws track and cars. Called on the GUI thread.
+     */
+    virtual void draw(QPainter *painter, const RenderSnapshot& snapshot);
 
 protected:
     Eigen::MatrixXi createMap(QPixmap* imgP) const;
+
+    /**
+     * Track map of the image. It is loaded from the track map cache, or
+     * created and added to the cache.
+     */
+    std::shared_ptr<TrackMap> loadTrackMap(const QString& rscPath) const;
     void drawMap(QPainter* painter);
-    void drawCar(QPainter* painter, std::shared_ptr<Car> car, QColor color);
-    void drawAllCars(QPainter *painter, const std::vector<SimulationPtr>& simRes);
-    void addDynamicSquare(QPainter *painter, Eigen::MatrixXi &dynMap, size_t px, size_t py, size_t width, size_t height);
+    void drawCar(QPainter* painter, const RenderSnapshot& snapshot, size_t idx, QColor color);
+    void drawAllCars(QPainter *painter, const RenderSnapshot& snapshot);
+    void drawDynamicObstacles(QPainter *painter, const RenderSnapshot& snapshot);
 
 protected:
     QString m_name;
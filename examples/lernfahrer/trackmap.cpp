@@ -4,12 +4,67 @@
 
 #include "trackmap.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <vector>
 
+namespace
+{
+    /**
+     * Squared distance transform of a one-dimensional sampled function.
+     * @param f Function, 0 at invalid pixels, large elsewhere.
+     * @param d Squared distances.
+     * @param v, z Working memory of size n and n+1.
+     */
+    void distanceTransform1D( const std::vector<double>& f, std::vector<double>& d, std::vector<int>& v, std::vector<double>& z )
+    {
+        const int n = static_cast<int>( f.size() );
+        const double inf = std::numeric_limits<double>::infinity();
+
+        // lower envelope of the parabolas rooted at (q, f(q))
+        int k = 0;
+        v[0] = 0;
+        z[0] = -inf;
+        z[1] = inf;
+        for( int q = 1; q < n; q++ )
+        {
+            double s = ( (f[q] + q*q) - (f[v[k]] + v[k]*v[k]) ) / ( 2.0*q - 2.0*v[k] );
+            while( s <= z[k] )
+            {
+                k--;
+                s = ( (f[q] + q*q) - (f[v[k]] + v[k]*v[k]) ) / ( 2.0*q - 2.0*v[k] );
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k+1] = inf;
+        }
+
+        k = 0;
+        for( int q = 0; q < n; q++ )
+        {
+            while( z[k+1] < q )
+                k++;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    // spreads 3 bits, so x and y can be interleaved to a Morton code
+    const uint8_t mortonSpread[8] = { 0, 1, 4, 5, 16, 17, 20, 21 };
+}
+
+
+TrackMap::TrackMap(const Eigen::MatrixXi& map)
+{
+    resetMap( map );
+}
 
-TrackMap::TrackMap(const Eigen::MatrixXi& map): m_dynamicMapSet(false)
+TrackMap::TrackMap(Eigen::Index rows, Eigen::Index cols, const void* tiles, std::shared_ptr<const void> storage) :
+    m_rows(rows), m_cols(cols), m_tileData(static_cast<const ClearanceTile*>(tiles)), m_tileStorage(storage),
+    m_tilesPerRow((cols + 7) / 8)
 {
-    m_map = map; //computeDistanceMap( map );
 }
 
 TrackMap::~TrackMap()
@@ -19,46 +74,132 @@ TrackMap::~TrackMap()
 
 void TrackMap::resetMap(const Eigen::MatrixXi &map)
 {
-    m_map = computeDistanceMap( map );
+    m_rows = map.rows();
+    m_cols = map.cols();
+    createTiles( computeEuclideanDistanceMap( map ) );
+}
+
+void TrackMap::createTiles(const Eigen::MatrixXf &distanceMap)
+{
+    m_tilesPerRow = ( distanceMap.cols() + 7 ) / 8;
+    Eigen::Index tileRows = ( distanceMap.rows() + 7 ) / 8;
+
+    m_tiles.assign( m_tilesPerRow * tileRows, ClearanceTile() );
+    for( Eigen::Index m = 0; m < distanceMap.rows(); m++ )
+    {
+        for( Eigen::Index n = 0; n < distanceMap.cols(); n++ )
+        {
+            ClearanceTile& t = m_tiles[ (m >> 3) * m_tilesPerRow + (n >> 3) ];
+            t.clearance[ mortonSpread[n & 7] | (mortonSpread[m & 7] << 1) ] =
+                    static_cast<uint8_t>( std::min( std::floor( distanceMap(m, n) ), 255.0f ) );
+        }
+    }
+
+    m_tileData = m_tiles.data();
+    m_tileStorage.reset();
+}
+
+inline int TrackMap::tileValue(Eigen::Index m, Eigen::Index n) const
+{
+    const ClearanceTile& t = m_tileData[ (m >> 3) * m_tilesPerRow + (n >> 3) ];
+    return t.clearance[ mortonSpread[n & 7] | (mortonSpread[m & 7] << 1) ];
+}
+
+Eigen::MatrixXi TrackMap::getMap() const
+{
+    Eigen::MatrixXi map( m_rows, m_cols );
+    for( Eigen::Index m = 0; m < m_rows; m++ )
+        for( Eigen::Index n = 0; n < m_cols; n++ )
+            map(m, n) = tileValue(m, n) > 0 ? 1 : 0;
+    return map;
+}
+
+Eigen::Index TrackMap::getWidth() const
+{
+    return m_cols;
 }
 
-const Eigen::MatrixXi &TrackMap::getMap() const
+Eigen::Index TrackMap::getHeight() const
 {
-    return m_map;
+    return m_rows;
 }
 
 int TrackMap::isPositionValid(const Eigen::Vector2d &pos) const
 {
-    int r = isPositionValid(m_map, pos);
+    return static_cast<int>( clearance(pos) );
+}
+
+double TrackMap::clearance(const Eigen::Vector2d &pos) const
+{
+    if(pos(0) < 0.0 ||  pos(0) > m_cols-1 || pos(1) < 0.0 ||  pos(1) > m_rows-1)
+        return 0.0;
+
+    Eigen::Index m = static_cast<Eigen::Index>(std::ceil(pos(1)));
+    Eigen::Index n = static_cast<Eigen::Index>(std::ceil(pos(0)));
+
+    double c = tileValue(m, n);
+
+    // distance to the closest pixel of each obstacle, 0 if covered
+    for( const DynamicObstacle& o : m_obstacles )
+    {
+        if( c == 0.0 )
+            break;
 
-    if( r!=0 && m_dynamicMapSet )
-        r = std::min(r, isPositionValid(m_dynamicMap, pos));
+        int dx = std::max( { o.x - (int)n, 0, (int)n - (o.x + o.width - 1) } );
+        int dy = std::max( { o.y - (int)m, 0, (int)m - (o.y + o.height - 1) } );
+        c = std::min( c, std::sqrt( double(dx*dx + dy*dy) ) );
+    }
 
-    return r;
+    return c;
 }
 
-int TrackMap::isPositionValid(const Eigen::MatrixXi& map, const Eigen::Vector2d &pos) const
+double TrackMap::distanceToEdge(const Eigen::Vector2d &pos, const Eigen::Vector2d &direction) const
 {
-    if(pos(0) < 0.0 ||  pos(0) > map.cols()-1 || pos(1) < 0.0 ||  pos(1) > map.rows()-1)
-        return 0;
+    Eigen::Vector2d d = direction.normalized();
+    Eigen::Vector2d end = pos;
+
+    // Positions are sampled at the ceiled pixel, which is up to sqrt(2) away.
+    // Staying 3 pixels below the clearance never skips an invalid pixel.
+    double c = clearance(end);
+    while( c > 0.0 )
+    {
+        end = end + d * std::max(1.0, std::floor(c) - 3.0);
+        c = clearance(end);
+    }
+
+    return (end-pos).norm();
+}
 
-    return map( std::ceil(pos(1)) , std::ceil(pos(0)));
+size_t TrackMap::addDynamicObstacle(const DynamicObstacle &obstacle)
+{
+    m_obstacles.push_back(obstacle);
+    return m_obstacles.size() - 1;
+}
+
+void TrackMap::moveDynamicObstacle(size_t idx, int x, int y)
+{
+    m_obstacles[idx].x = x;
+    m_obstacles[idx].y = y;
 }
 
-void TrackMap::setDynamicMap(const Eigen::MatrixXi &map)
+const std::vector<DynamicObstacle> &TrackMap::getDynamicObstacles() const
 {
-    m_dynamicMapSet = true;
-    m_dynamicMap = map;
+    return m_obstacles;
 }
 
-void TrackMap::clearDynamicMap()
+void TrackMap::clearDynamicObstacles()
 {
-    m_dynamicMapSet = false;
+    m_obstacles.clear();
+}
+
+bool TrackMap::isTrackColor( int red, int green, int blue )
+{
+    return red == 165 && green == 172 && blue == 182;
 }
 
 Eigen::MatrixXi TrackMap::createAllValidMap() const
 {
-    return Eigen::MatrixXi::Ones(m_map.rows(), m_map.cols());
+    return Eigen::MatrixXi::Ones(m_rows, m_cols);
 }
 
 Eigen::MatrixXi TrackMap::computeDistanceMap( const Eigen::MatrixXi& map ) const
@@ -136,6 +277,48 @@ Eigen::MatrixXi TrackMap::computeDistanceMap( const Eigen::MatrixXi& map ) const
     return dMap;
 }
 
+Eigen::MatrixXf TrackMap::computeEuclideanDistanceMap( const Eigen::MatrixXi& map )
+{
+    // one pixel border of invalid pixels, so the map border counts as edge
+    const Eigen::Index rows = map.rows() + 2;
+    const Eigen::Index cols = map.cols() + 2;
+    const double far = 1e20;
+
+    Eigen::MatrixXd sq( rows, cols );
+    sq.setZero();
+    for( Eigen::Index m = 0; m < map.rows(); m++ )
+        for( Eigen::Index n = 0; n < map.cols(); n++ )
+            sq(m+1, n+1) = map(m, n) > 0 ? far : 0.0;
+
+    std::vector<double> f( std::max(rows, cols) );
+    std::vector<double> d( f.size() );
+    std::vector<int> v( f.size() );
+    std::vector<double> z( f.size() + 1 );
+
+    // columns first, then rows
+    f.resize( rows ); d.resize( rows );
+    for( Eigen::Index n = 0; n < cols; n++ )
+    {
+        for( Eigen::Index m = 0; m < rows; m++ )
+            f[m] = sq(m, n);
+        distanceTransform1D( f, d, v, z );
+        for( Eigen::Index m = 0; m < rows; m++ )
+            sq(m, n) = d[m];
+    }
+
+    f.resize( cols ); d.resize( cols );
+    for( Eigen::Index m = 0; m < rows; m++ )
+    {
+        for( Eigen::Index n = 0; n < cols; n++ )
+            f[n] = sq(m, n);
+        distanceTransform1D( f, d, v, z );
+        for( Eigen::Index n = 0; n < cols; n++ )
+            sq(m, n) = d[n];
+    }
+
+    return sq.block( 1, 1, map.rows(), map.cols() ).cwiseSqrt().cast<float>();
+}
+
 int TrackMap::mapPositionValue(size_t m, size_t n, const Eigen::MatrixXi &map) const
 {
     if(n < 0 ||  n > map.cols()-1 || m < 0 ||  m > map.rows()-1 )
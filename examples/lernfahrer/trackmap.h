@@ -6,6 +6,20 @@
 #define EIDNN_TRACKMAP_H
 
 #include <Eigen/Dense>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Moving obstacle covering the pixels [x, x+width) x [y, y+height).
+ */
+struct DynamicObstacle
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
 
 class TrackMap
 {
@@ -13,31 +27,115 @@ public:
     TrackMap(const Eigen::MatrixXi& map);
     virtual ~TrackMap();
 
+    TrackMap(const TrackMap&) = delete;
+    TrackMap& operator=(const TrackMap&) = delete;
+
     void resetMap(const Eigen::MatrixXi& map);
-    const Eigen::MatrixXi& getMap() const;
 
-    void setDynamicMap(const Eigen::MatrixXi& map);
-    void clearDynamicMap();
+    /**
+     * Occupancy map, reconstructed from the clearance.
+     * @return 1 for valid pixels, 0 otherwise.
+     */
+    Eigen::MatrixXi getMap() const;
+
+    Eigen::Index getWidth() const;
+    Eigen::Index getHeight() const;
+
+    /**
+     * Adds a moving obstacle on top of the static map.
+     * @return Index of the obstacle, used to move it.
+     */
+    size_t addDynamicObstacle(const DynamicObstacle& obstacle);
 
+    /**
+     * Moves an obstacle. Cheap, intended to be called every frame.
+     * @param idx Index returned by addDynamicObstacle
+     */
+    void moveDynamicObstacle(size_t idx, int x, int y);
+
+    const std::vector<DynamicObstacle>& getDynamicObstacles() const;
+
+    void clearDynamicObstacles();
+
+    /**
+     * Is the position on the track.
+     * @return 0 if invalid. Otherwise the distance to the closest
+     *         invalid pixel, saturated at 255.
+     */
     int isPositionValid(const Eigen::Vector2d &pos) const;
 
+    /**
+     * Distance from pos to the first invalid position in the given direction.
+     * The ray takes large steps where the Euclidean distance map guarantees
+     * free space, and pixel steps close to edges. The result matches
+     * marching pixel by pixel within one pixel.
+     * @param pos Start position
+     * @param direction Direction, does not need to be normalized.
+     * @return Distance in pixels.
+     */
+    double distanceToEdge(const Eigen::Vector2d& pos, const Eigen::Vector2d& direction) const;
+
     Eigen::MatrixXi createAllValidMap() const;
 
     Eigen::MatrixXi computeDistanceMap( const Eigen::MatrixXi& map ) const;
 
+    /**
+     * Exact Euclidean distance transform in linear time
+     * (Felzenszwalb and Huttenlocher, Distance Transforms of Sampled Functions).
+     * @param map Pixels with value 0 are invalid.
+     * @return Distance of each pixel to the closest invalid pixel or the map border.
+     */
+    static Eigen::MatrixXf computeEuclideanDistanceMap( const Eigen::MatrixXi& map );
+
+    /**
+     * Pixels of this color are drivable in track images.
+     */
+    static bool isTrackColor( int red, int green, int blue );
+
 
 private:
 
-    int isPositionValid(const Eigen::MatrixXi& map, const Eigen::Vector2d &pos) const;
+    friend class TrackMapCache;
+
+    /**
+     * Map using tiles stored elsewhere, e.g. in a memory mapped file.
+     * @param tiles Tiles, kept alive by storage.
+     */
+    TrackMap(Eigen::Index rows, Eigen::Index cols, const void* tiles, std::shared_ptr<const void> storage);
+
+    /**
+     * 8x8 pixels, one cache line. The pixels are ordered along
+     * the Z-order (Morton) curve, so close pixels in any direction
+     * are close in memory.
+     */
+    struct alignas(64) ClearanceTile
+    {
+        uint8_t clearance[64];
+    };
+
+    void createTiles(const Eigen::MatrixXf& distanceMap);
+
+    int tileValue(Eigen::Index m, Eigen::Index n) const;
 
     int mapPositionValue(size_t m, size_t n, const Eigen::MatrixXi& map) const;
 
+    /**
+     * Free space around pos, 0 if pos is invalid.
+     */
+    double clearance(const Eigen::Vector2d &pos) const;
+
     void getKnownSuroundingMapDistances( size_t m, size_t n, const Eigen::MatrixXi& map,  int& min, int& max ) const;
 
 
-    Eigen::MatrixXi m_map;
-    Eigen::MatrixXi m_dynamicMap;
-    bool m_dynamicMapSet;
+    Eigen::Index m_rows;
+    Eigen::Index m_cols;
+
+    // clearance of each pixel, used by all queries
+    std::vector<ClearanceTile> m_tiles;
+    const ClearanceTile* m_tileData;
+    std::shared_ptr<const void> m_tileStorage;
+    Eigen::Index m_tilesPerRow;
+    std::vector<DynamicObstacle> m_obstacles;
 };
 
 
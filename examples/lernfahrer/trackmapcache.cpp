@@ -0,0 +1,167 @@
+#include "trackmapcache.h"
+#include "trackmap.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char cacheMagic[8] = { 'E', 'I', 'D', 'N', 'N', 'T', 'R', 'K' };
+
+    // increase when the map format or its computation changes
+    const uint32_t cacheVersion = 1;
+
+    /**
+     * File header, one cache line, so the tiles following it are aligned.
+     */
+    struct CacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t rows;
+        uint32_t cols;
+        uint32_t reserved;
+        uint64_t key;
+        uint8_t padding[32];
+    };
+    static_assert( sizeof(CacheHeader) == 64, "Cache header must be one cache line" );
+
+    size_t numberOfTiles( uint64_t rows, uint64_t cols )
+    {
+        return ( ( rows + 7 ) / 8 ) * ( ( cols + 7 ) / 8 );
+    }
+
+    bool writeAll( int fd, const void* data, size_t size )
+    {
+        const char* bytes = static_cast<const char*>( data );
+        while( size > 0 )
+        {
+            ssize_t written = write( fd, bytes, size );
+            if( written < 0 && errno == EINTR )
+                continue;
+            if( written <= 0 )
+                return false;
+            bytes += written;
+            size -= size_t( written );
+        }
+        return true;
+    }
+}
+
+uint64_t TrackMapCache::hash( const void* data, size_t size )
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>( data );
+    uint64_t h = 14695981039346656037ull;
+    for( size_t i = 0; i < size; i++ )
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string TrackMapCache::cacheFile( const std::string& cacheDir, uint64_t key )
+{
+    std::ostringstream path;
+    path << cacheDir << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".trackmap";
+    return path.str();
+}
+
+std::shared_ptr<TrackMap> TrackMapCache::load( const std::string& cacheDir, uint64_t key )
+{
+    std::string path = cacheFile( cacheDir, key );
+
+    int fd = open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+        return std::shared_ptr<TrackMap>(); // not cached yet
+
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || size_t(st.st_size) < sizeof(CacheHeader) )
+    {
+        close( fd );
+        std::cout << "Error: Invalid track map cache " << path << std::endl;
+        return std::shared_ptr<TrackMap>();
+    }
+
+    size_t size = size_t(st.st_size);
+    void* addr = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if( addr == MAP_FAILED )
+    {
+        std::cout << "Error: Could not map track map cache " << path << std::endl;
+        return std::shared_ptr<TrackMap>();
+    }
+
+    std::shared_ptr<const void> storage( addr, [size]( const void* p ) { munmap( const_cast<void*>(p), size ); } );
+
+    const CacheHeader* header = static_cast<const CacheHeader*>( addr );
+    if( std::memcmp( header->magic, cacheMagic, sizeof(cacheMagic) ) != 0 || header->version != cacheVersion ||
+        header->key != key || size != sizeof(CacheHeader) + 64 * numberOfTiles( header->rows, header->cols ) )
+    {
+        std::cout << "Error: Outdated or corrupt track map cache " << path << std::endl;
+        return std::shared_ptr<TrackMap>();
+    }
+
+    const uint8_t* tiles = static_cast<const uint8_t*>( addr ) + sizeof(CacheHeader);
+    return std::shared_ptr<TrackMap>( new TrackMap( header->rows, header->cols, tiles, storage ) );
+}
+
+bool TrackMapCache::save( const std::string& cacheDir, uint64_t key, const TrackMap& map )
+{
+    std::string path = cacheFile( cacheDir, key );
+
+    CacheHeader header;
+    std::memset( &header, 0, sizeof(header) );
+    std::memcpy( header.magic, cacheMagic, sizeof(cacheMagic) );
+    header.version = cacheVersion;
+    header.rows = uint32_t( map.m_rows );
+    header.cols = uint32_t( map.m_cols );
+    header.key = key;
+
+    // written completely before it becomes visible, concurrent starts never read a partial file.
+    // Each writer has its own temporary file, concurrent saves of the same key do not interleave.
+    std::vector<char> tmpName( path.begin(), path.end() );
+    const char suffix[] = ".XXXXXX";
+    tmpName.insert( tmpName.end(), suffix, suffix + sizeof(suffix) );
+    int fd = mkstemp( tmpName.data() );
+    if( fd < 0 )
+    {
+        std::cout << "Error: Could not create track map cache " << path << std::endl;
+        return false;
+    }
+    std::string tmpPath( tmpName.data() );
+
+    bool written = fchmod( fd, 0644 ) == 0 &&
+                   writeAll( fd, &header, sizeof(header) ) &&
+                   writeAll( fd, map.m_tileData, 64 * numberOfTiles( header.rows, header.cols ) );
+    if( close( fd ) != 0 )
+        written = false;
+
+    if( !written )
+    {
+        std::cout << "Error: Could not write track map cache " << tmpPath << std::endl;
+        std::remove( tmpPath.c_str() );
+        return false;
+    }
+
+    if( std::rename( tmpPath.c_str(), path.c_str() ) != 0 )
+    {
+        std::cout << "Error: Could not write track map cache " << path << std::endl;
+        std::remove( tmpPath.c_str() );
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef EIDNN_TRACKMAPCACHE_H
+#define EIDNN_TRACKMAPCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class TrackMap;
+
+/**
+ * Persists track maps in binary files, so the distance transform of a
+ * track image is computed only once. Files are named by the hash of the
+ * track image and are memory mapped when loaded.
+ */
+class TrackMapCache
+{
+public:
+    /**
+     * 64 bit FNV-1a hash.
+     * @param data Data, e.g. the content of the track image file.
+     * @param size Number of bytes.
+     * @return Hash
+     */
+    static uint64_t hash( const void* data, size_t size );
+
+    /**
+     * Path of the cache file of a key.
+     * @param cacheDir Directory of the cache files.
+     * @param key Hash of the track image.
+     * @return Path
+     */
+    static std::string cacheFile( const std::string& cacheDir, uint64_t key );
+
+    /**
+     * Loads a cached track map. The file stays mapped as long as the map exists.
+     * @param cacheDir Directory of the cache files.
+     * @param key Hash of the track image.
+     * @return Track map or NULL if there is no valid cache file.
+     */
+    static std::shared_ptr<TrackMap> load( const std::string& cacheDir, uint64_t key );
+
+    /**
+     * Writes a track map to the cache.
+     * @param cacheDir Directory of the cache files. Must exist.
+     * @param key Hash of the track image.
+     * @param map Track map
+     * @return True if successful. Otherwise false.
+     */
+    static bool save( const std::string& cacheDir, uint64_t key, const TrackMap& map );
+};
+
+
+#endif //EIDNN_TRACKMAPCACHE_H
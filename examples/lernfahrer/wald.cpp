@@ -3,10 +3,12 @@
 //
 
 #include "wald.h"
+#include "trackmap.h"
 
 Wald::Wald(const QString &name, const QString &rscPath) : Track(name, rscPath), m_anim(0.0)
 {
-    m_originalMap = createMap(getTrackImg());
+    m_bigObstacle = m_trackMap->addDynamicObstacle({90, 330, 40, 40});
+    m_smallObstacle = m_trackMap->addDynamicObstacle({100, 370, 20, 20});
 }
 
 Wald::~Wald()
@@ -14,25 +16,15 @@ Wald::~Wald()
 
 }
 
-void Wald::draw(QPainter *painter, const std::vector<SimulationPtr > &simRes)
+void Wald::animate(double dt)
 {
-    drawMap(painter);
-
-    // draw moving obstacle
-    Eigen::MatrixXi newDynMap = m_trackMap->createAllValidMap();
-
-    size_t obstStartPosX = 90;
-    size_t obstStartPosY = 330;
-    size_t movingDist = 20;
-
-    size_t obstaclePos = std::sin(m_anim) * movingDist/2.0 + obstStartPosX;
-    m_anim = m_anim + 0.03;
-    addDynamicSquare(painter, newDynMap, obstaclePos, obstStartPosY, 40, 40);
-    addDynamicSquare(painter, newDynMap, obstaclePos+10, obstStartPosY+40, 20, 20);
-
-    m_trackMap->setDynamicMap(newDynMap);
-
-
-    drawAllCars(painter, simRes);
+    // move obstacles
+    int obstStartPosX = 90;
+    int obstStartPosY = 330;
+    int movingDist = 20;
+
+    int obstaclePos = std::sin(m_anim) * movingDist/2.0 + obstStartPosX;
+    m_anim = m_anim + 1.5 * dt;
+    m_trackMap->moveDynamicObstacle(m_bigObstacle, obstaclePos, obstStartPosY);
+    m_trackMap->moveDynamicObstacle(m_smallObstacle, obstaclePos+10, obstStartPosY+40);
 }
-
@@ -12,11 +12,12 @@ class Wald: public Track
 public:
     Wald(const QString &name, const QString &rscPath);
     virtual ~Wald();
-    void draw(QPainter *painter, const std::vector<SimulationPtr > &simRes) override;
+    void animate(double dt) override;
 
 private:
-    Eigen::MatrixXi m_originalMap;
     double m_anim;
+    size_t m_bigObstacle;
+    size_t m_smallObstacle;
 };
 
 
@@ -43,7 +43,7 @@ Window::Window()
 
     QTimer *timer = new QTimer(this);
     connect(timer, &QTimer::timeout, openGL, &GLWidget::animate);
-    timer->start(10);
+    timer->start(16); // ~60 FPS, independent of the simulation
 
     connect(nextEpochBtn, SIGNAL (released()),openGL, SLOT (doNewEpoch()));
     connect(nextTrackBtn, SIGNAL (released()),openGL, SLOT (nextTrack()));
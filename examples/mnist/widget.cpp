@@ -143,6 +143,7 @@ Widget::Widget(QWidget* parent) : QMainWindow(parent), ui(new Ui::Widget),
         if( !m_net->isOperationInProgress() )
         {
             m_net->resetWeights();
+            m_net->publishSnapshot();
         }
     });
 
@@ -159,6 +160,17 @@ Widget::Widget(QWidget* parent) : QMainWindow(parent), ui(new Ui::Widget),
 
 Widget::~Widget()
 {
+    // jobs and network report to this widget
+    for( NetworkJobPtr job : {m_validationJob, m_trainingTestingJob} )
+    {
+        if( job )
+        {
+            job->cancel();
+            job->wait();
+        }
+    }
+    m_net.reset();
+
     // Note: Since smartpointers are used, objects get deleted automatically.
     delete ui;
 
@@ -195,8 +207,9 @@ void Widget::prepareSamples()
 
         m_net.reset(new Network(map));
         m_net->setObserver(this);
-        m_net_validation.reset(new Network(*(m_net.get())));
-        m_net_training_testing.reset(new Network(*(m_net.get())));
+        m_net->setStatsEnabled(NetworkStats::isCompiledIn());
+        m_net->setSnapshotInterval(500);
+        m_net->publishSnapshot();
     }
     else
     {
@@ -229,11 +242,10 @@ void Widget::displayTestMNISTImage( const size_t& idx )
 
     ui->testlable->setText( "Lable: " + QString::number(sample.lable, 10) );
 
-    if( !m_net_validation->isOperationInProgress() )
+    NetworkSnapshotPtr snapshot = m_net->getSnapshot();
+    Eigen::MatrixXd activationSignal;
+    if( snapshot && snapshot->feedForward(m_data->m_test.at(idx).input, activationSignal) )
     {
-        // feedforward
-        m_net_validation->feedForward(m_data->m_test.at(idx).input);
-        Eigen::MatrixXd activationSignal = m_net_validation->getOutputActivation();
         QString actStr;
         actStr.sprintf("Activation: [ %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f, %.2f]", activationSignal(0,0), activationSignal(1,0),
                        activationSignal(2,0), activationSignal(3,0), activationSignal(4,0), activationSignal(5,0), activationSignal(6,0),
@@ -315,12 +327,20 @@ void Widget::doNNLearning()
 
 void Widget::doNNTesting()
 {
-    m_net_training_testing->testNetworkAsync( m_batchin, m_batchout, 0.50, NETID_TRAINING_TESTING);
+    // only one test at a time
+    if( m_trainingTestingJob && !m_trainingTestingJob->isFinished() )
+        return;
+
+    m_trainingTestingJob = m_net->getSnapshot()->testAsync( m_batchin, m_batchout, 0.50, NETID_TRAINING_TESTING, m_net->getEventChannel() );
 }
 
 void Widget::doNNValidation()
 {
-    m_net_validation->testNetworkAsync( m_testin, m_testout, 0.50, NETID_VALIDATION);
+    // only one validation at a time
+    if( m_validationJob && !m_validationJob->isFinished() )
+        return;
+
+    m_validationJob = m_net->getSnapshot()->testAsync( m_testin, m_testout, 0.50, NETID_VALIDATION, m_net->getEventChannel() );
 }
 
 void Widget::networkOperationProgress( const NetworkOperationId & opId, const NetworkOperationStatus &opStatus,
@@ -331,19 +351,16 @@ void Widget::networkOperationProgress( const NetworkOperationId & opId, const Ne
         m_progress_learning = progress;
         if( opStatus == NetworkOperationCallback::OpResultOk )
         {
-            // only overwrite if no operation ongoing on validation net
-            if( ! m_net_validation->isOperationInProgress() )
+            // report where the time of this epoch went
+            if( m_net->isStatsEnabled() )
             {
-                m_net_validation.reset( new Network( *(m_net.get())) );
-                emit readyForValidation();
+                std::cout << "Epoch timings:" << std::endl << m_net->getStats().toString();
+                m_net->resetStats();
             }
 
-            // only overwrite if no operation ongoing on training testing net
-            if( ! m_net_training_testing->isOperationInProgress() )
-            {
-                m_net_training_testing.reset( new Network( *(m_net.get())) );
-                emit readyForTrainingTesting();
-            }
+            // the epoch published a new snapshot -> test it
+            emit readyForValidation();
+            emit readyForTrainingTesting();
 
             if( ui->keepLearingCB->isChecked() )
                 emit readyForLearning();
@@ -395,12 +412,13 @@ void Widget::loadNN()
     {
         m_net.reset( Network::load( path.toStdString() ) );
         m_net->setObserver( this );
+        m_net->setStatsEnabled( NetworkStats::isCompiledIn() );
         m_net->setCostFunction( Network::CrossEntropy );
 
         ui->softmax->setChecked(m_net->isSoftmaxOutputEnabled());
 
-        m_net_validation.reset( new Network( *(m_net.get())) );
-        m_net_training_testing.reset( new Network( *(m_net.get())) );
+        m_net->setSnapshotInterval(500);
+        m_net->publishSnapshot();
 
         emit readyForValidation();
         emit readyForTrainingTesting();
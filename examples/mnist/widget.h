@@ -82,8 +82,10 @@ private:
     std::vector<Eigen::MatrixXd> m_testout;
     size_t m_currentIdx;
     std::shared_ptr<Network> m_net;
-    std::shared_ptr<Network> m_net_validation;
-    std::shared_ptr<Network> m_net_training_testing;
+
+    // tests run on the latest weight snapshot of m_net while it keeps training
+    NetworkJobPtr m_validationJob;
+    NetworkJobPtr m_trainingTestingJob;
 
     // thread safe ui values
     std::atomic<double> m_sr_L2, m_sr_MAX;
@@ -0,0 +1,117 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <Eigen/Dense>
+#include <memory>
+
+#include "evolution.h"
+#include "simulation.h"
+
+/**
+ * Synthetic simulation: feeds a constant input through its network in every step
+ * and never dies. This measures the stepping overhead of Evolution plus the
+ * inference cost of the controlling network.
+ */
+class SyntheticSimulation: public Simulation
+{
+public:
+    SyntheticSimulation( unsigned int nbrOfHidden )
+    {
+        m_network = NetworkPtr( new Network( {8, nbrOfHidden, 2} ) );
+        m_input = Eigen::MatrixXd::Random( 8, 1 );
+    }
+
+    double getFitness() override
+    {
+        return m_network->getOutputActivation()(0,0);
+    }
+
+protected:
+    void update() override
+    {
+        m_network->feedForward( m_input );
+        m_input(0,0) = m_network->getOutputActivation()(0,0);
+    }
+
+private:
+    Eigen::MatrixXd m_input;
+};
+
+class SyntheticSimFactory: public SimulationFactory
+{
+public:
+    SyntheticSimFactory( unsigned int nbrOfHidden ): m_nbrOfHidden( nbrOfHidden ) { }
+
+    SimulationPtr createRandomSimulation() override
+    {
+        return SimulationPtr( new SyntheticSimulation( m_nbrOfHidden ) );
+    }
+
+private:
+    unsigned int m_nbrOfHidden;
+};
+
+// Args: population size, number of hidden neurons, number of threads
+static void BM_EvolutionDoStep(benchmark::State& state)
+{
+    const size_t population = size_t(state.range(0));
+    const unsigned int nbrOfHidden = unsigned(state.range(1));
+    const unsigned int nbrOfThreads = unsigned(state.range(2));
+
+    SimFactoryPtr f( new SyntheticSimFactory( nbrOfHidden ) );
+    Evolution evo( population, population, f, nbrOfThreads );
+
+    for( auto _ : state )
+        evo.doStep();
+
+    state.counters["steps/s"] = benchmark::Counter( double(state.iterations()), benchmark::Counter::kIsRate );
+    state.counters["simsteps/s"] = benchmark::Counter( double(state.iterations()) * double(population), benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_EvolutionDoStep)
+    ->ArgNames({"population", "hidden", "threads"})
+    ->Args({100, 4, 1})->Args({1200, 4, 1})->Args({1200, 4, 4})->Args({1200, 4, 8})
+    ->Args({1200, 32, 8})
+    ->UseRealTime();
+
+// Args: population size, number of threads
+static void BM_EvolutionBreed(benchmark::State& state)
+{
+    const size_t population = size_t(state.range(0));
+    const unsigned int nbrOfThreads = unsigned(state.range(1));
+
+    SimFactoryPtr f( new SyntheticSimFactory( 4 ) );
+    Evolution evo( population, population, f, nbrOfThreads );
+    evo.setMutationRate( 0.05 );
+    evo.doStep();
+
+    for( auto _ : state )
+        evo.breed();
+
+    state.counters["offsprings/s"] = benchmark::Counter( double(state.iterations()) * double(population), benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_EvolutionBreed)
+    ->ArgNames({"population", "threads"})
+    ->Args({1200, 1})->Args({1200, 4})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
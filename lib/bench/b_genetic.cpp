@@ -0,0 +1,52 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <memory>
+
+#include "genetic.h"
+#include "network.h"
+
+// Args: number of inputs, number of hidden neurons, number of outputs
+static void BM_GeneticCrossover(benchmark::State& state)
+{
+    const std::vector<unsigned int> structure = {unsigned(state.range(0)), unsigned(state.range(1)), unsigned(state.range(2))};
+    NetworkPtr a( new Network( structure ) );
+    NetworkPtr b( new Network( structure ) );
+
+    for( auto _ : state )
+    {
+        NetworkPtr c = Genetic::crossover( a, b, Genetic::Uniform, 0.05 );
+        benchmark::DoNotOptimize( c.get() );
+    }
+
+    double params = 0.0;
+    for( size_t k = 1; k < structure.size(); k++ )
+        params += double(structure[k]) * double(structure[k-1] + 1);
+
+    state.counters["crossovers/s"] = benchmark::Counter( double(state.iterations()), benchmark::Counter::kIsRate );
+    state.counters["params/s"] = benchmark::Counter( double(state.iterations()) * params, benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_GeneticCrossover)
+    ->ArgNames({"inputs", "hidden", "outputs"})
+    ->Args({8, 4, 2})->Args({8, 32, 2})->Args({784, 30, 10});
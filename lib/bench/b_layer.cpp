@@ -0,0 +1,90 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <Eigen/Dense>
+
+#include "layer.h"
+#include "network.h"
+
+// Args: number of neurons, number of inputs, batch size
+static void BM_LayerFeedForward(benchmark::State& state)
+{
+    const unsigned int nbrOfNeurons = unsigned(state.range(0));
+    const unsigned int nbrOfInputs = unsigned(state.range(1));
+    const long batchsize = long(state.range(2));
+
+    Layer l( nbrOfNeurons, nbrOfInputs );
+    Eigen::MatrixXd x_in = Eigen::MatrixXd::Random( nbrOfInputs, batchsize );
+
+    for( auto _ : state )
+    {
+        l.feedForward( x_in );
+        benchmark::DoNotOptimize( l.getOutputActivation().data() );
+    }
+
+    double samples = double(state.iterations()) * double(batchsize);
+    state.counters["samples/s"] = benchmark::Counter( samples, benchmark::Counter::kIsRate );
+    state.counters["GFLOP/s"] = benchmark::Counter( samples * 2.0 * nbrOfNeurons * nbrOfInputs * 1e-9, benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_LayerFeedForward)
+    ->ArgNames({"neurons", "inputs", "batch"})
+    ->Args({30, 784, 1})->Args({30, 784, 10})->Args({30, 784, 100})
+    ->Args({100, 784, 10})->Args({10, 30, 10})->Args({4, 8, 1});
+
+// Backpropagation chain of a three layer network: output layer error, hidden layer
+// error and the partial derivatives of both layers. The feedforward is not measured.
+// Args: number of inputs, number of hidden neurons, number of outputs, batch size
+static void BM_BackpropagationChain(benchmark::State& state)
+{
+    const unsigned int nbrOfInputs = unsigned(state.range(0));
+    const unsigned int nbrOfHidden = unsigned(state.range(1));
+    const unsigned int nbrOfOutputs = unsigned(state.range(2));
+    const long batchsize = long(state.range(3));
+
+    Network net( {nbrOfInputs, nbrOfHidden, nbrOfOutputs} );
+    Eigen::MatrixXd x_in = Eigen::MatrixXd::Random( nbrOfInputs, batchsize );
+    Eigen::MatrixXd y_out = Eigen::MatrixXd::Random( nbrOfOutputs, batchsize ).cwiseAbs();
+    net.feedForward( x_in );
+
+    std::shared_ptr<Layer> hidden = net.getLayer( 1 );
+    std::shared_ptr<Layer> output = net.getLayer( 2 );
+
+    for( auto _ : state )
+    {
+        output->computeBackpropagationOutputLayerError( y_out );
+        output->computePartialDerivatives();
+        hidden->computeBackprogationError( output->getBackpropagationError(), output->getWeightMatrix() );
+        hidden->computePartialDerivatives();
+        benchmark::DoNotOptimize( hidden->getPartialDerivativesWeights().data() );
+    }
+
+    double samples = double(state.iterations()) * double(batchsize);
+    double flopPerSample = 2.0 * nbrOfHidden * nbrOfOutputs + 2.0 * nbrOfInputs * nbrOfHidden + nbrOfOutputs * nbrOfHidden;
+    state.counters["samples/s"] = benchmark::Counter( samples, benchmark::Counter::kIsRate );
+    state.counters["GFLOP/s"] = benchmark::Counter( samples * flopPerSample * 1e-9, benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_BackpropagationChain)
+    ->ArgNames({"inputs", "hidden", "outputs", "batch"})
+    ->Args({784, 30, 10, 1})->Args({784, 30, 10, 10})->Args({784, 30, 10, 100})
+    ->Args({784, 100, 10, 10})->Args({8, 4, 2, 1});
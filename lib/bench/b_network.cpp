@@ -0,0 +1,171 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <Eigen/Dense>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "network.h"
+
+// random input samples with one-hot lables
+static void createSamples( unsigned int nbrOfInputs, unsigned int nbrOfOutputs, size_t nbrOfSamples,
+                           std::vector<Eigen::MatrixXd>& samples, std::vector<Eigen::MatrixXd>& lables )
+{
+    samples.clear();
+    lables.clear();
+    for( size_t k = 0; k < nbrOfSamples; k++ )
+    {
+        samples.push_back( Eigen::MatrixXd::Random( nbrOfInputs, 1 ) );
+        Eigen::MatrixXd lable = Eigen::MatrixXd::Zero( nbrOfOutputs, 1 );
+        lable( long(k % nbrOfOutputs), 0 ) = 1.0;
+        lables.push_back( lable );
+    }
+}
+
+// Number of parameters (weights and biases) of a network, input layer excluded.
+static double nbrOfParameters( const std::vector<unsigned int>& structure )
+{
+    double params = 0.0;
+    for( size_t k = 1; k < structure.size(); k++ )
+        params += double(structure[k]) * double(structure[k-1] + 1);
+    return params;
+}
+
+// A single stochastic gradient descent batch: feedforward, backpropagation,
+// gradient reduction and weight update. The number of samples equals the batch
+// size, so stochasticGradientDescent() executes exactly one batch.
+// Args: number of inputs, number of hidden neurons, batch size
+static void BM_StochasticGradientDescentBatch(benchmark::State& state)
+{
+    const unsigned int nbrOfInputs = unsigned(state.range(0));
+    const unsigned int nbrOfHidden = unsigned(state.range(1));
+    const unsigned int batchsize = unsigned(state.range(2));
+    const std::vector<unsigned int> structure = {nbrOfInputs, nbrOfHidden, 10};
+
+    std::vector<Eigen::MatrixXd> samples, lables;
+    createSamples( nbrOfInputs, 10, batchsize, samples, lables );
+    Network net( structure );
+
+    for( auto _ : state )
+        benchmark::DoNotOptimize( net.stochasticGradientDescent( samples, lables, batchsize, 0.1 ) );
+
+    double nbrSamples = double(state.iterations()) * double(batchsize);
+    state.counters["samples/s"] = benchmark::Counter( nbrSamples, benchmark::Counter::kIsRate );
+    state.counters["GFLOP/s"] = benchmark::Counter( nbrSamples * 6.0 * nbrOfParameters(structure) * 1e-9, benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_StochasticGradientDescentBatch)
+    ->ArgNames({"inputs", "hidden", "batch"})
+    ->Args({784, 30, 1})->Args({784, 30, 10})->Args({784, 30, 100})
+    ->Args({784, 100, 10})->Args({784, 100, 100});
+
+// A full stochastic gradient descent epoch.
+// Args: number of inputs, number of hidden neurons, batch size, number of samples
+static void BM_StochasticGradientDescentEpoch(benchmark::State& state)
+{
+    const unsigned int nbrOfInputs = unsigned(state.range(0));
+    const unsigned int nbrOfHidden = unsigned(state.range(1));
+    const unsigned int batchsize = unsigned(state.range(2));
+    const size_t nbrOfSamples = size_t(state.range(3));
+    const std::vector<unsigned int> structure = {nbrOfInputs, nbrOfHidden, 10};
+
+    std::vector<Eigen::MatrixXd> samples, lables;
+    createSamples( nbrOfInputs, 10, nbrOfSamples, samples, lables );
+    Network net( structure );
+
+    for( auto _ : state )
+        benchmark::DoNotOptimize( net.stochasticGradientDescent( samples, lables, batchsize, 0.1 ) );
+
+    double nbrSamples = double(state.iterations()) * double(nbrOfSamples / batchsize * batchsize);
+    state.counters["samples/s"] = benchmark::Counter( nbrSamples, benchmark::Counter::kIsRate );
+    state.counters["GFLOP/s"] = benchmark::Counter( nbrSamples * 6.0 * nbrOfParameters(structure) * 1e-9, benchmark::Counter::kIsRate );
+    state.counters["epochs/s"] = benchmark::Counter( double(state.iterations()), benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_StochasticGradientDescentEpoch)
+    ->ArgNames({"inputs", "hidden", "batch", "samples"})
+    ->Args({784, 30, 1, 2000})->Args({784, 30, 10, 2000})->Args({784, 30, 100, 2000})
+    ->Unit(benchmark::kMillisecond);
+
+// Args: number of inputs, number of hidden neurons, number of samples
+static void BM_TestNetwork(benchmark::State& state)
+{
+    const unsigned int nbrOfInputs = unsigned(state.range(0));
+    const unsigned int nbrOfHidden = unsigned(state.range(1));
+    const size_t nbrOfSamples = size_t(state.range(2));
+    const std::vector<unsigned int> structure = {nbrOfInputs, nbrOfHidden, 10};
+
+    std::vector<Eigen::MatrixXd> samples, lables;
+    createSamples( nbrOfInputs, 10, nbrOfSamples, samples, lables );
+    Network net( structure );
+
+    double srEuclidean, srMax, avgCost;
+    std::vector<size_t> failed;
+    for( auto _ : state )
+        benchmark::DoNotOptimize( net.testNetwork( samples, lables, 0.5, false, srEuclidean, srMax, avgCost, failed ) );
+
+    double nbrSamples = double(state.iterations()) * double(nbrOfSamples);
+    state.counters["samples/s"] = benchmark::Counter( nbrSamples, benchmark::Counter::kIsRate );
+    state.counters["GFLOP/s"] = benchmark::Counter( nbrSamples * 2.0 * nbrOfParameters(structure) * 1e-9, benchmark::Counter::kIsRate );
+}
+BENCHMARK(BM_TestNetwork)
+    ->ArgNames({"inputs", "hidden", "samples"})
+    ->Args({784, 30, 1000})->Args({784, 100, 1000})->Args({8, 4, 1000})
+    ->Unit(benchmark::kMillisecond);
+
+// Args: number of inputs, number of hidden neurons
+static void BM_NetworkSerialize(benchmark::State& state)
+{
+    Network net( {unsigned(state.range(0)), unsigned(state.range(1)), 10} );
+
+    size_t bytes = 0;
+    for( auto _ : state )
+    {
+        std::string buf = net.serialize();
+        bytes += buf.size();
+        benchmark::DoNotOptimize( buf.data() );
+    }
+
+    state.SetBytesProcessed( int64_t(bytes) );
+}
+BENCHMARK(BM_NetworkSerialize)
+    ->ArgNames({"inputs", "hidden"})
+    ->Args({8, 4})->Args({784, 30})->Args({784, 100});
+
+// Args: number of inputs, number of hidden neurons
+static void BM_NetworkDeserialize(benchmark::State& state)
+{
+    Network net( {unsigned(state.range(0)), unsigned(state.range(1)), 10} );
+    const std::string buf = net.serialize();
+
+    for( auto _ : state )
+    {
+        std::unique_ptr<Network> n( Network::deserialize( buf ) );
+        benchmark::DoNotOptimize( n.get() );
+    }
+
+    state.SetBytesProcessed( int64_t(state.iterations()) * int64_t(buf.size()) );
+}
+BENCHMARK(BM_NetworkDeserialize)
+    ->ArgNames({"inputs", "hidden"})
+    ->Args({8, 4})->Args({784, 30})->Args({784, 100});
@@ -25,10 +25,19 @@
 #define _EVOLUTION_H_
 
 #include "simulation.h"
+#include "executor.h"
+#include "selection.h"
+#include "evolutionStrategy.h"
+#include "statsRing.h"
 
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <random>
+#include <thread>
 
 /**
  * This class runs simulations and evolutions, and keeps track of the
@@ -39,12 +48,91 @@ class Evolution
 
 public:
 
+    /**
+     * Callback of the simulation thread, see start().
+     */
+    typedef std::function<void(const std::vector<SimulationPtr>&)> StepCallback;
+
+    /**
+     * When an epoch ends before all simulations died. The remaining
+     * simulations are killed, their fitness at that moment counts.
+     * A value of 0 disables the criterion.
+     */
+    struct EpochTermination
+    {
+        double maxSimulatedTime = 0.0;       // seconds, fixed-timestep mode only
+        double maxWallTime = 0.0;            // seconds
+        double deadFraction = 0.0;           // 0.0 - 1.0, ends if this fraction is dead and the leader converged
+        size_t convergenceSteps = 0;         // leader converged: no improvement within this number of steps
+        double convergenceTolerance = 0.0;   // relative leader improvement considered as none
+        size_t maxStepsPerSimulation = 0;    // each simulation is killed after this number of steps
+    };
+
+    /**
+     * Why the last epoch ended.
+     */
+    enum class EpochEnd
+    {
+        Running,        // no epoch ended yet
+        AllDead,
+        SimulatedTime,
+        WallTime,
+        Converged
+    };
+
+    /**
+     * Aggregates of one step, collected by the threads stepping the simulations.
+     * Fitness values are the cached fitness of all simulations stepped at
+     * least once in the current epoch.
+     */
+    struct StepStatistics
+    {
+        uint64_t step = 0;              // steps since the evolution was created, starting with 1
+        uint64_t epoch = 0;             // number of epochs over before this step
+        uint64_t alive = 0;
+        uint64_t dead = 0;
+        double simulatedTime = 0.0;     // of the epoch, seconds
+        double stepSeconds = 0.0;       // wall-clock time of the step
+        double averageAge = 0.0;        // of the alive simulations, seconds
+        double minFitness = 0.0;
+        double meanFitness = 0.0;
+        double maxFitness = 0.0;
+    };
+
+    /**
+     * Aggregates of a finished epoch.
+     */
+    struct EpochStatistics
+    {
+        static const size_t NumberOfPercentiles = 5;
+        static const size_t SurvivalPoints = 16;
+
+        /**
+         * Levels of the fitness percentiles: 10, 25, 50, 75 and 90 %.
+         */
+        static double percentileLevel( size_t k );
+
+        uint64_t epoch = 0;             // starting with 1
+        uint64_t steps = 0;
+        uint64_t simulations = 0;
+        EpochEnd end = EpochEnd::Running;
+        double simulatedTime = 0.0;     // seconds
+        double wallSeconds = 0.0;       // from the first to the last step
+        double breedSeconds = 0.0;      // breed() which created the generation, 0 for the first
+        double minFitness = 0.0;
+        double meanFitness = 0.0;
+        double maxFitness = 0.0;
+        double fitnessPercentiles[NumberOfPercentiles] = {};
+        double survival[SurvivalPoints] = {}; // fraction alive at evenly spaced steps, the last after the final step, not in steady state
+    };
+
     /**
      * Constructor
      * @param nInitial How many random initialized genoms (first epoch)
      * @param nNext How many offsprings generated among best genoms (further epochs)
      * @param simFactory Factory for simulations
-     * @param nThreads Number of threads used for computation
+     * @param nThreads Number of threads used for computation. The threads are kept
+     *                 in a pool for the lifetime of the evolution.
      */
     Evolution( size_t nInitial, size_t nNext, SimFactoryPtr simFactory, unsigned int nThreads = 4 );
 
@@ -61,10 +149,35 @@ public:
     void doEpoch();
 
     /**
-     * Create the next generation.
+     * Create the next generation. The parents of each offspring are
+     * chosen by the selection strategy, the offsprings are created in parallel.
+     * Simulations of the former generation, which are not referenced
+     * anywhere else anymore, are reused.
      */
     void breed();
 
+    /**
+     * Runs the evolution on its own thread: steps the simulations and breeds
+     * the next generation whenever an epoch is over, until stop() is called.
+     * Meanwhile, the other functions can still be called from other threads.
+     * @param afterStep Called on the simulation thread every callbackEvery steps
+     *                  with the simulations, while the evolution is locked. Use it
+     *                  to publish a snapshot, e.g. through a TripleBuffer.
+     * @param callbackEvery Number of steps between two calls.
+     */
+    void start( StepCallback afterStep = StepCallback(), size_t callbackEvery = 1 );
+
+    /**
+     * Stops the simulation thread after the current step and waits for it.
+     */
+    void stop();
+
+    /**
+     * Is the simulation thread running.
+     * @return True if running.
+     */
+    bool isRunning() const;
+
     /**
      * Checks if Epoch is over. Epoch ends when all simulations died.
      * @return
@@ -72,10 +185,52 @@ public:
     bool isEpochOver();
 
     /**
-     * Get vector of simulations ordered by fitness. Best first.
+     * Get vector of simulations ordered by fitness. Best first. The fitness
+     * cached at the last step is used, equal fitnesses keep their order.
+     * @param n Only the n best are ordered and returned.
      * @return Vector.
      */
-    std::vector<SimulationPtr> getSimulationsOrderedByFitness();
+    std::vector<SimulationPtr> getSimulationsOrderedByFitness( size_t n = std::numeric_limits<size_t>::max() );
+
+    /**
+     * The fittest simulations, tracked during each step without sorting
+     * the population. Best first.
+     * @return The getTopK() fittest simulations, fewer if the population is smaller.
+     */
+    std::vector<SimulationPtr> getFittest();
+
+    /**
+     * Number of fittest simulations tracked during each step.
+     */
+    size_t getTopK() const;
+
+    /**
+     * Set the number of fittest simulations tracked during each step.
+     * @param k At least 2, the two fittest are the parents of the next generation.
+     */
+    void setTopK( size_t k );
+
+    /**
+     * Set how breed() chooses the parents of each offspring. Default
+     * is TopTwoSelection, all offsprings of the two fittest.
+     * @param selection Selection strategy.
+     */
+    void setSelection( std::shared_ptr<Selection> selection );
+    std::shared_ptr<Selection> getSelection() const;
+
+    /**
+     * Breed with an evolution strategy instead of crossover: the strategy
+     * adapts to the parameters and fitness of the offsprings it sampled for
+     * the finished epoch and the next offsprings are sampled from it. The
+     * initial population, elites and immigrants do not update it. The
+     * selection strategy is not used.
+     * @param strategy Strategy over Genetic::getParameterVector() of the
+     *        networks. NULL -> crossover (default).
+     * @return False if the dimension does not match the networks or there are
+     *         less than two offsprings, the former strategy is kept. Otherwise true.
+     */
+    bool setEvolutionStrategy( std::shared_ptr<EvolutionStrategy> strategy );
+    std::shared_ptr<EvolutionStrategy> getEvolutionStrategy() const;
 
     /**
      * Get number of run epochs.
@@ -84,7 +239,8 @@ public:
     size_t getNumberOfEpochs() const;
 
     /**
-     * Get the nubmer of alive and dead simulations.
+     * Get the nubmer of alive and dead simulations. Traverses the
+     * population, see getStepStatistics() for monitoring.
      */
     std::pair<size_t, size_t> getNumberAliveAndDead( ) const;
 
@@ -94,6 +250,23 @@ public:
      */
     double getSimulationsAverageAge() const;
 
+    /**
+     * Statistics of the latest steps. Lock-free, reading them neither
+     * traverses the population nor waits for a running step, so they
+     * are meant for monitoring. The last 1024 steps are kept.
+     * @param n At most n steps.
+     * @return Statistics, oldest first.
+     */
+    std::vector<StepStatistics> getStepStatistics( size_t n = std::numeric_limits<size_t>::max() ) const;
+
+    /**
+     * Statistics of the latest finished epochs, lock-free as getStepStatistics().
+     * The last 256 epochs are kept. Steady state has no epochs.
+     * @param n At most n epochs.
+     * @return Statistics, oldest first.
+     */
+    std::vector<EpochStatistics> getEpochStatistics( size_t n = std::numeric_limits<size_t>::max() ) const;
+
     /**
      * Get mutation rate.
      * @return Mutation rate (0.0 - 1.0)
@@ -114,10 +287,24 @@ public:
 
     /**
      * If true, parents are part of the next epoch.
+     * Same as setElitism(2) or setElitism(0).
      * @param keepParents True -> parents are part of next epoch. Otherwise false.
      */
     void setKeepParents(bool keepParents);
 
+    /**
+     * Get the number of fittest simulations copied unchanged to the next epoch.
+     * @return Number of elites.
+     */
+    size_t getElitism() const;
+
+    /**
+     * Set the number of fittest simulations copied unchanged to the next epoch,
+     * in addition to the offsprings. Default 2.
+     * @param n Number of elites, 0 -> none.
+     */
+    void setElitism(size_t n);
+
     /**
      * Kill all simulations.
      */
@@ -129,6 +316,98 @@ public:
      */
     double getSimulationStepsPerSecond() const;
 
+    /**
+     * Enables the fixed-timestep mode: every step advances all simulations
+     * by the given simulated time instead of the elapsed wall-clock time.
+     * Steps are then computed as fast as possible. Together with a seeded
+     * random generator (Helpers::seedRandomGenerator) on the thread creating
+     * and breeding the evolution, runs are reproducible.
+     * @param dt Step duration in seconds. 0 -> real-time mode (default).
+     */
+    void setFixedTimeStep( double dt );
+
+    /**
+     * Fixed step duration.
+     * @return Seconds. 0 in real-time mode.
+     */
+    double getFixedTimeStep() const;
+
+    /**
+     * Simulated time of the current epoch. Only advanced in fixed-timestep mode.
+     * @return Seconds.
+     */
+    double getEpochSimulatedTime() const;
+
+    /**
+     * Set when an epoch is cut off before all simulations died.
+     * maxStepsPerSimulation also applies in steady-state mode.
+     * @param termination Criteria, all disabled by default.
+     */
+    void setEpochTermination( const EpochTermination& termination );
+    EpochTermination getEpochTermination() const;
+
+    /**
+     * Why the last epoch ended.
+     * @return Criterion which ended the last epoch.
+     */
+    EpochEnd getLastEpochEnd() const;
+
+    /**
+     * Enables the steady-state mode: there are no generations. After each
+     * step, every dead simulation enters the elite archive if it is fit
+     * enough, and is replaced right away by an offspring of two parents
+     * chosen by tournaments over the archive. Epochs never end in this mode.
+     * @param steadyState True -> steady state. False -> generational (default).
+     */
+    void setSteadyState( bool steadyState );
+
+    /**
+     * Is the steady-state mode enabled.
+     * @return True if steady state.
+     */
+    bool isSteadyState() const;
+
+    /**
+     * Maximum number of simulations in the elite archive of the steady-state mode.
+     * @param size At least 2.
+     */
+    void setArchiveSize( size_t size );
+    size_t getArchiveSize() const;
+
+    /**
+     * Number of archive members competing for being a parent.
+     * @param size At least 1. 1 -> random parents.
+     */
+    void setTournamentSize( size_t size );
+    size_t getTournamentSize() const;
+
+    /**
+     * Dead simulations in the elite archive.
+     * @return Archive, best first.
+     */
+    std::vector<SimulationPtr> getArchive();
+
+    /**
+     * Number of dead simulations replaced in steady-state mode.
+     * @return Number of replacements since creation.
+     */
+    size_t getNumberOfReplacements() const;
+
+    /**
+     * Get the number of simulations replaced in 1 second, steady-state mode.
+     * @return Replacement rate.
+     */
+    double getReplacementsPerSecond() const;
+
+    /**
+     * Simulations older than this are killed after the step. Otherwise
+     * simulations which never die, e.g. cars driving laps, would block
+     * their place in the steady-state mode.
+     * @param age Simulated seconds. 0 -> unlimited (default).
+     */
+    void setMaxSimulationAge( double age );
+    double getMaxSimulationAge() const;
+
     /**
      * Set a new factory object.
      * @param simFactory Factory.
@@ -150,9 +429,72 @@ public:
      */
     bool load( const std::string& a_path, const std::string& b_path );
 
+    /**
+     * Writes the whole population into one file: the genomes in one
+     * contiguous block, their fitness, the archive, the settings, the
+     * epoch counter and the random generator state of the calling thread.
+     * Taken after an epoch (before breed), loadCheckpoint() continues the
+     * run exactly. Within an epoch the running epoch restarts.
+     * @param path File path.
+     * @return True if successful. Otherwise false.
+     */
+    bool saveCheckpoint( const std::string& path );
+
+    /**
+     * Like saveCheckpoint(), but only the snapshot of the population is
+     * taken now, the file is written by a background thread. A pending
+     * checkpoint is completed first.
+     * @param path File path.
+     * @return False if the pending checkpoint could not be written. Otherwise true.
+     */
+    bool saveCheckpointAsync( const std::string& path );
+
+    /**
+     * Waits for the pending checkpoint of saveCheckpointAsync().
+     * @return True if it was written or none was pending. Otherwise false.
+     */
+    bool waitForCheckpoint();
+
+    /**
+     * Replaces population, settings and the random generator state of the
+     * calling thread by a checkpoint. The file is memory mapped, its genomes
+     * are deserialized in parallel. The state of an evolution strategy is
+     * not part of the checkpoint.
+     * @param path File path.
+     * @return True if successful. Otherwise false, nothing is changed.
+     */
+    bool loadCheckpoint( const std::string& path );
+
+    /**
+     * Adds simulations of networks evolved elsewhere, e.g. migrants of
+     * another island, to the current epoch. Generational mode only.
+     * @param networks Networks of the new simulations.
+     */
+    void immigrate( const std::vector<NetworkPtr>& networks );
+
 private:
     std::chrono::milliseconds now() const;
-    static void doStepOnFewSimulations( std::vector<SimulationPtr>& sims, std::atomic_bool& anyAlive, size_t start, size_t end );
+    std::unique_lock<std::mutex> lock();
+    void run( StepCallback afterStep, size_t callbackEvery );
+    bool isFitter( size_t a, size_t b ) const;
+    void updateFitness( size_t start, size_t end, const char* stepped, std::vector<size_t>& top );
+    void selectTop( std::vector<size_t>& candidates );
+    void selectFittest( size_t n, std::vector<size_t>& indices ) const;
+    std::vector<SimulationPtr> getElites() const;
+    void selectTopOfAll();
+    void resetFitness();
+    void replaceDead();
+    void breedFromStrategy();
+    EpochEnd checkTermination( size_t nbrAlive );
+    void cutOffEpoch();
+    void startEpoch();
+    void recordEpoch();
+    void addToArchive( double fitness, const SimulationPtr& sim );
+    SimulationPtr tournament( std::mt19937& gen ) const;
+
+    struct Checkpoint;
+    std::shared_ptr<Checkpoint> takeCheckpoint();
+    static bool writeCheckpoint( const Checkpoint& checkpoint, const std::string& path );
 
 
 private:
@@ -167,9 +509,52 @@ private:
     std::chrono::milliseconds m_simSpeedTime;
     double m_simSpeed;
     unsigned int m_nbrThreads;
-    bool m_keepParents;
+    std::unique_ptr<Executor> m_executor;
+    double m_fixedTimeStep;
+    double m_epochSimulatedTime;
+    size_t m_elitism; // fittest copied unchanged to the next epoch
     SimulationPtr m_fittest;
+    double m_fittestFitness; // cached, loaded simulations do not know it
+    std::vector<double> m_fitness; // cached per simulation
+    std::vector<size_t> m_top;     // indices of the fittest, best first
+    size_t m_topK;
+    std::shared_ptr<Selection> m_selection;
+    std::shared_ptr<EvolutionStrategy> m_strategy;
+    size_t m_nbrSampled; // offsprings of the strategy at the front of the simulations
+
+    struct ArchiveEntry
+    {
+        double fitness;
+        SimulationPtr simulation;
+    };
+    bool m_steadyState;
+    std::vector<ArchiveEntry> m_archive; // best first
+    size_t m_archiveSize;
+    size_t m_tournamentSize;
+    size_t m_replacementCount;
+    size_t m_replacementCounter;
+    double m_replacementSpeed;
+    double m_maxSimulationAge;
+
+    EpochTermination m_termination;
+    EpochEnd m_lastEpochEnd;
+    size_t m_epochSteps;
+    std::chrono::steady_clock::time_point m_epochWallStart;
+    double m_leaderFitness;
+    size_t m_leaderImprovedStep;
+
     std::mutex m_mutex;
+    std::thread m_thread;
+    std::atomic_bool m_running;
+
+    StatsRing<StepStatistics> m_stepStatistics;
+    StatsRing<EpochStatistics> m_epochStatistics;
+    std::vector<uint32_t> m_survival;  // alive per step of the epoch
+    std::vector<double> m_fitnessBuffer;
+    double m_breedSeconds;
+
+    std::thread m_checkpointThread;
+    bool m_checkpointWritten;
 };
 
 
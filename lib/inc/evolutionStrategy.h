@@ -0,0 +1,108 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef EVOLUTIONSTRATEGYHEADER
+#define EVOLUTIONSTRATEGYHEADER
+
+#include <Eigen/Dense>
+#include <random>
+#include <vector>
+
+/**
+ * Covariance matrix adaptation evolution strategy (CMA-ES) over a real
+ * parameter vector, e.g. the flattened weights and biases of a network
+ * (Genetic::getParameterVector). Candidates are sampled around a mean,
+ * the mean, the step size and the covariance follow the fittest
+ * candidates. Fitness is maximized.
+ */
+class EvolutionStrategy
+{
+public:
+    enum Covariance
+    {
+        Full,       // full covariance matrix, O(n^2) memory and O(n^2) per sample
+        Diagonal    // separable CMA-ES, for large parameter vectors
+    };
+
+    /**
+     * @param mean Initial mean.
+     * @param sigma Initial step size. Mean 0 and sigma 1 matches the random initialization of Network.
+     * @param covariance Covariance model.
+     */
+    EvolutionStrategy( const Eigen::VectorXd& mean, double sigma = 1.0, Covariance covariance = Full );
+
+    /**
+     * Draws a candidate. Thread safe, as long as update() does not run.
+     * @param x Candidate of getDimension() values.
+     * @param gen Random generator of the calling thread.
+     */
+    void sample( Eigen::VectorXd& x, std::mt19937& gen ) const;
+
+    /**
+     * Adapts the distribution to the evaluated candidates. The better
+     * half of them moves the mean.
+     * @param candidates Evaluated candidates, at least 2.
+     * @param fitness Fitness of each candidate.
+     * @return True if successful.
+     */
+    bool update( const std::vector<Eigen::VectorXd>& candidates, const std::vector<double>& fitness );
+
+    const Eigen::VectorXd& getMean() const;
+    double getSigma() const;
+    size_t getDimension() const;
+    Covariance getCovariance() const;
+
+    /**
+     * Number of update() calls.
+     */
+    size_t getNumberOfGenerations() const;
+
+    /**
+     * The variance of each parameter, the diagonal of sigma^2 * C.
+     */
+    Eigen::VectorXd getVariances() const;
+
+private:
+    void decompose();
+
+private:
+    Covariance m_covariance;
+    size_t m_n;
+    Eigen::VectorXd m_mean;
+    double m_sigma;
+
+    Eigen::VectorXd m_pathSigma;   // evolution path of the step size
+    Eigen::VectorXd m_pathC;       // evolution path of the covariance
+
+    Eigen::MatrixXd m_C;           // full covariance
+    Eigen::MatrixXd m_B;           // eigenvectors of m_C
+    Eigen::VectorXd m_D;           // sqrt of the eigenvalues of m_C
+    Eigen::MatrixXd m_BD;          // m_B * diag(m_D), maps samples
+    Eigen::VectorXd m_diagC;       // diagonal covariance
+
+    size_t m_generation;
+    size_t m_evaluations;
+    size_t m_decomposedAt;         // evaluations at the last eigendecomposition
+};
+
+#endif // EVOLUTIONSTRATEGYHEADER
@@ -0,0 +1,90 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef EXECUTORHEADER
+#define EXECUTORHEADER
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed size thread pool. Tasks are executed in the order they were posted,
+ * but tasks may run concurrently on different worker threads.
+ */
+class Executor
+{
+public:
+
+    /**
+     * Constructor. Starts the worker threads.
+     * @param nbrOfThreads Number of worker threads. 0 uses the number of hardware threads.
+     */
+    explicit Executor( size_t nbrOfThreads = 0 );
+
+    /**
+     * Executes the remaining tasks and joins all worker threads.
+     */
+    ~Executor();
+
+    Executor( const Executor& ) = delete;
+    Executor& operator=( const Executor& ) = delete;
+
+    /**
+     * Queues a task for execution on one of the worker threads.
+     * @param task Task.
+     */
+    void post( std::function<void()> task );
+
+    /**
+     * Splits the range [0, n) into chunks and executes them on the worker threads
+     * and on the calling thread. Blocks until all chunks are done.
+     * @param n Number of elements.
+     * @param body Function processing the elements [begin, end).
+     */
+    void parallelFor( size_t n, const std::function<void(size_t begin, size_t end)>& body );
+
+    size_t getNumberOfThreads() const { return m_threads.size(); }
+
+    /**
+     * Executor shared by all networks.
+     * @return Global executor.
+     */
+    static Executor& global();
+
+private:
+    void run();
+
+private:
+    std::vector<std::thread> m_threads;
+    std::deque< std::function<void()> > m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
+
+#endif // EXECUTORHEADER
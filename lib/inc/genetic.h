@@ -44,6 +44,35 @@ public:
 
     static NetworkPtr crossover( NetworkPtr a, NetworkPtr b, CrossoverMethod method, double mutationRate = 0.0 );
 
+    /**
+     * Writes the crossover of a and b into the weights and biases of an existing
+     * network. Nothing is allocated if the parameters of target are not shared.
+     * @param target Network with the same structure as a and b.
+     * @return True if successful.
+     */
+    static bool crossoverInto( NetworkPtr target, NetworkPtr a, NetworkPtr b, CrossoverMethod method, double mutationRate = 0.0 );
+
+    /**
+     * Number of weights and biases of a network.
+     */
+    static size_t getNumberOfParameters( const NetworkPtr& net );
+
+    /**
+     * All weights and biases of a network in one vector, layer by layer:
+     * the weight matrix (column major), then the bias vector.
+     * @param net Network
+     * @return Parameter vector.
+     */
+    static Eigen::VectorXd getParameterVector( const NetworkPtr& net );
+
+    /**
+     * Writes a parameter vector, see getParameterVector(), into a network.
+     * @param net Network
+     * @param params Vector of getNumberOfParameters() values.
+     * @return True if successful.
+     */
+    static bool setParameterVector( NetworkPtr net, const Eigen::VectorXd& params );
+
 };
 
 
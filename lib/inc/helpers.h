@@ -27,6 +27,7 @@
 #include <string>
 #include <Eigen/Dense>
 #include <vector>
+#include <random>
 
 using namespace std;
 
@@ -39,6 +40,21 @@ public:
     static void maxElement( const Eigen::MatrixXd& mat, unsigned long& m_idx, unsigned long& n_idx, double& maxVal);
 
     static Eigen::MatrixXd mean( const std::vector<Eigen::MatrixXd>& input );
+
+    /**
+     * Random generator of the calling thread. It is seeded randomly,
+     * unless seedRandomGenerator was called on this thread.
+     * @return Generator
+     */
+    static std::mt19937& randomGenerator();
+
+    /**
+     * Seeds the random generator of the calling thread. All following
+     * random initializations, crossovers and shuffles on this thread are
+     * reproducible.
+     * @param seed Seed
+     */
+    static void seedRandomGenerator( unsigned int seed );
 };
 
 #endif //HELPERSHEADER
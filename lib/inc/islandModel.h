@@ -0,0 +1,163 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef ISLANDMODELHEADER
+#define ISLANDMODELHEADER
+
+#include "evolution.h"
+#include "migration.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * One island of an island model: an evolution which periodically
+ * exchanges its best genomes with other islands. The islands may run
+ * as threads of one process or as separate processes, depending on
+ * the migration channel. Generational mode only.
+ */
+class Island
+{
+public:
+    /**
+     * @param id Index of this island.
+     * @param nbrOfIslands Number of islands.
+     * @param evolution Evolution of this island.
+     * @param topology Where the genomes migrate.
+     * @param channel Connection to the other islands.
+     */
+    Island( size_t id, size_t nbrOfIslands, std::shared_ptr<Evolution> evolution,
+            std::shared_ptr<MigrationTopology> topology, std::shared_ptr<MigrationChannel> channel );
+
+    /**
+     * Runs the evolution and migrates after every migration interval.
+     * The islands of a model must run the same number of epochs.
+     * @param epochs Number of epochs, the last one is not bred.
+     * @return True if successful. Otherwise false, e.g. migrants missed.
+     */
+    bool run( size_t epochs );
+
+    /**
+     * Ends the current epoch: selects the emigrants, breeds and
+     * exchanges the emigrants with the other islands.
+     * @return True if the migrants of all source islands arrived.
+     */
+    bool breedAndMigrate();
+
+    /**
+     * Number of epochs between two migrations. 0 -> no migration. Default 5.
+     */
+    void setMigrationInterval( size_t epochs );
+    size_t getMigrationInterval() const;
+
+    /**
+     * Number of best genomes sent to each target island. Default 2.
+     */
+    void setNumberOfMigrants( size_t n );
+    size_t getNumberOfMigrants() const;
+
+    /**
+     * Seconds to wait for the migrants of the other islands. Default 60.
+     */
+    void setMigrationTimeout( double seconds );
+    double getMigrationTimeout() const;
+
+    /**
+     * Number of simulations received from other islands so far.
+     */
+    size_t getNumberOfImmigrants() const;
+
+    size_t getId() const;
+    const std::shared_ptr<Evolution>& getEvolution() const;
+
+private:
+    size_t m_id;
+    size_t m_nbrOfIslands;
+    std::shared_ptr<Evolution> m_evolution;
+    std::shared_ptr<MigrationTopology> m_topology;
+    std::shared_ptr<MigrationChannel> m_channel;
+
+    size_t m_migrationInterval;
+    size_t m_nbrOfMigrants;
+    double m_migrationTimeout;
+    uint32_t m_round;
+    size_t m_nbrOfImmigrants;
+};
+
+/**
+ * Runs several islands as threads of this process.
+ */
+class IslandModel
+{
+public:
+    /**
+     * Creates the evolution of an island. Called on the thread of the island.
+     */
+    typedef std::function<std::shared_ptr<Evolution>(size_t island)> EvolutionCreator;
+
+    /**
+     * @param nbrOfIslands Number of islands.
+     * @param creator Creates the evolution of each island.
+     * @param topology Where the genomes migrate.
+     */
+    IslandModel( size_t nbrOfIslands, EvolutionCreator creator, std::shared_ptr<MigrationTopology> topology );
+
+    /**
+     * Settings applied to all islands, see Island.
+     */
+    void setMigrationInterval( size_t epochs );
+    void setNumberOfMigrants( size_t n );
+    void setMigrationTimeout( double seconds );
+
+    /**
+     * Runs all islands until each finished the number of epochs.
+     * @param epochs Number of epochs per island.
+     * @return True if all islands were successful. Otherwise false.
+     */
+    bool run( size_t epochs );
+
+    /**
+     * Islands of the last run.
+     */
+    const std::vector<std::shared_ptr<Island>>& getIslands() const;
+
+    /**
+     * Fittest simulation of all islands of the last run.
+     * @return Fittest simulation or NULL.
+     */
+    SimulationPtr getFittest() const;
+
+private:
+    size_t m_nbrOfIslands;
+    EvolutionCreator m_creator;
+    std::shared_ptr<MigrationTopology> m_topology;
+
+    size_t m_migrationInterval;
+    size_t m_nbrOfMigrants;
+    double m_migrationTimeout;
+
+    std::vector<std::shared_ptr<Island>> m_islands;
+};
+
+#endif // ISLANDMODELHEADER
@@ -28,12 +28,24 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <atomic>
 #include <Eigen/Dense>
 
 #include "regularization.h"
+#include "networkStats.h"
 
 class CostFunction;
 
+/**
+ * Weights and biases of a layer. Copies of a layer share this storage
+ * until one of them is modified (copy-on-write).
+ */
+struct LayerParameters
+{
+    Eigen::MatrixXd weights;
+    Eigen::MatrixXd biases;
+};
+
 class Layer
 {
     friend class Network;
@@ -52,8 +64,9 @@ public:
      * @param nbr_of_neurons Number of neurons in this layer.
      * @param nbr_of_inputs Number of inputs to each neuron (usually this number is equal to the amount of neurons in the previous layer)
      * @param type The layer type
+     * @param randomInit If false, weights and biases are allocated but not initialized.
      */
-    Layer( const uint& nbr_of_neurons, const uint& nbr_of_inputs, const LayerOutputType& type = Sigmoid );
+    Layer( const uint& nbr_of_neurons, const uint& nbr_of_inputs, const LayerOutputType& type = Sigmoid, const bool& randomInit = true );
 
     /**
      * Constructor of a layer.
@@ -65,7 +78,8 @@ public:
     Layer( const uint& nbr_of_inputs, const std::vector<Eigen::VectorXd>& weights, const std::vector<double>& biases, const LayerOutputType& type = Sigmoid );
 
     /**
-     * Copy-constructor
+     * Copy-constructor. Weights and biases are shared with l
+     * until one of the layers modifies them.
      * @param l
      */
     Layer( const Layer& l );
@@ -82,6 +96,14 @@ public:
      */
     bool feedForward( const Eigen::MatrixXd& x_in );
 
+    /**
+     * Computes the activation of a weighted input.
+     * @param z Weighted input, one column per sample.
+     * @param type The layer type.
+     * @param a_out Activation output.
+     */
+    static void activation( const Eigen::MatrixXd& z, const LayerOutputType& type, Eigen::MatrixXd& a_out );
+
     /**
      * Sets the weights-vector in each neuron of this layer.
      * @param weights Vector of neuron weights-vector.
@@ -107,7 +129,7 @@ public:
      * ( see updateWeightMatrixAndBiasVector() )
      * @return
      */
-    const Eigen::MatrixXd& getWeightMatrix() const { return m_weightMatrix; }
+    const Eigen::MatrixXd& getWeightMatrix() const { return m_params->weights; }
 
     /**
      * Sets the bias of each neuron in this layer.
@@ -134,7 +156,30 @@ public:
      * ( see updateWeightMatrixAndBiasVector() )
      * @return
      */
-    const Eigen::MatrixXd& getBiasVector() const { return m_biasVector; }
+    const Eigen::MatrixXd& getBiasVector() const { return m_params->biases; }
+
+    /**
+     * Returns the shared weights and biases. They do not change anymore,
+     * a later modification of this layer writes to a new copy.
+     * @return Parameters.
+     */
+    std::shared_ptr<const LayerParameters> getParameters() const { return m_params; }
+
+    /**
+     * Returns writable weights and biases. If they are shared with another layer or a
+     * snapshot, they are copied first or, if keepValues is false, newly allocated
+     * without initialization. The dimensions must not be changed.
+     * @param keepValues False if all values get overwritten anyway.
+     * @return Parameters owned by this layer.
+     */
+    LayerParameters& getMutableParameters( const bool& keepValues = true );
+
+    /**
+     * Replaces weights and biases by shared ones. Nothing is copied.
+     * @param params Parameters matching the layer dimensions.
+     * @return true if successful
+     */
+    bool setParameters( const std::shared_ptr<const LayerParameters>& params );
 
     /**
      * Resets all weights and biases of each neuron in this layer
@@ -263,9 +308,10 @@ public:
     std::string serialize() const;
 
     /**
-     * Deserialize a binary representation of a layer.
+     * Deserialize a binary representation of a layer. The sizes are
+     * checked against the buffer length.
      * @param buffer Binaray data.
-     * @return Initialized layer
+     * @return Initialized layer, NULL if the buffer is short or corrupt.
      */
     static Layer* deserialize(const std::string& buffer );
 
@@ -281,13 +327,32 @@ public:
      */
     std::shared_ptr<Regularization> getRegularizationMethod() const;
 
+    /**
+     * Enables or disables the timing instrumentation of this layer. This
+     * has only an effect if the library was compiled with EIDNN_STATS.
+     * @param enable True to enable.
+     */
+    void setStatsEnabled( bool enable ) { m_statsEnabled = enable; }
+    bool isStatsEnabled() const { return m_statsEnabled; }
+
+    /**
+     * Returns the accumulated timings of the layer phases.
+     * @return Snapshot of the layer stats.
+     */
+    LayerStats getStats() const;
+
+    /**
+     * Sets all timings and counters to zero.
+     */
+    void resetStats();
+
     unsigned int getNbrOfNeurons() const { return m_nbr_of_neurons; }
     unsigned int getNbrOfNeuronInputs() const { return m_nbr_of_inputs; }
 
     void print() const;
 
 private:
-    void initLayer();
+    void initLayer( const bool& randomInit );
 
     /**
      * Sets directly the activation output of this layer.
@@ -310,8 +375,7 @@ private:
 
     Eigen::MatrixXd m_backpropagationError;
     double m_outputLayerCost;
-    Eigen::MatrixXd m_weightMatrix;
-    Eigen::MatrixXd m_biasVector;
+    std::shared_ptr<const LayerParameters> m_params;
 
     std::vector<Eigen::MatrixXd> m_bias_partialDerivatives;
     std::vector<Eigen::MatrixXd> m_weight_partialDerivatives;
@@ -319,6 +383,9 @@ private:
     std::shared_ptr<CostFunction> m_costFunction;
 
     std::shared_ptr<Regularization> m_regularization;
+
+    std::atomic<bool> m_statsEnabled{false};
+    PhaseCounter m_stats[LayerStats::NumberOfPhases];
 };
 
 #endif //LAYERHEADER
@@ -0,0 +1,201 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MIGRATIONHEADER
+#define MIGRATIONHEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Genomes sent from one island to another. The genomes are
+ * networks in the format of Network::serialize().
+ */
+struct MigrationMessage
+{
+    uint32_t round = 0;
+    uint32_t source = 0;
+    std::vector<std::string> genomes;
+};
+
+/**
+ * Defines to which islands the genomes of an island migrate.
+ */
+class MigrationTopology
+{
+public:
+    virtual ~MigrationTopology();
+
+    /**
+     * Islands receiving the genomes of an island.
+     * @param island Index of the sending island.
+     * @param nbrOfIslands Number of islands.
+     * @return Indices of the receiving islands.
+     */
+    virtual std::vector<size_t> getTargets( size_t island, size_t nbrOfIslands ) const = 0;
+
+    /**
+     * Islands sending their genomes to an island.
+     * @param island Index of the receiving island.
+     * @param nbrOfIslands Number of islands.
+     * @return Indices of the sending islands.
+     */
+    std::vector<size_t> getSources( size_t island, size_t nbrOfIslands ) const;
+};
+
+/**
+ * Each island sends to the next one, the last one to the first one.
+ */
+class RingTopology: public MigrationTopology
+{
+public:
+    std::vector<size_t> getTargets( size_t island, size_t nbrOfIslands ) const override;
+};
+
+/**
+ * Each island sends to all other islands.
+ */
+class FullyConnectedTopology: public MigrationTopology
+{
+public:
+    std::vector<size_t> getTargets( size_t island, size_t nbrOfIslands ) const override;
+};
+
+/**
+ * Transports migration messages between islands. Received messages are
+ * kept in an inbox until they are taken with receive().
+ */
+class MigrationChannel
+{
+public:
+    virtual ~MigrationChannel();
+
+    /**
+     * Sends a message to another island.
+     * @param target Index of the receiving island.
+     * @param message Message
+     * @return True if delivered. Otherwise false.
+     */
+    virtual bool send( size_t target, const MigrationMessage& message ) = 0;
+
+    /**
+     * Waits for the messages of a migration round.
+     * @param round Migration round.
+     * @param nbrOfMessages Number of expected messages, one per source island.
+     * @param messages Received messages, ordered by source island.
+     * @param timeout Seconds to wait at most.
+     * @return True if all expected messages arrived. Otherwise false, messages
+     *         contains the ones that arrived.
+     */
+    bool receive( uint32_t round, size_t nbrOfMessages, std::vector<MigrationMessage>& messages, double timeout );
+
+protected:
+    /**
+     * Puts a message into the inbox. Thread safe.
+     */
+    void deliver( MigrationMessage&& message );
+
+private:
+    std::mutex m_inboxMutex;
+    std::condition_variable m_arrived;
+    std::vector<MigrationMessage> m_inbox;
+};
+
+/**
+ * Channel between islands of the same process.
+ */
+class LocalMigrationChannel: public MigrationChannel
+{
+public:
+    /**
+     * Creates connected channels, one per island.
+     * @param nbrOfIslands Number of islands.
+     * @return Channel of each island.
+     */
+    static std::vector<std::shared_ptr<LocalMigrationChannel>> createGroup( size_t nbrOfIslands );
+
+    bool send( size_t target, const MigrationMessage& message ) override;
+
+private:
+    std::shared_ptr<std::vector<std::weak_ptr<LocalMigrationChannel>>> m_group;
+};
+
+/**
+ * Channel between islands of different local processes, over Unix
+ * domain sockets. Each island listens on its own socket file in a
+ * directory shared by all islands.
+ */
+class SocketMigrationChannel: public MigrationChannel
+{
+public:
+    /**
+     * Starts listening.
+     * @param dir Directory of the socket files, must exist.
+     * @param island Index of this island.
+     * @param connectTimeout Seconds to wait in send() for the target island to listen.
+     */
+    SocketMigrationChannel( const std::string& dir, size_t island, double connectTimeout = 30.0 );
+
+    /**
+     * Stops listening and removes the socket file.
+     */
+    ~SocketMigrationChannel() override;
+
+    /**
+     * Is the socket of this island listening.
+     * @return True if listening. Otherwise, the socket could not be created.
+     */
+    bool isListening() const;
+
+    bool send( size_t target, const MigrationMessage& message ) override;
+
+    /**
+     * Path of the socket file of an island.
+     */
+    static std::string socketPath( const std::string& dir, size_t island );
+
+    /**
+     * Binary representation of a message on the socket.
+     */
+    static std::string encode( const MigrationMessage& message );
+    static bool decode( const std::string& buffer, MigrationMessage& message );
+
+private:
+    void listen();
+
+private:
+    std::string m_dir;
+    std::string m_path;
+    double m_connectTimeout;
+    int m_socket;
+    std::atomic_bool m_stop;
+    std::thread m_listener;
+};
+
+#endif // MIGRATIONHEADER
@@ -0,0 +1,130 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef MULTISIMULATIONHEADER
+#define MULTISIMULATIONHEADER
+
+#include "simulation.h"
+
+#include <vector>
+
+/**
+ * Evaluates one genome in several simulations at once, e.g. a car
+ * controller on several tracks. Each child simulation has its own
+ * network object, all share the weights of the genome. The genome is
+ * the network of the first child.
+ */
+class MultiSimulation: public Simulation
+{
+public:
+    enum Aggregation
+    {
+        Mean,   // average fitness of the children
+        Min     // fitness of the worst child, rewards robust genomes
+    };
+
+    /**
+     * @param children Simulations of the same genome, at least one.
+     * @param aggregation How the fitness of the children is combined.
+     */
+    MultiSimulation( const std::vector<SimulationPtr>& children, Aggregation aggregation = Mean );
+
+    double getFitness() override;
+
+    /**
+     * Sets the genome: the first child gets the network, the others
+     * copies sharing its weights.
+     */
+    void setNetwork( const std::shared_ptr<Network>& network ) override;
+
+    void kill() override;
+    void reset() override;
+
+    const std::vector<SimulationPtr>& getChildren() const;
+
+    /**
+     * Replaces the children and resets the own state, without resetting
+     * the children. Used when a factory recycles this simulation.
+     */
+    void setChildren( const std::vector<SimulationPtr>& children );
+
+    /**
+     * Completes a step whose children were stepped by their factories.
+     * @param dt Step duration in seconds.
+     */
+    void finishStep( double dt );
+
+    Aggregation getAggregation() const;
+
+protected:
+    void update() override;
+
+private:
+    bool anyChildAlive() const;
+
+private:
+    std::vector<SimulationPtr> m_children;
+    Aggregation m_aggregation;
+};
+
+/**
+ * Creates multi simulations, one child per factory. Breeding happens
+ * in the first factory, the other factories get the parameters of the
+ * resulting genome. The children are stepped by their own factories,
+ * so batched stepping (e.g. CarFactory) keeps working.
+ */
+class MultiSimulationFactory: public SimulationFactory
+{
+public:
+    /**
+     * @param factories One factory per child, at least one.
+     * @param aggregation How the fitness of the children is combined.
+     */
+    MultiSimulationFactory( const std::vector<SimFactoryPtr>& factories, MultiSimulation::Aggregation aggregation = MultiSimulation::Mean );
+
+    SimulationPtr createRandomSimulation() override;
+    SimulationPtr createSimulation( NetworkPtr network ) override;
+    SimulationPtr createCrossover( SimulationPtr a, SimulationPtr b, double mutationRate ) override;
+    SimulationPtr recycleCrossover( SimulationPtr recycled, SimulationPtr a, SimulationPtr b, double mutationRate ) override;
+    SimulationPtr recycleWithParameters( SimulationPtr recycled, SimulationPtr prototype, const Eigen::VectorXd& parameters ) override;
+    SimulationPtr copy( SimulationPtr a ) override;
+
+    /**
+     * Steps the children of all alive multi simulations in the range,
+     * grouped by factory.
+     */
+    bool doSteps( const std::vector<SimulationPtr>& sims, size_t start, size_t end, double dt ) override;
+
+    const std::vector<SimFactoryPtr>& getFactories() const;
+
+private:
+    std::shared_ptr<MultiSimulation> asMulti( const SimulationPtr& sim ) const;
+    SimulationPtr first( const SimulationPtr& sim ) const;
+    SimulationPtr assemble( SimulationPtr first, const std::shared_ptr<MultiSimulation>& recycled ) const;
+
+private:
+    std::vector<SimFactoryPtr> m_factories;
+    MultiSimulation::Aggregation m_aggregation;
+};
+
+#endif // MULTISIMULATIONHEADER
@@ -26,11 +26,17 @@
 
 #include <vector>
 #include <memory>
-#include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <Eigen/Dense>
 
 #include "network_cb.h"
+#include "networkStats.h"
+#include "networkEventChannel.h"
+#include "networkJob.h"
+#include "networkSnapshot.h"
 #include "regularization.h"
 
 
@@ -56,11 +62,21 @@ public:
      *                         where the first element of the vector is the number of
      *                         neurons in the first layer, and the last vector item the
      *                         number of neurons in the last layer, the output layer.
+     * @param randomInit If false, weights and biases are allocated but not initialized.
+     *                   Use this if they get overwritten anyway.
      */
-    Network( const std::vector<unsigned int> networkStructure );
+    Network( const std::vector<unsigned int> networkStructure, const bool& randomInit = true );
 
     /**
-     * Copy-Constructor
+     * Constructs a network with the weights and biases of a snapshot.
+     * The weights are shared until the network modifies them.
+     * @param snapshot Snapshot.
+     */
+    explicit Network( const NetworkSnapshot& snapshot );
+
+    /**
+     * Copy-Constructor. The layers share their weights and biases
+     * with n until one of the networks modifies them.
      * @param n
      */
     Network( const Network& n );
@@ -134,17 +150,18 @@ public:
      * to the computed partial derivatives and the stochastic gradient descent method.
      * The stochastic gradient descent methods updates the weights and biases by the averaged
      * partial derivatives of a randomly chosen batch of samples. In total, nbrOfSamples / batchsize
-     * batches are executed -> this is called an epoch. The computation is performed in another
-     * thread. The user gets informed over the NetworkOperationCallback interface.
+     * batches are executed -> this is called an epoch. The computation is queued behind
+     * the other asynchronous operations of this network and performed on the global executor.
+     * The user gets informed over the NetworkOperationCallback interface.
      * @see setCostFunction
      * @param samples Input signals.
      * @param lables Desired output signals.
      * @param batchsize Number of samples in the batch.
      * @param eta Learning rate.
      * @param userId User given id.
-     * @return true if successful.
+     * @return Job handle. Cancelling it stops the epoch after the current batch.
      */
-    bool stochasticGradientDescentAsync(const std::vector<Eigen::MatrixXd> &samples, const std::vector<Eigen::MatrixXd> &lables,
+    NetworkJobPtr stochasticGradientDescentAsync(const std::vector<Eigen::MatrixXd> &samples, const std::vector<Eigen::MatrixXd> &lables,
                                         const unsigned int& batchsize, const double& eta, const int& userId );
 
     /**
@@ -163,15 +180,16 @@ public:
                       double& successRateIdenticalMax, double& averageCost, std::vector<size_t>& failedSamplesIdx );
 
     /**
-     * Tests the network with given samples and lables. The computation is performed in another
-     * thread. The user gets informed over the NetworkOperationCallback interface.
+     * Tests the network with given samples and lables. The computation is queued behind
+     * the other asynchronous operations of this network and performed on the global executor.
+     * The user gets informed over the NetworkOperationCallback interface.
      * @param samples Input sample.
      * @param lables Expected output.
      * @param euclideanDistanceThreshold The threshold when compareing the Euclidean distance between expected output and actual output signal.
      * @param userId User given id.
-     * @return True if successful. Otherwise false.
+     * @return Job handle. The test results are available from it once done.
      */
-    bool testNetworkAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+    NetworkJobPtr testNetworkAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
                            const double& euclideanDistanceThreshold, const int& userId );
 
     /**
@@ -192,19 +210,45 @@ public:
      * Set an observer, which gets informed about operation progress.
      * @param observer A pointer to an observer.
      */
-    void setObserver( NetworkOperationCallback* observer ) { m_oberserver = observer; }
+    void setObserver( NetworkOperationCallback* observer );
+
+    /**
+     * Limits the rate of in-progress events sent to the observer. The observer
+     * is called from a separate thread, so a slow observer never stalls
+     * the network operation. Result events are never limited or dropped.
+     * @param maxProgressEventsPerSecond Events per second. 0 means no limit.
+     */
+    void setObserverRateLimit( double maxProgressEventsPerSecond );
+
+    /**
+     * Blocks until the observer received all events sent so far.
+     * Must not be called from within the observer.
+     */
+    void waitForObserver();
 
     /**
-    * Return a handle to the current NN operation thread.
-    * @return Handle to compuation thread.
-    */
-    std::thread& getCurrentAsyncOperation() { return m_asyncOperation; }
+     * Channel delivering the events to the observer. Pass it to
+     * NetworkSnapshot::testAsync to receive the snapshot test results
+     * like the other events.
+     * @return Channel, NULL if there is no observer.
+     */
+    std::shared_ptr<NetworkEventChannel> getEventChannel() const { return m_eventChannel; }
 
     /**
-     * Indicates if an asynchronous operation is ongoing or not.
+     * Requests cancellation of all queued and running asynchronous operations.
+     */
+    void cancelOperations();
+
+    /**
+     * Blocks until all queued asynchronous operations finished.
+     */
+    void waitForOperations();
+
+    /**
+     * Indicates if an asynchronous operation is queued or ongoing.
      * @return True if operation in progress. Otherwise false.
      */
-    bool isOperationInProgress() { return m_operationInProgress; }
+    bool isOperationInProgress() { return m_nbrOfPendingJobs > 0; }
 
     /**
      * Returns the structure of the neural network.
@@ -225,9 +269,11 @@ public:
     std::string serialize() const;
 
     /**
-     * Deserialize a binary representation of a network.
+     * Deserialize a binary representation of a network. Layer counts
+     * and sizes are checked against the buffer length, so untrusted data,
+     * e.g. received from another process, can be passed.
      * @param buffer Binaray data.
-     * @return Initialized network
+     * @return Initialized network, NULL if the buffer is short or corrupt.
      */
     static Network* deserialize(const std::string& buffer );
 
@@ -290,23 +336,81 @@ public:
      */
     void resetWeights();
 
+    /**
+     * Creates an immutable snapshot of the current weights and biases.
+     * No weights are copied. Must not be called concurrently to training,
+     * use getSnapshot() for that.
+     * @return Snapshot.
+     */
+    NetworkSnapshotPtr createSnapshot() const;
+
+    /**
+     * Creates a snapshot and publishes it. Afterwards, getSnapshot() returns it.
+     */
+    void publishSnapshot();
+
+    /**
+     * Returns the latest published snapshot. This is safe to call from any thread
+     * while the network is training and never waits for the training.
+     * @return Latest snapshot, NULL if none was published yet.
+     */
+    NetworkSnapshotPtr getSnapshot() const;
+
+    /**
+     * Sets how often stochastic gradient descent publishes a snapshot.
+     * A snapshot is always published at the end of each epoch.
+     * @param nbrOfBatches Publish after this many batches. 0 means only at the end of an epoch.
+     */
+    void setSnapshotInterval( const unsigned int& nbrOfBatches ) { m_snapshotInterval = nbrOfBatches; }
+    unsigned int getSnapshotInterval() const { return m_snapshotInterval; }
+
+    /**
+     * Enables or disables the timing and counter instrumentation of the
+     * network and all its layers. The instrumentation is only available if
+     * the library was compiled with EIDNN_STATS (see NetworkStats::isCompiledIn()).
+     * @param enable True to enable.
+     */
+    void setStatsEnabled( bool enable );
+    bool isStatsEnabled() const { return m_statsEnabled; }
+
+    /**
+     * Returns a snapshot of the accumulated per-layer and per-phase timings.
+     * It is safe to call this while an asynchronous operation is running.
+     * @return Stats snapshot.
+     */
+    NetworkStats getStats() const;
+
+    /**
+     * Sets all timings and counters to zero.
+     */
+    void resetStats();
+
 
 private:
 
-    void initNetwork();
+    void initNetwork( const bool& randomInit );
 
     // Do feedforward and backprop. but weights and biases are not updated!
     bool doFeedforwardAndBackpropagation(const Eigen::MatrixXd &x_in, const Eigen::MatrixXd &y_out );
 
     bool doStochasticGradientDescentBatch(const Eigen::MatrixXd& batch_in, const Eigen::MatrixXd& batch_out, const double& eta);
 
+    // cancel may be NULL. The final observer event is not sent.
+    bool doStochasticGradientDescent( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                                      const unsigned int& batchsize, const double& eta, const std::atomic<bool>* cancel );
+
+    bool doTestNetwork( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                        const double& euclideanDistanceThreshold, bool doCallback, double& successRateEuclideanDistance,
+                        double& successRateIdenticalMax, double& averageCost, std::vector<size_t>& failedSamplesIdx,
+                        const std::atomic<bool>* cancel );
+
     void sendProg2Obs( const NetworkOperationCallback::NetworkOperationId& opId,
                        const NetworkOperationCallback::NetworkOperationStatus& opStatus, const double& progress  );
 
-    bool prepareForNextAsynchronousOperation();
+    NetworkJobPtr enqueueJob( NetworkJobPtr job );
 
-    void doTestAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
-                      const double& euclideanDistanceThreshold );
+    // Executes the queued jobs one after the other. Runs on the executor.
+    void runJobs();
 
 private:
 
@@ -315,11 +419,29 @@ private:
     Eigen::MatrixXd m_activation_out;
 
     NetworkOperationCallback* m_oberserver;
-    std::thread m_asyncOperation;
-    std::atomic<bool> m_operationInProgress;
+    double m_observerRateLimit{20.0};
+    std::shared_ptr<NetworkEventChannel> m_eventChannel;
+
+    // asynchronous operations, at most one of them is running
+    std::mutex m_jobsMutex;
+    std::condition_variable m_jobsIdle;
+    std::deque<NetworkJobPtr> m_jobs;
+    NetworkJobPtr m_runningJob;
+    bool m_jobsRunnerActive{false};
+    std::atomic<int> m_nbrOfPendingJobs{0};
 
     std::shared_ptr<Regularization> m_regularization;
 
+    // latest published snapshot, only accessed with std::atomic_load / std::atomic_store
+    NetworkSnapshotPtr m_snapshot;
+    unsigned int m_snapshotInterval{0};
+    uint64_t m_trainedBatches{0};
+
+    std::atomic<bool> m_statsEnabled{false};
+    PhaseCounter m_stats[NetworkStats::NumberOfPhases];
+    std::atomic<uint64_t> m_statsBatches{0};
+    std::atomic<uint64_t> m_statsSamples{0};
+
     int m_userID{0};
 public:
     int
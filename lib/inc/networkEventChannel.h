@@ -0,0 +1,147 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef NETWORKEVENTCHANNELHEADER
+#define NETWORKEVENTCHANNELHEADER
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "network_cb.h"
+#include "spscQueue.h"
+
+/**
+ * Progress or result event of a network operation.
+ */
+struct NetworkEvent
+{
+    enum EventType
+    {
+        Progress = 0x00,
+        TestResults
+    };
+
+    EventType type = Progress;
+    int userId = 0;
+
+    // Progress
+    NetworkOperationCallback::NetworkOperationId opId = NetworkOperationCallback::OpStochasticGradientDescent;
+    NetworkOperationCallback::NetworkOperationStatus opStatus = NetworkOperationCallback::OpInProgress;
+    double progress = 0.0;
+
+    // TestResults
+    double successRateEuclidean = 0.0;
+    double successRateMaxIdx = 0.0;
+    double averageCost = 0.0;
+    std::vector<std::size_t> failedSamplesIdx;
+};
+
+/**
+ * Delivers network operation events to an observer on a separate thread.
+ * The network operation pushes events into a bounded single-producer /
+ * single-consumer queue and never waits for the observer. In-progress events
+ * are rate limited and dropped if the queue is full. Result events are never
+ * dropped. Several threads may push events, e.g. training and snapshot tests;
+ * they are serialized by a mutex which is never held while the observer runs.
+ */
+class NetworkEventChannel
+{
+public:
+
+    /**
+     * Constructor. Starts the delivering thread.
+     * @param observer Observer receiving the events.
+     * @param maxProgressEventsPerSecond Maximum rate of in-progress events.
+     * @param capacity Number of events the queue can hold.
+     */
+    NetworkEventChannel( NetworkOperationCallback* observer, double maxProgressEventsPerSecond = 20.0, size_t capacity = 256 );
+
+    /**
+     * Delivers all pending events and stops the delivering thread.
+     */
+    ~NetworkEventChannel();
+
+    /**
+     * Queues a progress event. Producer side, never waits for the observer.
+     */
+    void progress( const NetworkOperationCallback::NetworkOperationId& opId,
+                   const NetworkOperationCallback::NetworkOperationStatus& opStatus,
+                   const double& progress, const int& userId );
+
+    /**
+     * Queues a test result event. Producer side, never waits for the observer.
+     */
+    void testResults( const double& successRateEuclidean, const double& successRateMaxIdx, const double& averageCost,
+                      const std::vector<std::size_t>& failedSamplesIdx, const int& userId );
+
+    /**
+     * Blocks until all events queued so far were delivered to the observer.
+     * Must not be called from the observer.
+     */
+    void flush();
+
+    /**
+     * Sets the maximum rate of in-progress events. Result events are not limited.
+     * @param maxProgressEventsPerSecond Events per second. 0 or less means no limit.
+     */
+    void setMaxProgressEventsPerSecond( double maxProgressEventsPerSecond );
+
+    /**
+     * Number of in-progress events which were not delivered because of
+     * the rate limit or because the observer could not keep up.
+     */
+    uint64_t getNumberOfSkippedEvents() const { return m_skipped; }
+
+private:
+    void push( NetworkEvent&& event, bool mandatory ); // producer mutex held
+    void run();
+    void deliver( const NetworkEvent& event );
+
+private:
+    NetworkOperationCallback* m_observer;
+    SpscQueue<NetworkEvent> m_queue;
+
+    std::mutex m_producerMutex;
+    std::atomic<int64_t> m_minProgressIntervalNs;
+    std::chrono::steady_clock::time_point m_lastProgress;   // producer only
+
+    // Result events which did not fit into the full queue.
+    std::mutex m_overflowMutex;
+    std::vector<NetworkEvent> m_overflow;
+
+    std::atomic<uint64_t> m_queued{0};
+    std::atomic<uint64_t> m_delivered{0};
+    std::atomic<uint64_t> m_skipped{0};
+
+    std::atomic<bool> m_stop{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    std::thread m_consumer;
+};
+
+#endif // NETWORKEVENTCHANNELHEADER
@@ -0,0 +1,129 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef NETWORKJOBHEADER
+#define NETWORKJOBHEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "network_cb.h"
+
+#define NetworkJobPtr std::shared_ptr<NetworkJob>
+
+/**
+ * Results of a network test operation.
+ */
+struct NetworkTestResults
+{
+    double successRateEuclidean = 0.0;
+    double successRateMaxIdx = 0.0;
+    double averageCost = 0.0;
+    std::vector<std::size_t> failedSamplesIdx;
+};
+
+/**
+ * Handle to an asynchronous network operation. The operations of one network
+ * are executed one after the other in the order they were queued.
+ */
+class NetworkJob
+{
+public:
+
+    enum JobStatus
+    {
+        JobQueued = 0x00,
+        JobRunning,
+        JobDone,
+        JobFailed,
+        JobCancelled
+    };
+
+public:
+    NetworkJob( const NetworkOperationCallback::NetworkOperationId& opId, const int& userId );
+
+    /**
+     * Requests cancellation. A queued job is not started anymore, a running
+     * job stops at the next batch or sample.
+     */
+    void cancel() { m_cancel = true; }
+    bool isCancellationRequested() const { return m_cancel; }
+
+    /**
+     * Blocks until the job finished.
+     */
+    void wait() const;
+
+    /**
+     * Blocks until the job finished or the timeout expired.
+     * @param seconds Timeout.
+     * @return True if the job finished.
+     */
+    bool waitFor( const double& seconds ) const;
+
+    /**
+     * Blocks until the job finished.
+     * @return True if the operation was successful.
+     */
+    bool get() const;
+
+    JobStatus getStatus() const;
+    bool isFinished() const;
+
+    NetworkOperationCallback::NetworkOperationId getOperationId() const { return m_opId; }
+    int getUserId() const { return m_userId; }
+
+    /**
+     * Test results. Only valid for successful test operations.
+     * @return Test results.
+     */
+    const NetworkTestResults& getTestResults() const { return m_testResults; }
+
+private:
+    friend class Network;
+    friend class NetworkSnapshot;
+
+    void setRunning();
+    void finish( const JobStatus& status );
+
+    const std::atomic<bool>* getCancellationFlag() const { return &m_cancel; }
+
+private:
+    const NetworkOperationCallback::NetworkOperationId m_opId;
+    const int m_userId;
+
+    std::function<bool(NetworkJob&)> m_work;
+    NetworkTestResults m_testResults;
+
+    std::atomic<bool> m_cancel{false};
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_finished;
+    JobStatus m_status = JobQueued;
+};
+
+#endif // NETWORKJOBHEADER
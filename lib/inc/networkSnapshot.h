@@ -0,0 +1,125 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef NETWORKSNAPSHOTHEADER
+#define NETWORKSNAPSHOTHEADER
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "layer.h"
+#include "networkJob.h"
+
+class CostFunction;
+class NetworkEventChannel;
+
+#define NetworkSnapshotPtr std::shared_ptr<const NetworkSnapshot>
+
+/**
+ * Immutable version of the weights and biases of a network.
+ * The parameters are shared with the network (copy-on-write), hence creating
+ * a snapshot does not copy any weights. All functions are const and can be
+ * called from any number of threads while the network keeps training.
+ */
+class NetworkSnapshot: public std::enable_shared_from_this<NetworkSnapshot>
+{
+public:
+
+    /**
+     * Constructor. Usually snapshots are created by the network.
+     * @see Network::createSnapshot
+     * @param layerParameters Parameters of each layer. The parameters of the first layer (input layer) are not used.
+     * @param layerTypes Type of each layer.
+     * @param costFunction Cost function of the output layer.
+     * @param regularizationCost Constant regularization cost added to the cost of each sample.
+     * @param version Number of training batches the network had performed.
+     */
+    NetworkSnapshot( const std::vector<unsigned int>& networkStructure,
+                     const std::vector< std::shared_ptr<const LayerParameters> >& layerParameters,
+                     const std::vector<Layer::LayerOutputType>& layerTypes,
+                     const std::shared_ptr<CostFunction>& costFunction,
+                     const double& regularizationCost, const uint64_t& version );
+
+    /**
+     * Computes the network output signal.
+     * @param x_in Input signal. One column per sample.
+     * @param out Output signal.
+     * @return True if successful.
+     */
+    bool feedForward( const Eigen::MatrixXd& x_in, Eigen::MatrixXd& out ) const;
+
+    /**
+     * Tests the snapshot with given samples and lables.
+     * @see Network::testNetwork
+     * @param samples Input sample.
+     * @param lables Expected output.
+     * @param euclideanDistanceThreshold The threshold when compareing the Euclidean distance between expected output and actual output signal.
+     * @param results Test results.
+     * @param cancel Optional cancellation flag, checked before each sample.
+     * @return True if successful. Otherwise false.
+     */
+    bool test( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+               const double& euclideanDistanceThreshold, NetworkTestResults& results,
+               const std::atomic<bool>* cancel = nullptr ) const;
+
+    /**
+     * Tests the snapshot on the global executor. Snapshot tests run concurrently
+     * to each other and to the training of the network.
+     * The result events are queued to the channel, which calls its observer
+     * on its own thread, e.g. Network::getEventChannel().
+     * @param samples Input sample.
+     * @param lables Expected output.
+     * @param euclideanDistanceThreshold The threshold when compareing the Euclidean distance between expected output and actual output signal.
+     * @param userId User given id.
+     * @param channel Optional event channel.
+     * @return Job handle.
+     */
+    NetworkJobPtr testAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                             const double& euclideanDistanceThreshold, const int& userId,
+                             const std::shared_ptr<NetworkEventChannel>& channel = nullptr ) const;
+
+    const std::vector<unsigned int>& getNetworkStructure() const { return m_networkStructure; }
+    unsigned int getNumberOfLayer() const { return unsigned(m_networkStructure.size()); }
+
+    const std::shared_ptr<const LayerParameters>& getLayerParameters( const unsigned int& layerIdx ) const { return m_layerParameters.at(layerIdx); }
+    Layer::LayerOutputType getLayerType( const unsigned int& layerIdx ) const { return m_layerTypes.at(layerIdx); }
+    const std::shared_ptr<CostFunction>& getCostFunction() const { return m_costFunction; }
+
+    /**
+     * Version of the snapshot. Higher versions are newer.
+     * @return Number of training batches the network had performed.
+     */
+    uint64_t getVersion() const { return m_version; }
+
+private:
+    const std::vector<unsigned int> m_networkStructure;
+    const std::vector< std::shared_ptr<const LayerParameters> > m_layerParameters;
+    const std::vector<Layer::LayerOutputType> m_layerTypes;
+    const std::shared_ptr<CostFunction> m_costFunction;
+    const double m_regularizationCost;
+    const uint64_t m_version;
+};
+
+#endif // NETWORKSNAPSHOTHEADER
@@ -0,0 +1,180 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef NETWORKSTATSHEADER
+#define NETWORKSTATSHEADER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Accumulated time and number of executions of one phase.
+ */
+struct PhaseStats
+{
+    uint64_t count = 0;
+    uint64_t nanoseconds = 0;
+
+    double seconds() const { return double(nanoseconds) * 1e-9; }
+};
+
+/**
+ * Lock-free phase counter. It is written by the one thread running the
+ * network operation and can be read by any other thread at any time.
+ */
+class PhaseCounter
+{
+public:
+    void add( uint64_t nanoseconds )
+    {
+        // single writer -> no read-modify-write needed
+        m_count.store( m_count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        m_nanoseconds.store( m_nanoseconds.load( std::memory_order_relaxed ) + nanoseconds, std::memory_order_relaxed );
+    }
+
+    PhaseStats get() const
+    {
+        PhaseStats s;
+        s.count = m_count.load( std::memory_order_relaxed );
+        s.nanoseconds = m_nanoseconds.load( std::memory_order_relaxed );
+        return s;
+    }
+
+    void reset()
+    {
+        m_count.store( 0, std::memory_order_relaxed );
+        m_nanoseconds.store( 0, std::memory_order_relaxed );
+    }
+
+private:
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_nanoseconds{0};
+};
+
+/**
+ * Measures the lifetime of the scope with the monotonic clock and adds it
+ * to the passed counter. Nothing is measured if the counter is null.
+ */
+class ScopedPhaseTimer
+{
+public:
+    explicit ScopedPhaseTimer( PhaseCounter* counter ) : m_counter( counter )
+    {
+        if( m_counter != nullptr )
+            m_start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedPhaseTimer()
+    {
+        if( m_counter != nullptr )
+            m_counter->add( uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start ).count() ) );
+    }
+
+private:
+    PhaseCounter* m_counter;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * The instrumentation is compiled in only if EIDNN_STATS is defined (cmake option STATSEIDNN).
+ * Otherwise EIDNN_STATS_SCOPE and EIDNN_STATS_COUNT expand to nothing.
+ */
+#ifdef EIDNN_STATS
+#define EIDNN_STATS_CONCAT_(a, b) a##b
+#define EIDNN_STATS_CONCAT(a, b) EIDNN_STATS_CONCAT_(a, b)
+#define EIDNN_STATS_SCOPE(enabled, counter) ScopedPhaseTimer EIDNN_STATS_CONCAT(eidnnPhaseTimer_, __LINE__)( (enabled) ? &(counter) : nullptr )
+#define EIDNN_STATS_COUNT(enabled, counter, value) \
+    if( enabled ) (counter).store( (counter).load( std::memory_order_relaxed ) + (value), std::memory_order_relaxed )
+#else
+#define EIDNN_STATS_SCOPE(enabled, counter)
+#define EIDNN_STATS_COUNT(enabled, counter, value)
+#endif
+
+/**
+ * Timings of the phases within a layer.
+ */
+struct LayerStats
+{
+    enum Phase
+    {
+        FeedForward = 0x00,     // Weighted input and activation
+        BackpropagationError,   // Delta of the layer
+        PartialDerivatives,     // Partial derivatives of weights and biases
+        Update,                 // Weight and bias update
+        NumberOfPhases
+    };
+
+    PhaseStats phases[NumberOfPhases];
+
+    static std::string phaseName( Phase phase );
+};
+
+/**
+ * Snapshot of the network instrumentation.
+ */
+struct NetworkStats
+{
+    enum Phase
+    {
+        BatchGather = 0x00,     // Assembling the random sample batch
+        GradientReduction,      // Averaging the partial derivatives of the batch
+        ObserverCallback,       // Informing the observer
+        NumberOfPhases
+    };
+
+    PhaseStats phases[NumberOfPhases];
+
+    /**
+     * Stats of each layer. The first element is the input layer.
+     */
+    std::vector<LayerStats> layers;
+
+    uint64_t batches = 0;
+    uint64_t samples = 0;
+
+    /**
+     * Accumulated stats of one layer phase over all layers.
+     * @param phase Layer phase.
+     * @return Stats.
+     */
+    PhaseStats total( LayerStats::Phase phase ) const;
+
+    /**
+     * Human readable table of the stats.
+     * @return String.
+     */
+    std::string toString() const;
+
+    static std::string phaseName( Phase phase );
+
+    /**
+     * Is the instrumentation compiled in.
+     * @return True if compiled with EIDNN_STATS.
+     */
+    static bool isCompiledIn();
+};
+
+#endif // NETWORKSTATSHEADER
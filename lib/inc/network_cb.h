@@ -40,7 +40,8 @@ public:
     {
         OpResultOk = 0x00,
         OpResultErr,
-        OpInProgress
+        OpInProgress,
+        OpCancelled
     };
 
 public:
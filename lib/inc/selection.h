@@ -0,0 +1,146 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef SELECTIONHEADER
+#define SELECTIONHEADER
+
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * Chooses the parents of an offspring. The candidates are the
+ * simulations of the finished epoch ordered by fitness, best first.
+ */
+class Selection
+{
+public:
+    virtual ~Selection();
+
+    /**
+     * Number of best simulations considered as parents.
+     * @param nbrOfSimulations Number of simulations in the epoch.
+     * @return Number of candidates.
+     */
+    virtual size_t getNumberOfCandidates( size_t nbrOfSimulations ) const;
+
+    /**
+     * Called once per breeding, before the parents are selected.
+     * @param fitness Fitness of the candidates, best first.
+     */
+    virtual void prepare( const std::vector<double>& fitness );
+
+    /**
+     * Selects one parent, called after prepare().
+     * @param gen Random generator.
+     * @return Index of the candidate.
+     */
+    virtual size_t select( std::mt19937& gen ) const = 0;
+
+    /**
+     * Selects the two parents of an offspring. Different candidates
+     * if possible.
+     * @param gen Random generator.
+     * @return Indices of the candidates.
+     */
+    virtual std::pair<size_t, size_t> selectParents( std::mt19937& gen ) const;
+
+protected:
+    size_t m_nbrOfCandidates = 0;
+};
+
+/**
+ * All offsprings are bred from the two best. Uses no random numbers.
+ */
+class TopTwoSelection: public Selection
+{
+public:
+    size_t getNumberOfCandidates( size_t nbrOfSimulations ) const override;
+    size_t select( std::mt19937& gen ) const override;
+    std::pair<size_t, size_t> selectParents( std::mt19937& gen ) const override;
+};
+
+/**
+ * Parents are drawn uniformly from the best k.
+ */
+class EliteSelection: public Selection
+{
+public:
+    EliteSelection( size_t k );
+
+    size_t getNumberOfCandidates( size_t nbrOfSimulations ) const override;
+    size_t select( std::mt19937& gen ) const override;
+
+private:
+    size_t m_k;
+};
+
+/**
+ * The best of k uniformly drawn candidates becomes a parent.
+ */
+class TournamentSelection: public Selection
+{
+public:
+    TournamentSelection( size_t k );
+
+    size_t select( std::mt19937& gen ) const override;
+
+private:
+    size_t m_k;
+};
+
+/**
+ * Linear ranking: the probability decreases linearly with the rank.
+ */
+class RankSelection: public Selection
+{
+public:
+    /**
+     * @param pressure Expected number of offsprings of the best,
+     *        1.0 (uniform) - 2.0 (worst never selected).
+     */
+    RankSelection( double pressure = 1.5 );
+
+    void prepare( const std::vector<double>& fitness ) override;
+    size_t select( std::mt19937& gen ) const override;
+
+private:
+    double m_pressure;
+    std::vector<double> m_cumulative;
+};
+
+/**
+ * Roulette wheel: the probability is proportional to the fitness
+ * above the one of the worst candidate.
+ */
+class FitnessProportionalSelection: public Selection
+{
+public:
+    void prepare( const std::vector<double>& fitness ) override;
+    size_t select( std::mt19937& gen ) const override;
+
+private:
+    std::vector<double> m_cumulative;
+};
+
+#endif // SELECTIONHEADER
@@ -26,6 +26,7 @@
 
 #include <chrono>
 #include <memory>
+#include <vector>
 
 #include "network.h"
 
@@ -40,10 +41,19 @@ public:
     virtual ~Simulation();
 
     /**
-     * Update the simulation.
+     * Update the simulation. The step lasts as long as the wall-clock
+     * time elapsed since the last update.
      */
     void doStep();
 
+    /**
+     * Update the simulation by a fixed, simulated time step. The wall-clock
+     * is not consulted, so steps can be computed faster than real-time and
+     * the outcome only depends on the sequence of time steps.
+     * @param dt Simulated duration of the step in seconds.
+     */
+    void doStep( double dt );
+
     /**
      * Fitness is a measure performance.
      * @return Fitness.
@@ -63,11 +73,18 @@ public:
     virtual void setLastUpdateTime(const std::chrono::milliseconds &lastUpdate);
 
     /**
-     * Time since last update in seconds.
+     * Wall-clock time since last update in seconds.
      * @return Elapsed time in seconds
      */
     virtual double getTimeSinceLastUpdate() const;
 
+    /**
+     * Duration of the current (or last) step in seconds. Simulations
+     * use this in update() to advance their state.
+     * @return Step duration in seconds.
+     */
+    double getStepDuration() const;
+
     /**
      * Get neuronal network.
      * @return NN
@@ -86,16 +103,28 @@ public:
     virtual bool isAlive() const;
 
     /**
-     * How long was the simulation alive.
+     * How long was the simulation alive, in simulated time: the sum
+     * of all completed steps.
      * @return seconds.
      */
     virtual double getAge() const;
 
+    /**
+     * Number of completed steps.
+     */
+    size_t getNumberOfSteps() const;
+
     /**
      * Stops this simulation.
      */
     virtual void kill();
 
+    /**
+     * Brings the simulation back to its initial state, so the object
+     * can be reused for another genom. The network is not changed.
+     */
+    virtual void reset();
+
 protected:
 
     std::chrono::milliseconds now() const;
@@ -111,6 +140,9 @@ protected:
     std::chrono::milliseconds m_age;
     std::chrono::milliseconds m_creation;
     std::chrono::milliseconds m_lastUpdate;
+    double m_clock = 0.0;
+    double m_stepDuration = 0.0;
+    size_t m_steps = 0;
     bool m_alive = true;
     NetworkPtr m_network;
 };
@@ -124,7 +156,51 @@ public:
     virtual ~SimulationFactory();
 
     virtual SimulationPtr createRandomSimulation();
+
+    /**
+     * Creates a simulation controlled by the given network.
+     * Override this to avoid initializing a random network which is replaced anyway.
+     * @param network NN
+     * @return Simulation
+     */
+    virtual SimulationPtr createSimulation( NetworkPtr network );
+
     virtual SimulationPtr createCrossover( SimulationPtr a, SimulationPtr b, double mutationRate );
+
+    /**
+     * Like createCrossover, but reuses a simulation of a former generation.
+     * The crossover is written into the network of the recycled simulation,
+     * which is then reset. Evolution calls this concurrently from several threads.
+     * @param recycled Simulation nobody else references anymore. May be NULL.
+     * @return Recycled simulation or, if that was not possible, a new one.
+     */
+    virtual SimulationPtr recycleCrossover( SimulationPtr recycled, SimulationPtr a, SimulationPtr b, double mutationRate );
+
+    /**
+     * Creates a simulation whose network has the structure of the prototype's
+     * network and the given parameters (Genetic::setParameterVector). Reuses
+     * the recycled simulation if possible. Evolution calls this concurrently
+     * from several threads.
+     * @param recycled Simulation nobody else references anymore. May be NULL.
+     * @param prototype Simulation of the same kind.
+     * @param parameters Weights and biases.
+     * @return Recycled simulation or, if that was not possible, a new one.
+     */
+    virtual SimulationPtr recycleWithParameters( SimulationPtr recycled, SimulationPtr prototype, const Eigen::VectorXd& parameters );
+
+    /**
+     * Steps the alive simulations in [start, end). Evolution calls this
+     * concurrently for disjoint ranges. Override to step many simulations
+     * of this factory at once.
+     * @param dt Step duration in seconds. 0 -> real-time steps.
+     * @return True if any of the simulations was alive.
+     */
+    virtual bool doSteps( const std::vector<SimulationPtr>& sims, size_t start, size_t end, double dt );
+
+    /**
+     * Creates a new simulation with a copy of the network of a.
+     * The weights are shared until one of the networks is modified.
+     */
     virtual SimulationPtr copy( SimulationPtr a );
 };
 
@@ -0,0 +1,102 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef SPSCQUEUEHEADER
+#define SPSCQUEUEHEADER
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded, lock-free single-producer / single-consumer queue.
+ * push() must only be called by one thread, pop() only by one other thread.
+ * Neither of them ever blocks.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+
+    /**
+     * Constructor
+     * @param capacity Maximum number of queued items.
+     */
+    explicit SpscQueue( size_t capacity ) : m_buffer( capacity + 1 ) { }
+
+    /**
+     * Appends an item. Producer side.
+     * @param item Item.
+     * @return False if the queue is full and the item was not added.
+     */
+    bool push( T&& item )
+    {
+        const size_t tail = m_tail.load( std::memory_order_relaxed );
+        const size_t next = increment( tail );
+        if( next == m_head.load( std::memory_order_acquire ) )
+            return false;
+
+        m_buffer[tail] = std::move( item );
+        m_tail.store( next, std::memory_order_release );
+        return true;
+    }
+
+    /**
+     * Takes the oldest item. Consumer side.
+     * @param item Taken item.
+     * @return False if the queue is empty.
+     */
+    bool pop( T& item )
+    {
+        const size_t head = m_head.load( std::memory_order_relaxed );
+        if( head == m_tail.load( std::memory_order_acquire ) )
+            return false;
+
+        item = std::move( m_buffer[head] );
+        m_head.store( increment( head ), std::memory_order_release );
+        return true;
+    }
+
+    bool empty() const
+    {
+        return m_head.load( std::memory_order_acquire ) == m_tail.load( std::memory_order_acquire );
+    }
+
+    size_t capacity() const { return m_buffer.size() - 1; }
+
+private:
+    size_t increment( size_t idx ) const
+    {
+        return idx + 1 == m_buffer.size() ? 0 : idx + 1;
+    }
+
+private:
+    std::vector<T> m_buffer;
+
+    // producer and consumer index on separate cache lines
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+#endif // SPSCQUEUEHEADER
@@ -0,0 +1,159 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef STATSRINGHEADER
+#define STATSRINGHEADER
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed-size, lock-free ring of the latest records, written by one thread
+ * and read by any number of other threads. Older records are overwritten.
+ * Each slot is guarded by a sequence number: readers copy the record and
+ * retry if it changed meanwhile, the writer never waits.
+ */
+template<typename T>
+class StatsRing
+{
+    static_assert( std::is_trivially_copyable<T>::value, "Records are copied word by word" );
+
+public:
+
+    /**
+     * Constructor
+     * @param capacity Number of records kept.
+     */
+    explicit StatsRing( size_t capacity ) : m_capacity( capacity ), m_slots( new Slot[capacity] ) { }
+
+    /**
+     * Appends a record. Writer side.
+     * @param record Record, overwrites the oldest if the ring is full.
+     */
+    void push( const T& record )
+    {
+        const uint64_t index = m_written.load( std::memory_order_relaxed );
+        Slot& slot = m_slots[index % m_capacity];
+
+        uint64_t words[Words] = {};
+        std::memcpy( words, &record, sizeof(T) );
+
+        // odd while writing
+        const uint64_t sequence = slot.sequence.load( std::memory_order_relaxed );
+        slot.sequence.store( sequence + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        slot.index.store( index, std::memory_order_relaxed );
+        for( size_t k = 0; k < Words; k++ )
+            slot.words[k].store( words[k], std::memory_order_relaxed );
+
+        slot.sequence.store( sequence + 2, std::memory_order_release );
+        m_written.store( index + 1, std::memory_order_release );
+    }
+
+    /**
+     * Number of records pushed so far, including the overwritten ones.
+     */
+    uint64_t getNumberOfRecords() const
+    {
+        return m_written.load( std::memory_order_acquire );
+    }
+
+    /**
+     * Copies one record. Reader side.
+     * @param index Record number, 0 is the first record ever pushed.
+     * @param record Copy of the record.
+     * @return False if the record was not pushed yet or is overwritten.
+     */
+    bool get( uint64_t index, T& record ) const
+    {
+        const Slot& slot = m_slots[index % m_capacity];
+        uint64_t words[Words];
+
+        while( true )
+        {
+            const uint64_t before = slot.sequence.load( std::memory_order_acquire );
+            if( before & 1 )
+                continue; // being written
+
+            const uint64_t slotIndex = slot.index.load( std::memory_order_relaxed );
+            for( size_t k = 0; k < Words; k++ )
+                words[k] = slot.words[k].load( std::memory_order_relaxed );
+
+            std::atomic_thread_fence( std::memory_order_acquire );
+            if( slot.sequence.load( std::memory_order_relaxed ) != before )
+                continue;
+
+            if( before == 0 || slotIndex != index )
+                return false;
+
+            std::memcpy( &record, words, sizeof(T) );
+            return true;
+        }
+    }
+
+    /**
+     * Copies the latest records. Reader side.
+     * @param n At most n records.
+     * @return Records, oldest first.
+     */
+    std::vector<T> getLatest( size_t n ) const
+    {
+        const uint64_t written = getNumberOfRecords();
+        const uint64_t count = std::min<uint64_t>( std::min<uint64_t>( n, written ), m_capacity );
+
+        std::vector<T> records;
+        records.reserve( count );
+        T record;
+        for( uint64_t index = written - count; index < written; index++ )
+            if( get( index, record ) ) // the oldest may be overwritten meanwhile
+                records.push_back( record );
+        return records;
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    static const size_t Words = ( sizeof(T) + sizeof(uint64_t) - 1 ) / sizeof(uint64_t);
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> index{0};
+        std::atomic<uint64_t> words[Words] = {};
+    };
+
+    const size_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // written by the writer only
+    alignas(64) std::atomic<uint64_t> m_written{0};
+};
+
+#endif // STATSRINGHEADER
@@ -0,0 +1,136 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef TRACEHEADER
+#define TRACEHEADER
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Timeline tracing of the library operations. Scoped events are recorded into
+ * a lock-free ring buffer of the calling thread and can be exported on demand
+ * in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+ *
+ * The EIDNN_TRACE_SCOPE instrumentation within the library is compiled in only
+ * if EIDNN_TRACE is defined (cmake option TRACEEIDNN). Recording is disabled by
+ * default and is switched on with Trace::setEnabled().
+ */
+class Trace
+{
+public:
+
+    /**
+     * Number of events each thread keeps. When the buffer is full,
+     * the oldest events are overwritten.
+     */
+    static constexpr size_t EventsPerThread = 1 << 14;
+
+    /**
+     * Enables or disables recording.
+     * @param enable True to enable.
+     */
+    static void setEnabled( bool enable );
+
+    static bool isEnabled() { return s_enabled.load( std::memory_order_relaxed ); }
+
+    /**
+     * Records a complete event of the calling thread.
+     * @param category Event category. Must be a string literal (the pointer is stored).
+     * @param name Event name. Must be a string literal (the pointer is stored).
+     * @param startNs Start time, see now().
+     * @param endNs End time, see now().
+     */
+    static void record( const char* category, const char* name, uint64_t startNs, uint64_t endNs );
+
+    /**
+     * Names the calling thread in the exported trace.
+     * @param name Thread name.
+     */
+    static void setThreadName( const std::string& name );
+
+    /**
+     * Monotonic time stamp.
+     * @return Nanoseconds since the tracing clock was initialized.
+     */
+    static uint64_t now();
+
+    /**
+     * Writes all recorded events as Chrome trace JSON. Threads may keep
+     * recording while exporting.
+     * @param out Output stream.
+     */
+    static void exportChromeJson( std::ostream& out );
+
+    /**
+     * Writes all recorded events as Chrome trace JSON file.
+     * @param filePath Path to file.
+     * @return True if successful, otherwise false.
+     */
+    static bool save( const std::string& filePath );
+
+    /**
+     * Removes all recorded events.
+     */
+    static void clear();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * Records an event covering the lifetime of the scope, if tracing is enabled.
+ */
+class TraceScope
+{
+public:
+    TraceScope( const char* category, const char* name ) : m_category( category ), m_name( name ), m_start( 0 ), m_active( Trace::isEnabled() )
+    {
+        if( m_active )
+            m_start = Trace::now();
+    }
+
+    ~TraceScope()
+    {
+        if( m_active )
+            Trace::record( m_category, m_name, m_start, Trace::now() );
+    }
+
+private:
+    const char* m_category;
+    const char* m_name;
+    uint64_t m_start;
+    bool m_active;
+};
+
+#ifdef EIDNN_TRACE
+#define EIDNN_TRACE_CONCAT_(a, b) a##b
+#define EIDNN_TRACE_CONCAT(a, b) EIDNN_TRACE_CONCAT_(a, b)
+#define EIDNN_TRACE_SCOPE(category, name) TraceScope EIDNN_TRACE_CONCAT(eidnnTraceScope_, __LINE__)( category, name )
+#else
+#define EIDNN_TRACE_SCOPE(category, name)
+#endif
+
+#endif // TRACEHEADER
@@ -0,0 +1,91 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef TRIPLEBUFFERHEADER
+#define TRIPLEBUFFERHEADER
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free triple buffer to hand the latest state from one producer
+ * thread to one consumer thread. The producer fills the write buffer
+ * and publishes it, the consumer picks up the latest published buffer.
+ * Intermediate states may be skipped, nobody ever waits.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+
+    /**
+     * Buffer to be filled by the producer. It is never read by the consumer
+     * before publish() is called.
+     */
+    T& getWriteBuffer() { return m_buffers[m_write]; }
+
+    /**
+     * Makes the write buffer available to the consumer. Producer side.
+     * Afterwards, getWriteBuffer() returns another buffer, whose content
+     * is an older state.
+     */
+    void publish()
+    {
+        uint8_t former = m_middle.exchange( uint8_t( m_write | FreshBit ), std::memory_order_acq_rel );
+        m_write = former & IndexMask;
+    }
+
+    /**
+     * Takes the latest published buffer, if there is a new one. Consumer side.
+     * @return True if getReadBuffer() changed.
+     */
+    bool update()
+    {
+        if( !( m_middle.load( std::memory_order_relaxed ) & FreshBit ) )
+            return false;
+
+        uint8_t former = m_middle.exchange( m_read, std::memory_order_acq_rel );
+        m_read = former & IndexMask;
+        return true;
+    }
+
+    /**
+     * Latest buffer taken by update(). Consumer side.
+     */
+    const T& getReadBuffer() const { return m_buffers[m_read]; }
+
+private:
+    static const uint8_t IndexMask = 0x3;
+    static const uint8_t FreshBit = 0x4;
+
+    T m_buffers[3];
+
+    // index of the buffer between producer and consumer, and if it is not consumed yet
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+
+    // owned by producer and consumer respectively
+    alignas(64) uint8_t m_write = 0;
+    alignas(64) uint8_t m_read = 2;
+};
+
+#endif // TRIPLEBUFFERHEADER
@@ -23,89 +23,316 @@
 
 
 #include "evolution.h"
+#include "genetic.h"
 #include "layer.h"
 #include "helpers.h"
+#include "trace.h"
 
 
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <numeric>
-#include <thread>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <inc/evolution.h>
 
 
+namespace
+{
+    const char checkpointMagic[8] = { 'E', 'I', 'D', 'N', 'N', 'P', 'O', 'P' };
+
+    // increase when the checkpoint format changes
+    const uint32_t checkpointVersion = 2;
+
+    // header flags
+    const uint32_t EpochOverFlag = 0x01;
+    const uint32_t SteadyStateFlag = 0x02;
+
+    /**
+     * File header. It is followed by the random generator state (text),
+     * one GenomeEntry per simulation, per archived simulation and one of
+     * the fittest so far, and the serialized networks in one block.
+     */
+    struct CheckpointHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t epochCount;
+        uint64_t nInitials;
+        uint64_t nOffsprings;
+        uint64_t nbrOfSimulations;
+        uint64_t nbrOfArchived;
+        uint64_t replacementCount;
+        uint64_t topK;
+        uint64_t archiveSize;
+        uint64_t tournamentSize;
+        double mutationRate;
+        double fixedTimeStep;
+        uint32_t lastEpochEnd;
+        uint32_t rngSize;
+        uint64_t blobSize;
+        uint64_t elitism;
+    };
+    static_assert( sizeof(CheckpointHeader) == 128, "Checkpoint header must be two cache lines" );
+
+    struct GenomeEntry
+    {
+        uint64_t offset; // in the network block
+        uint64_t size;
+        double fitness;
+    };
+    static_assert( sizeof(GenomeEntry) == 24, "Unexpected padding of the genome entry" );
+}
+
+/**
+ * Snapshot of the population. The networks share the weights with the
+ * simulations, so taking it is cheap.
+ */
+struct Evolution::Checkpoint
+{
+    CheckpointHeader header;
+    std::string rng;
+    std::vector<NetworkPtr> networks; // simulations, then archive
+    std::vector<double> fitness;
+};
+
 Evolution::Evolution(size_t nInitial, size_t nNext, SimFactoryPtr simFactory, unsigned int nThreads)
 : m_nInitials(nInitial), m_nOffsprings(nNext), m_simFactory(simFactory), m_epochOver(false), m_epochCount(0), m_mutationRate(0.0),
-  m_stepCounter(0), m_simSpeed(0.0), m_nbrThreads(nThreads), m_keepParents(true)
+  m_stepCounter(0), m_simSpeed(0.0), m_nbrThreads(nThreads), m_executor(new Executor(nThreads)),
+  m_fixedTimeStep(0.0), m_epochSimulatedTime(0.0), m_elitism(2),
+  m_fittestFitness(std::numeric_limits<double>::lowest()), m_topK(2), m_selection(new TopTwoSelection()), m_nbrSampled(0),
+  m_steadyState(false), m_archiveSize(20), m_tournamentSize(3), m_replacementCount(0), m_replacementCounter(0),
+  m_replacementSpeed(0.0), m_maxSimulationAge(0.0), m_lastEpochEnd(EpochEnd::Running), m_running(false),
+  m_stepStatistics(1024), m_epochStatistics(256), m_breedSeconds(0.0), m_checkpointWritten(true)
 {
     m_simSpeedTime = now();
     std::generate_n(std::back_inserter(m_simulations), nInitial, [simFactory]()->SimulationPtr { return simFactory->createRandomSimulation(); });
     m_fittest = m_simulations[0]; // set randomly
+    resetFitness();
+    startEpoch();
 }
 
 Evolution::~Evolution()
 {
-
+    stop();
+    waitForCheckpoint();
 }
 
-void Evolution::doStepOnFewSimulations( std::vector<SimulationPtr>& sims, std::atomic_bool& anyAlive, size_t start, size_t end )
+std::unique_lock<std::mutex> Evolution::lock()
 {
-    for( size_t k = start; k < end; k++ )
-    {
-        SimulationPtr s = sims[k];
-        if (s->isAlive())
-        {
-            s->doStep();
-            anyAlive = true;
-        }
-    }
+    // time waiting for the lock shows up in the trace
+    EIDNN_TRACE_SCOPE( "evolution", "wait for lock" );
+    return std::unique_lock<std::mutex>( m_mutex );
 }
 
 void Evolution::doStep()
 {
+    EIDNN_TRACE_SCOPE( "evolution", "step" );
+
     m_stepCounter++;
 
-    std::lock_guard<std::mutex> guard(m_mutex);
+    std::unique_lock<std::mutex> guard = lock();
+
+    std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+    if( m_epochSteps == 0 )
+        m_epochWallStart = stepStart;
+    m_epochSteps++;
+    const bool wasEpochOver = m_epochOver;
 
-    std::atomic_bool anyAlive = false;
-    std::vector<std::thread> thv;
-    size_t samplesPerThread = m_simulations.size() / m_nbrThreads;
-    for(unsigned int th = 0; th < m_nbrThreads; th++)
+    // aggregated by the stepping threads, merged with the candidates
+    StepStatistics stats;
+    stats.minFitness = std::numeric_limits<double>::max();
+    stats.maxFitness = std::numeric_limits<double>::lowest();
+    double ageSum = 0.0;
+    double fitnessSum = 0.0;
+    size_t nbrOfFitness = 0;
+
+    std::atomic_bool anyStepped{false};
+    std::atomic<size_t> nbrAlive{0};
+    double dt = m_fixedTimeStep;
+    const size_t maxSteps = m_termination.maxStepsPerSimulation;
+    std::vector<size_t> candidates;
+    std::mutex candidatesMutex;
+    m_executor->parallelFor( m_simulations.size(), [&]( size_t startPos, size_t endPos )
     {
-        size_t startPos = th * samplesPerThread;
-        size_t endPos = startPos + samplesPerThread;
-        if( th == m_nbrThreads - 1 ) // last thread till end
-            endPos = m_simulations.size();
+        EIDNN_TRACE_SCOPE( "evolution", "simulate" );
 
-        thv.emplace_back(std::thread( doStepOnFewSimulations, std::ref(m_simulations), std::ref(anyAlive), startPos, endPos ));
-    }
+        // only stepped simulations change their fitness
+        thread_local std::vector<char> stepped;
+        stepped.resize( endPos - startPos );
+        for( size_t k = startPos; k < endPos; k++ )
+            stepped[k - startPos] = m_simulations[k]->isAlive();
+
+        if( m_simFactory->doSteps( m_simulations, startPos, endPos, dt ) )
+            anyStepped = true;
+
+        size_t alive = 0;
+        double age = 0.0;
+        for( size_t k = startPos; k < endPos; k++ )
+        {
+            Simulation* sim = m_simulations[k].get();
+            if( !stepped[k - startPos] || !sim->isAlive() )
+                continue;
+
+            double simAge = sim->getAge();
+            if( ( m_maxSimulationAge > 0.0 && simAge > m_maxSimulationAge ) ||
+                ( maxSteps > 0 && sim->getNumberOfSteps() >= maxSteps ) )
+            {
+                sim->kill();
+            }
+            else
+            {
+                alive++;
+                age += simAge;
+            }
+        }
+        nbrAlive += alive;
+
+        thread_local std::vector<size_t> top;
+        updateFitness( startPos, endPos, stepped.data(), top );
 
-    for( std::thread& th : thv )
-        th.join();
+        double minFitness = std::numeric_limits<double>::max();
+        double maxFitness = std::numeric_limits<double>::lowest();
+        double sum = 0.0;
+        size_t count = 0;
+        for( size_t k = startPos; k < endPos; k++ )
+        {
+            double f = m_fitness[k];
+            if( f == std::numeric_limits<double>::lowest() )
+                continue; // not simulated yet
 
-    if( !anyAlive )
+            minFitness = std::min( minFitness, f );
+            maxFitness = std::max( maxFitness, f );
+            sum += f;
+            count++;
+        }
+
+        std::lock_guard<std::mutex> candidatesLock( candidatesMutex );
+        candidates.insert( candidates.end(), top.begin(), top.end() );
+        stats.minFitness = std::min( stats.minFitness, minFitness );
+        stats.maxFitness = std::max( stats.maxFitness, maxFitness );
+        ageSum += age;
+        fitnessSum += sum;
+        nbrOfFitness += count;
+    });
+    selectTop( candidates );
+
+    if( m_steadyState )
+    {
+        replaceDead();
+        m_epochSimulatedTime += dt;
+    }
+    else if( nbrAlive > 0 )
+    {
+        m_epochSimulatedTime += dt;
+
+        EpochEnd end = checkTermination( nbrAlive );
+        if( end != EpochEnd::Running )
+        {
+            cutOffEpoch();
+            m_lastEpochEnd = end;
+            m_epochOver = true;
+            m_epochCount++;
+        }
+    }
+    else
     {
-        m_epochOver = !anyAlive;
+        if( anyStepped )
+            m_epochSimulatedTime += dt;
+
+        m_lastEpochEnd = EpochEnd::AllDead;
+        m_epochOver = true;
         m_epochCount++;
     }
 
+    stats.step = m_stepStatistics.getNumberOfRecords() + 1;
+    stats.epoch = m_epochCount;
+    stats.alive = nbrAlive;
+    stats.dead = m_simulations.size() - nbrAlive;
+    stats.simulatedTime = m_epochSimulatedTime;
+    stats.stepSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - stepStart ).count();
+    stats.averageAge = nbrAlive > 0 ? ageSum / nbrAlive : 0.0;
+    if( nbrOfFitness > 0 )
+        stats.meanFitness = fitnessSum / nbrOfFitness;
+    else
+        stats.minFitness = stats.maxFitness = 0.0;
+    m_stepStatistics.push( stats );
+
+    // steady state has no epochs ending, the curve would grow forever
+    if( !m_steadyState )
+        m_survival.push_back( uint32_t( nbrAlive ) );
+    if( m_epochOver && !wasEpochOver )
+        recordEpoch();
+
     // update sim speed every 10 steps
     if( m_stepCounter % 20 == 0 )
     {
         std::chrono::milliseconds n = now();
-        m_simSpeed = m_stepCounter / ( (now()-m_simSpeedTime).count() / 1000.0);
+        double seconds = (now()-m_simSpeedTime).count() / 1000.0;
+        m_simSpeed = m_stepCounter / seconds;
+        m_replacementSpeed = m_replacementCounter / seconds;
         m_stepCounter = 0;
+        m_replacementCounter = 0;
         m_simSpeedTime = n;
     }
 }
 
 void Evolution::doEpoch()
 {
+    // the step ending the epoch counts it
     while( !isEpochOver() )
         doStep();
+}
+
+void Evolution::start( StepCallback afterStep, size_t callbackEvery )
+{
+    if( m_running )
+    {
+        std::cout << "Error: Evolution is already running" << std::endl;
+        return;
+    }
+
+    m_running = true;
+    m_thread = std::thread( &Evolution::run, this, afterStep, std::max<size_t>( callbackEvery, 1 ) );
+}
+
+void Evolution::stop()
+{
+    m_running = false;
+    if( m_thread.joinable() )
+        m_thread.join();
+}
 
-    m_epochCount++;
+bool Evolution::isRunning() const
+{
+    return m_running;
+}
+
+void Evolution::run( StepCallback afterStep, size_t callbackEvery )
+{
+    size_t steps = 0;
+    while( m_running )
+    {
+        if( isEpochOver() )
+            breed();
+
+        doStep();
 
+        if( afterStep && ++steps % callbackEvery == 0 )
+        {
+            std::unique_lock<std::mutex> guard = lock();
+            afterStep( m_simulations );
+        }
+    }
 }
 
 bool Evolution::isEpochOver()
@@ -113,40 +340,621 @@ bool Evolution::isEpochOver()
     return m_epochOver;
 }
 
-std::vector<SimulationPtr > Evolution::getSimulationsOrderedByFitness()
+std::vector<SimulationPtr > Evolution::getSimulationsOrderedByFitness( size_t n )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    EIDNN_TRACE_SCOPE( "evolution", "order by fitness" );
+
+    std::vector<size_t> idx( m_simulations.size() );
+    std::iota( idx.begin(), idx.end(), 0 );
+
+    n = std::min( n, idx.size() );
+    auto fitter = [this]( size_t a, size_t b ) { return isFitter( a, b ); };
+    std::partial_sort( idx.begin(), idx.begin() + n, idx.end(), fitter );
+
+    std::vector<SimulationPtr> ord( n );
+    for( size_t k = 0; k < n; k++ )
+        ord[k] = m_simulations[idx[k]];
+    return ord;
+}
+
+std::vector<SimulationPtr> Evolution::getFittest()
+{
+    std::unique_lock<std::mutex> guard = lock();
+
+    std::vector<SimulationPtr> fittest;
+    for( size_t k : m_top )
+        fittest.push_back( m_simulations[k] );
+    return fittest;
+}
+
+void Evolution::setSelection( std::shared_ptr<Selection> selection )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_selection = selection;
+}
+
+std::shared_ptr<Selection> Evolution::getSelection() const
+{
+    return m_selection;
+}
+
+bool Evolution::setEvolutionStrategy( std::shared_ptr<EvolutionStrategy> strategy )
+{
+    std::unique_lock<std::mutex> guard = lock();
+
+    if( strategy && m_nOffsprings < 2 )
+    {
+        std::cout << "Error: Evolution strategy needs at least two offsprings" << std::endl;
+        return false;
+    }
+
+    if( strategy && !m_simulations.empty() &&
+        Genetic::getNumberOfParameters( m_simulations.front()->getNetwork() ) != strategy->getDimension() )
+    {
+        std::cout << "Error: Evolution strategy does not match the dimension of the networks" << std::endl;
+        return false;
+    }
+
+    m_strategy = strategy;
+    m_nbrSampled = 0;
+    return true;
+}
+
+std::shared_ptr<EvolutionStrategy> Evolution::getEvolutionStrategy() const
+{
+    return m_strategy;
+}
+
+size_t Evolution::getTopK() const
+{
+    return m_topK;
+}
+
+void Evolution::setTopK( size_t k )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_topK = std::max<size_t>( k, 2 );
+    selectTopOfAll();
+}
+
+bool Evolution::isFitter( size_t a, size_t b ) const
+{
+    // equal fitnesses by position, so the order is reproducible
+    return m_fitness[a] > m_fitness[b] || ( m_fitness[a] == m_fitness[b] && a < b );
+}
+
+void Evolution::updateFitness( size_t start, size_t end, const char* stepped, std::vector<size_t>& top )
+{
+    // bounded heap, the least fit of the top on front
+    auto fitter = [this]( size_t a, size_t b ) { return isFitter( a, b ); };
+    top.clear();
+    for( size_t k = start; k < end; k++ )
+    {
+        if( stepped[k - start] )
+            m_fitness[k] = m_simulations[k]->getFitness(); // each thread writes its own range
+
+        if( top.size() < m_topK )
+        {
+            top.push_back( k );
+            std::push_heap( top.begin(), top.end(), fitter );
+        }
+        else if( isFitter( k, top.front() ) )
+        {
+            std::pop_heap( top.begin(), top.end(), fitter );
+            top.back() = k;
+            std::push_heap( top.begin(), top.end(), fitter );
+        }
+    }
+}
+
+void Evolution::selectFittest( size_t n, std::vector<size_t>& indices ) const
+{
+    // the top of the epoch is known, sort all only for more
+    n = std::min( n, m_simulations.size() );
+    if( n <= m_top.size() )
+    {
+        indices.assign( m_top.begin(), m_top.begin() + n );
+        return;
+    }
+
+    indices.resize( m_simulations.size() );
+    std::iota( indices.begin(), indices.end(), 0 );
+    auto fitter = [this]( size_t a, size_t b ) { return isFitter( a, b ); };
+    std::partial_sort( indices.begin(), indices.begin() + n, indices.end(), fitter );
+    indices.resize( n );
+}
+
+std::vector<SimulationPtr> Evolution::getElites() const
 {
-    std::lock_guard<std::mutex> guard(m_mutex);
+    // referenced by the result, so breeding does not recycle them
+    std::vector<size_t> indices;
+    selectFittest( m_elitism, indices );
+    std::vector<SimulationPtr> elites;
+    for( size_t k : indices )
+        elites.push_back( m_simulations[k] );
+    return elites;
+}
 
-    std::sort( m_simulations.begin(), m_simulations.end(), [](SimulationPtr a, SimulationPtr b) -> bool {
-        return a->getFitness() > b->getFitness();
-    } );
-    return m_simulations;
+void Evolution::selectTop( std::vector<size_t>& candidates )
+{
+    auto fitter = [this]( size_t a, size_t b ) { return isFitter( a, b ); };
+    size_t n = std::min( m_topK, candidates.size() );
+    std::partial_sort( candidates.begin(), candidates.begin() + n, candidates.end(), fitter );
+    candidates.resize( n );
+    m_top.swap( candidates );
+}
+
+void Evolution::resetFitness()
+{
+    // not simulated yet
+    m_fitness.assign( m_simulations.size(), std::numeric_limits<double>::lowest() );
+    selectTopOfAll();
+}
+
+void Evolution::selectTopOfAll()
+{
+    std::vector<size_t> top( m_simulations.size() );
+    std::iota( top.begin(), top.end(), 0 );
+    selectTop( top );
 }
 
 void Evolution::breed()
 {
-    std::vector<SimulationPtr> ord = getSimulationsOrderedByFitness();
-    SimulationPtr a = ord[0];
-    SimulationPtr b = ord[1];
+    EIDNN_TRACE_SCOPE( "evolution", "breed" );
 
-    if(a->getFitness() > m_fittest->getFitness() )
-        m_fittest = a;
+    std::unique_lock<std::mutex> guard = lock();
+    std::chrono::steady_clock::time_point breedStart = std::chrono::steady_clock::now();
+
+    if( m_strategy )
+    {
+        breedFromStrategy();
+        m_breedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - breedStart ).count();
+        return;
+    }
+
+    // candidates ordered by fitness, best first
+    std::vector<size_t> candidates;
+    selectFittest( m_selection->getNumberOfCandidates( m_simulations.size() ), candidates );
+
+    if( candidates.size() < 2 )
+    {
+        std::cout << "Error: Breeding needs two simulations" << std::endl;
+        return;
+    }
+
+    if( m_fitness[candidates[0]] > m_fittestFitness )
+    {
+        m_fittest = m_simulations[candidates[0]];
+        m_fittestFitness = m_fitness[candidates[0]];
+    }
+
+    std::vector<double> fitness( candidates.size() );
+    for( size_t k = 0; k < candidates.size(); k++ )
+        fitness[k] = m_fitness[candidates[k]];
+    m_selection->prepare( fitness );
+
+    // the parents of each offspring, drawn up front so the selected
+    // simulations are not recycled
+    std::vector<std::pair<size_t, size_t>> parents( m_nOffsprings );
+    std::vector<SimulationPtr> selected( m_simulations.size() );
+    std::mt19937& gen = Helpers::randomGenerator();
+    for( std::pair<size_t, size_t>& p : parents )
+    {
+        p = m_selection->selectParents( gen );
+        p.first = candidates[p.first];
+        p.second = candidates[p.second];
+        selected[p.first] = m_simulations[p.first];
+        selected[p.second] = m_simulations[p.second];
+    }
+
+    std::vector<SimulationPtr> elites = getElites();
+
+    // Simulations only referenced by this evolution can be reused. The parents
+    // and everything handed out (e.g. to a GUI) are referenced elsewhere too.
+    std::vector<SimulationPtr> recyclable;
+    for( SimulationPtr& s : m_simulations )
+        if( s.use_count() == 1 )
+            recyclable.push_back( std::move(s) );
+
+    m_simulations.clear();
+    m_simulations.resize(m_nOffsprings);
+
+    // every offspring gets its own seed, so the result does not depend on
+    // which thread computes it
+    std::vector<unsigned int> seeds(m_nOffsprings);
+    for( unsigned int& seed : seeds )
+        seed = gen();
+
+    m_executor->parallelFor( m_nOffsprings, [&]( size_t startPos, size_t endPos )
+    {
+        // the calling thread takes part as well, its sequence must not depend on the scheduling
+        std::mt19937 former = Helpers::randomGenerator();
+
+        for( size_t k = startPos; k < endPos; k++ )
+        {
+            Helpers::seedRandomGenerator( seeds[k] );
+            SimulationPtr recycled = k < recyclable.size() ? std::move(recyclable[k]) : SimulationPtr();
+            m_simulations[k] = m_simFactory->recycleCrossover( recycled, selected[parents[k].first],
+                                                               selected[parents[k].second], m_mutationRate );
+        }
+
+        Helpers::randomGenerator() = former;
+    });
 
+    // add the best unchanged to the next epoch
+    for( const SimulationPtr& elite : elites )
+        m_simulations.push_back(m_simFactory->copy(elite));
 
-    std::lock_guard<std::mutex> guard(m_mutex);
+    resetFitness();
+    startEpoch();
+    m_breedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - breedStart ).count();
+}
+
+void Evolution::breedFromStrategy()
+{
+    if( m_simulations.size() < 2 )
+    {
+        std::cout << "Error: Breeding needs two simulations" << std::endl;
+        return;
+    }
+
+    // Only the offsprings sampled from the strategy are evaluated candidates,
+    // the others were not drawn from its distribution. The first epoch has
+    // none, its offsprings are sampled from the initial distribution.
+    size_t nbrOfCandidates = std::min( m_nbrSampled, m_simulations.size() );
+    if( nbrOfCandidates > 0 )
+    {
+        std::vector<Eigen::VectorXd> candidates( nbrOfCandidates );
+        m_executor->parallelFor( nbrOfCandidates, [&]( size_t startPos, size_t endPos )
+        {
+            for( size_t k = startPos; k < endPos; k++ )
+                candidates[k] = Genetic::getParameterVector( m_simulations[k]->getNetwork() );
+        });
+
+        // on failure the offsprings are sampled from the unchanged
+        // distribution, the run continues
+        std::vector<double> fitness( m_fitness.begin(), m_fitness.begin() + nbrOfCandidates );
+        m_strategy->update( candidates, fitness );
+    }
+
+    SimulationPtr a = m_simulations[m_top[0]];
+    std::vector<SimulationPtr> elites = getElites();
+
+    if( m_fitness[m_top[0]] > m_fittestFitness )
+    {
+        m_fittest = a;
+        m_fittestFitness = m_fitness[m_top[0]];
+    }
+
+    std::vector<SimulationPtr> recyclable;
+    for( SimulationPtr& s : m_simulations )
+        if( s.use_count() == 1 )
+            recyclable.push_back( std::move(s) );
 
     m_simulations.clear();
+    m_simulations.resize(m_nOffsprings);
+
+    std::vector<unsigned int> seeds(m_nOffsprings);
+    std::mt19937& gen = Helpers::randomGenerator();
+    for( unsigned int& seed : seeds )
+        seed = gen();
+
+    m_executor->parallelFor( m_nOffsprings, [&]( size_t startPos, size_t endPos )
+    {
+        std::mt19937 former = Helpers::randomGenerator();
+        Eigen::VectorXd x;
+
+        for( size_t k = startPos; k < endPos; k++ )
+        {
+            Helpers::seedRandomGenerator( seeds[k] );
+            m_strategy->sample( x, Helpers::randomGenerator() );
+            SimulationPtr recycled = k < recyclable.size() ? std::move(recyclable[k]) : SimulationPtr();
+            m_simulations[k] = m_simFactory->recycleWithParameters( recycled, a, x );
+        }
+
+        Helpers::randomGenerator() = former;
+    });
+
+    m_nbrSampled = m_nOffsprings;
+    for( const SimulationPtr& elite : elites )
+        m_simulations.push_back(m_simFactory->copy(elite));
+
+    resetFitness();
+    startEpoch();
+}
 
-    std::generate_n(std::back_inserter(m_simulations), m_nOffsprings, [=]()->SimulationPtr { return m_simFactory->createCrossover(a,b,m_mutationRate); });
+Evolution::EpochEnd Evolution::checkTermination( size_t nbrAlive )
+{
+    const EpochTermination& t = m_termination;
+
+    if( t.maxSimulatedTime > 0.0 && m_epochSimulatedTime >= t.maxSimulatedTime )
+        return EpochEnd::SimulatedTime;
 
-    // add parents to the next epoch
-    if( m_keepParents )
+    if( t.maxWallTime > 0.0 &&
+        std::chrono::duration<double>( std::chrono::steady_clock::now() - m_epochWallStart ).count() >= t.maxWallTime )
+        return EpochEnd::WallTime;
+
+    // leader improvement
+    double leader = m_top.empty() ? std::numeric_limits<double>::lowest() : m_fitness[m_top.front()];
+    if( m_leaderFitness == std::numeric_limits<double>::lowest() ||
+        leader > m_leaderFitness + t.convergenceTolerance * std::abs( m_leaderFitness ) )
     {
-        m_simulations.push_back(m_simFactory->copy(a));
-        m_simulations.push_back(m_simFactory->copy(b));
+        m_leaderFitness = leader;
+        m_leaderImprovedStep = m_epochSteps;
+    }
+
+    if( t.deadFraction > 0.0 || t.convergenceSteps > 0 )
+    {
+        double deadFraction = 1.0 - double( nbrAlive ) / double( m_simulations.size() );
+        bool converged = m_epochSteps - m_leaderImprovedStep >= t.convergenceSteps;
+        if( deadFraction >= t.deadFraction && converged )
+            return EpochEnd::Converged;
+    }
+
+    return EpochEnd::Running;
+}
+
+void Evolution::cutOffEpoch()
+{
+    // the fitness of the survivors is taken as it is now
+    for( size_t k = 0; k < m_simulations.size(); k++ )
+    {
+        if( m_simulations[k]->isAlive() )
+        {
+            m_simulations[k]->kill();
+            m_fitness[k] = m_simulations[k]->getFitness();
+        }
     }
+    selectTopOfAll();
+}
 
+void Evolution::startEpoch()
+{
+    m_survival.clear();
     m_epochOver = false;
+    m_epochSimulatedTime = 0.0;
+    m_epochSteps = 0;
+    m_leaderFitness = std::numeric_limits<double>::lowest();
+    m_leaderImprovedStep = 0;
+}
+
+void Evolution::recordEpoch()
+{
+    EpochStatistics stats;
+    stats.epoch = m_epochCount;
+    stats.steps = m_epochSteps;
+    stats.simulations = m_simulations.size();
+    stats.end = m_lastEpochEnd;
+    stats.simulatedTime = m_epochSimulatedTime;
+    stats.wallSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - m_epochWallStart ).count();
+    stats.breedSeconds = m_breedSeconds;
+
+    // once per epoch, from the cached fitness
+    m_fitnessBuffer.clear();
+    for( double f : m_fitness )
+        if( f != std::numeric_limits<double>::lowest() )
+            m_fitnessBuffer.push_back( f );
+
+    if( !m_fitnessBuffer.empty() )
+    {
+        auto minMax = std::minmax_element( m_fitnessBuffer.begin(), m_fitnessBuffer.end() );
+        stats.minFitness = *minMax.first;
+        stats.maxFitness = *minMax.second;
+        stats.meanFitness = std::accumulate( m_fitnessBuffer.begin(), m_fitnessBuffer.end(), 0.0 ) / m_fitnessBuffer.size();
+
+        // ascending levels, each selection only reorders the part above the former
+        auto begin = m_fitnessBuffer.begin();
+        for( size_t k = 0; k < EpochStatistics::NumberOfPercentiles; k++ )
+        {
+            auto nth = m_fitnessBuffer.begin() + size_t( EpochStatistics::percentileLevel( k ) * ( m_fitnessBuffer.size() - 1 ) );
+            std::nth_element( begin, nth, m_fitnessBuffer.end() );
+            stats.fitnessPercentiles[k] = *nth;
+            begin = nth;
+        }
+    }
+
+    if( !m_survival.empty() && !m_simulations.empty() )
+    {
+        for( size_t k = 0; k < EpochStatistics::SurvivalPoints; k++ )
+        {
+            size_t step = k * ( m_survival.size() - 1 ) / ( EpochStatistics::SurvivalPoints - 1 );
+            stats.survival[k] = double( m_survival[step] ) / m_simulations.size();
+        }
+    }
+
+    m_epochStatistics.push( stats );
+}
+
+double Evolution::EpochStatistics::percentileLevel( size_t k )
+{
+    static const double levels[NumberOfPercentiles] = { 0.1, 0.25, 0.5, 0.75, 0.9 };
+    return levels[k];
+}
+
+std::vector<Evolution::StepStatistics> Evolution::getStepStatistics( size_t n ) const
+{
+    return m_stepStatistics.getLatest( n );
+}
+
+std::vector<Evolution::EpochStatistics> Evolution::getEpochStatistics( size_t n ) const
+{
+    return m_epochStatistics.getLatest( n );
+}
+
+void Evolution::setEpochTermination( const EpochTermination& termination )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_termination = termination;
+}
+
+Evolution::EpochTermination Evolution::getEpochTermination() const
+{
+    return m_termination;
+}
+
+Evolution::EpochEnd Evolution::getLastEpochEnd() const
+{
+    return m_lastEpochEnd;
+}
+
+void Evolution::replaceDead()
+{
+    EIDNN_TRACE_SCOPE( "evolution", "replace" );
+
+    std::vector<size_t> dead;
+    for( size_t k = 0; k < m_simulations.size(); k++ )
+        if( !m_simulations[k]->isAlive() )
+            dead.push_back( k );
+
+    if( dead.empty() )
+        return;
+
+    for( size_t k : dead )
+        addToArchive( m_fitness[k], m_simulations[k] );
+
+    // parents and seeds are drawn in order, so the result does not depend on the threads
+    struct Replacement
+    {
+        SimulationPtr a;
+        SimulationPtr b;
+        unsigned int seed;
+    };
+    std::vector<Replacement> replacements( dead.size() );
+    std::mt19937& gen = Helpers::randomGenerator();
+    for( Replacement& r : replacements )
+    {
+        if( m_archive.size() >= 2 )
+        {
+            r.a = tournament( gen );
+            r.b = tournament( gen );
+        }
+        r.seed = gen();
+    }
+
+    m_executor->parallelFor( dead.size(), [&]( size_t startPos, size_t endPos )
+    {
+        std::mt19937 former = Helpers::randomGenerator();
+
+        for( size_t k = startPos; k < endPos; k++ )
+        {
+            Helpers::seedRandomGenerator( replacements[k].seed );
+            SimulationPtr& sim = m_simulations[dead[k]];
+
+            // archived simulations are referenced by the archive as well
+            SimulationPtr recycled = sim.use_count() == 1 ? std::move( sim ) : SimulationPtr();
+            if( replacements[k].a )
+                sim = m_simFactory->recycleCrossover( recycled, replacements[k].a, replacements[k].b, m_mutationRate );
+            else
+                sim = m_simFactory->createRandomSimulation(); // archive not filled yet
+
+            m_fitness[dead[k]] = std::numeric_limits<double>::lowest();
+        }
+
+        Helpers::randomGenerator() = former;
+    });
+
+    m_replacementCount += dead.size();
+    m_replacementCounter += dead.size();
+
+    selectTopOfAll();
+}
+
+void Evolution::addToArchive( double fitness, const SimulationPtr& sim )
+{
+    // never simulated
+    if( fitness == std::numeric_limits<double>::lowest() )
+        return;
+
+    if( m_archive.size() >= m_archiveSize && !( fitness > m_archive.back().fitness ) )
+        return;
+
+    // behind equal fitnesses, the older ones stay in front
+    auto pos = std::upper_bound( m_archive.begin(), m_archive.end(), fitness,
+                                 []( double f, const ArchiveEntry& e ) { return f > e.fitness; } );
+    m_archive.insert( pos, ArchiveEntry{ fitness, sim } );
+
+    if( m_archive.size() > m_archiveSize )
+        m_archive.pop_back();
+}
+
+SimulationPtr Evolution::tournament( std::mt19937& gen ) const
+{
+    // the archive is ordered, the smallest index wins
+    std::uniform_int_distribution<size_t> dist( 0, m_archive.size() - 1 );
+    size_t winner = dist( gen );
+    for( size_t k = 1; k < m_tournamentSize; k++ )
+        winner = std::min( winner, dist( gen ) );
+
+    return m_archive[winner].simulation;
+}
+
+void Evolution::setSteadyState( bool steadyState )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_steadyState = steadyState;
+    if( steadyState )
+        m_epochOver = false;
+}
+
+bool Evolution::isSteadyState() const
+{
+    return m_steadyState;
+}
+
+void Evolution::setArchiveSize( size_t size )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_archiveSize = std::max<size_t>( size, 2 );
+    if( m_archive.size() > m_archiveSize )
+        m_archive.resize( m_archiveSize );
+}
+
+size_t Evolution::getArchiveSize() const
+{
+    return m_archiveSize;
+}
+
+void Evolution::setTournamentSize( size_t size )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_tournamentSize = std::max<size_t>( size, 1 );
+}
+
+size_t Evolution::getTournamentSize() const
+{
+    return m_tournamentSize;
+}
+
+std::vector<SimulationPtr> Evolution::getArchive()
+{
+    std::unique_lock<std::mutex> guard = lock();
+
+    std::vector<SimulationPtr> archive;
+    for( const ArchiveEntry& e : m_archive )
+        archive.push_back( e.simulation );
+    return archive;
+}
+
+size_t Evolution::getNumberOfReplacements() const
+{
+    return m_replacementCount;
+}
+
+double Evolution::getReplacementsPerSecond() const
+{
+    return m_replacementSpeed;
+}
+
+void Evolution::setMaxSimulationAge( double age )
+{
+    std::unique_lock<std::mutex> guard = lock();
+    m_maxSimulationAge = age;
+}
+
+double Evolution::getMaxSimulationAge() const
+{
+    return m_maxSimulationAge;
 }
 
 size_t Evolution::getNumberOfEpochs() const
@@ -161,6 +969,7 @@ double Evolution::getMutationRate() const
 
 void Evolution::setMutationRate(double mutationRate)
 {
+    std::unique_lock<std::mutex> guard = lock();
     m_mutationRate = mutationRate;
 }
 
@@ -186,7 +995,7 @@ double Evolution::getSimulationsAverageAge() const
 
 void Evolution::killAllSimulations()
 {
-    std::lock_guard<std::mutex> guard(m_mutex);
+    std::unique_lock<std::mutex> guard = lock();
     for( auto m: m_simulations )
         m->kill();
 }
@@ -202,27 +1011,53 @@ std::chrono::milliseconds Evolution::now() const
             std::chrono::system_clock::now().time_since_epoch());
 }
 
+void Evolution::setFixedTimeStep( double dt )
+{
+    m_fixedTimeStep = std::max( dt, 0.0 );
+}
+
+double Evolution::getFixedTimeStep() const
+{
+    return m_fixedTimeStep;
+}
+
+double Evolution::getEpochSimulatedTime() const
+{
+    return m_epochSimulatedTime;
+}
+
 void Evolution::resetFactory(SimFactoryPtr simFactory)
 {
+    std::unique_lock<std::mutex> guard = lock();
     m_simFactory = simFactory;
 }
 
 bool Evolution::isKeepParents() const
 {
-    return m_keepParents;
+    return m_elitism > 0;
 }
 
 void Evolution::setKeepParents(bool keepParents)
 {
-    m_keepParents = keepParents;
+    m_elitism = keepParents ? 2 : 0;
+}
+
+size_t Evolution::getElitism() const
+{
+    return m_elitism;
+}
+
+void Evolution::setElitism(size_t n)
+{
+    m_elitism = n;
 }
 
 bool Evolution::save(const std::string &a_path, const std::string &b_path)
 {
-    // get the two fittest
-    std::vector<SimulationPtr> ord = getSimulationsOrderedByFitness();
+    // get the two fittest, in steady state the best finished ones
+    std::vector<SimulationPtr> ord = m_steadyState ? getArchive() : getFittest();
 
-    std::lock_guard<std::mutex> guard(m_mutex);
+    std::unique_lock<std::mutex> guard = lock();
 
     if( ord.size() < 2 )
     {
@@ -246,7 +1081,7 @@ bool Evolution::load(const std::string &a_path, const std::string &b_path)
 {
     killAllSimulations();
 
-    std::lock_guard<std::mutex> guard(m_mutex);
+    std::unique_lock<std::mutex> guard = lock();
 
     NetworkPtr aNet( Network::load( a_path ));
     NetworkPtr bNet(Network::load( b_path ));
@@ -266,8 +1101,288 @@ bool Evolution::load(const std::string &a_path, const std::string &b_path)
     m_simulations.clear();
     m_simulations.push_back(a);
     m_simulations.push_back(b);
+    m_nbrSampled = 0;
+    resetFitness();
+    startEpoch();
+
+    return true;
+}
+
+void Evolution::immigrate( const std::vector<NetworkPtr>& networks )
+{
+    std::unique_lock<std::mutex> guard = lock();
+
+    for( const NetworkPtr& net : networks )
+    {
+        m_simulations.push_back( m_simFactory->createSimulation( net ) );
+        m_fitness.push_back( std::numeric_limits<double>::lowest() );
+    }
+    selectTopOfAll();
+}
+
+std::shared_ptr<Evolution::Checkpoint> Evolution::takeCheckpoint()
+{
+    std::unique_lock<std::mutex> guard = lock();
+
+    std::shared_ptr<Checkpoint> cp( new Checkpoint() );
+    CheckpointHeader& h = cp->header;
+    std::memset( &h, 0, sizeof(h) );
+    std::memcpy( h.magic, checkpointMagic, sizeof(checkpointMagic) );
+    h.version = checkpointVersion;
+    h.flags = ( m_epochOver ? EpochOverFlag : 0 ) | ( m_steadyState ? SteadyStateFlag : 0 );
+    h.epochCount = m_epochCount;
+    h.nInitials = m_nInitials;
+    h.nOffsprings = m_nOffsprings;
+    h.nbrOfSimulations = m_simulations.size();
+    h.nbrOfArchived = m_archive.size();
+    h.replacementCount = m_replacementCount;
+    h.topK = m_topK;
+    h.elitism = m_elitism;
+    h.archiveSize = m_archiveSize;
+    h.tournamentSize = m_tournamentSize;
+    h.mutationRate = m_mutationRate;
+    h.fixedTimeStep = m_fixedTimeStep;
+    h.lastEpochEnd = uint32_t( m_lastEpochEnd );
+
+    std::ostringstream rng;
+    rng << Helpers::randomGenerator();
+    cp->rng = rng.str();
+    h.rngSize = uint32_t( cp->rng.size() );
+
+    for( size_t k = 0; k < m_simulations.size(); k++ )
+    {
+        cp->networks.push_back( NetworkPtr( new Network( *m_simulations[k]->getNetwork() ) ) );
+        cp->fitness.push_back( m_fitness[k] );
+    }
+    for( const ArchiveEntry& e : m_archive )
+    {
+        cp->networks.push_back( NetworkPtr( new Network( *e.simulation->getNetwork() ) ) );
+        cp->fitness.push_back( e.fitness );
+    }
+    cp->networks.push_back( NetworkPtr( new Network( *m_fittest->getNetwork() ) ) );
+    cp->fitness.push_back( m_fittestFitness );
+
+    return cp;
+}
+
+bool Evolution::writeCheckpoint( const Checkpoint& checkpoint, const std::string& path )
+{
+    EIDNN_TRACE_SCOPE( "evolution", "write checkpoint" );
+
+    std::vector<std::string> genomes( checkpoint.networks.size() );
+    std::vector<GenomeEntry> entries( checkpoint.networks.size() );
+    uint64_t offset = 0;
+    for( size_t k = 0; k < genomes.size(); k++ )
+    {
+        genomes[k] = checkpoint.networks[k]->serialize();
+        entries[k].offset = offset;
+        entries[k].size = genomes[k].size();
+        entries[k].fitness = checkpoint.fitness[k];
+        offset += genomes[k].size();
+    }
+
+    CheckpointHeader header = checkpoint.header;
+    header.blobSize = offset;
+
+    // written completely before it replaces the former checkpoint
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out( tmpPath, std::ios::binary | std::ios::trunc );
+        out.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+        out.write( checkpoint.rng.data(), checkpoint.rng.size() );
+        out.write( reinterpret_cast<const char*>( entries.data() ), entries.size() * sizeof(GenomeEntry) );
+        for( const std::string& g : genomes )
+            out.write( g.data(), g.size() );
+
+        if( !out )
+        {
+            std::cout << "Error: Could not write checkpoint " << tmpPath << std::endl;
+            std::remove( tmpPath.c_str() );
+            return false;
+        }
+    }
+
+    if( std::rename( tmpPath.c_str(), path.c_str() ) != 0 )
+    {
+        std::cout << "Error: Could not write checkpoint " << path << std::endl;
+        std::remove( tmpPath.c_str() );
+        return false;
+    }
 
     return true;
 }
 
+bool Evolution::saveCheckpoint( const std::string& path )
+{
+    waitForCheckpoint();
+    return writeCheckpoint( *takeCheckpoint(), path );
+}
+
+bool Evolution::saveCheckpointAsync( const std::string& path )
+{
+    bool written = waitForCheckpoint();
+
+    std::shared_ptr<Checkpoint> cp = takeCheckpoint();
+    m_checkpointThread = std::thread( [this, cp, path]()
+    {
+        m_checkpointWritten = writeCheckpoint( *cp, path );
+    });
 
+    return written;
+}
+
+bool Evolution::waitForCheckpoint()
+{
+    if( m_checkpointThread.joinable() )
+        m_checkpointThread.join();
+
+    bool written = m_checkpointWritten;
+    m_checkpointWritten = true;
+    return written;
+}
+
+bool Evolution::loadCheckpoint( const std::string& path )
+{
+    EIDNN_TRACE_SCOPE( "evolution", "load checkpoint" );
+
+    int fd = open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+    {
+        std::cout << "Error: Could not open checkpoint " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || size_t(st.st_size) < sizeof(CheckpointHeader) )
+    {
+        close( fd );
+        std::cout << "Error: Invalid checkpoint " << path << std::endl;
+        return false;
+    }
+
+    size_t size = size_t(st.st_size);
+    void* addr = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if( addr == MAP_FAILED )
+    {
+        std::cout << "Error: Could not map checkpoint " << path << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<void> mapping( addr, [size]( void* p ) { munmap( p, size ); } );
+    const char* data = static_cast<const char*>( addr );
+
+    CheckpointHeader h;
+    std::memcpy( &h, data, sizeof(h) );
+
+    // Every count is checked against the file size before it is used in a
+    // sum, so a corrupt header cannot wrap around and pass.
+    const size_t entriesPos = sizeof(CheckpointHeader) + h.rngSize;
+    if( std::memcmp( h.magic, checkpointMagic, sizeof(checkpointMagic) ) != 0 || h.version != checkpointVersion ||
+        h.nbrOfSimulations < 2 || h.nbrOfSimulations > size || h.nbrOfArchived > size || entriesPos > size ||
+        h.lastEpochEnd > uint32_t( EpochEnd::Converged ) )
+    {
+        std::cout << "Error: Outdated or corrupt checkpoint " << path << std::endl;
+        return false;
+    }
+
+    const size_t nbrOfGenomes = h.nbrOfSimulations + h.nbrOfArchived + 1;
+    if( ( size - entriesPos ) / sizeof(GenomeEntry) < nbrOfGenomes ||
+        h.blobSize != size - entriesPos - nbrOfGenomes * sizeof(GenomeEntry) )
+    {
+        std::cout << "Error: Outdated or corrupt checkpoint " << path << std::endl;
+        return false;
+    }
+    const size_t blobPos = entriesPos + nbrOfGenomes * sizeof(GenomeEntry);
+
+    std::vector<GenomeEntry> entries( nbrOfGenomes );
+    std::memcpy( entries.data(), data + entriesPos, entries.size() * sizeof(GenomeEntry) );
+    for( const GenomeEntry& e : entries )
+    {
+        if( e.offset > h.blobSize || e.size > h.blobSize - e.offset )
+        {
+            std::cout << "Error: Corrupt checkpoint " << path << std::endl;
+            return false;
+        }
+    }
+
+    std::mt19937 rng;
+    std::istringstream rngStream( std::string( data + sizeof(CheckpointHeader), h.rngSize ) );
+    rngStream >> rng;
+    if( rngStream.fail() )
+    {
+        std::cout << "Error: Corrupt random generator state in checkpoint " << path << std::endl;
+        return false;
+    }
+
+    // deserializing and creating the simulations is the expensive part
+    const char* blob = data + blobPos;
+    std::vector<SimulationPtr> sims( nbrOfGenomes );
+    std::atomic<bool> corrupt( false );
+    m_executor->parallelFor( nbrOfGenomes, [&]( size_t startPos, size_t endPos )
+    {
+        for( size_t k = startPos; k < endPos; k++ )
+        {
+            NetworkPtr net( Network::deserialize( std::string( blob + entries[k].offset, entries[k].size ) ) );
+            if( !net )
+            {
+                corrupt = true;
+                continue;
+            }
+            sims[k] = m_simFactory->createSimulation( net );
+        }
+    });
+
+    if( corrupt )
+    {
+        std::cout << "Error: Corrupt genome in checkpoint " << path << std::endl;
+        return false;
+    }
+
+    killAllSimulations();
+
+    std::unique_lock<std::mutex> guard = lock();
+
+    m_simulations.assign( sims.begin(), sims.begin() + h.nbrOfSimulations );
+    m_nbrSampled = 0;
+    m_archive.clear();
+    for( size_t k = h.nbrOfSimulations; k < nbrOfGenomes - 1; k++ )
+        m_archive.push_back( ArchiveEntry{ entries[k].fitness, sims[k] } );
+    m_fittest = sims.back();
+    m_fittestFitness = entries.back().fitness;
+
+    m_epochCount = h.epochCount;
+    m_nInitials = h.nInitials;
+    m_nOffsprings = h.nOffsprings;
+    m_replacementCount = h.replacementCount;
+    // the limits of the setters
+    m_topK = std::max<uint64_t>( h.topK, 2 );
+    m_archiveSize = std::max<uint64_t>( h.archiveSize, 2 );
+    m_tournamentSize = std::max<uint64_t>( h.tournamentSize, 1 );
+    m_mutationRate = h.mutationRate;
+    m_fixedTimeStep = h.fixedTimeStep;
+    m_steadyState = ( h.flags & SteadyStateFlag ) != 0;
+    m_elitism = h.elitism;
+    Helpers::randomGenerator() = rng;
+
+    if( h.flags & EpochOverFlag )
+    {
+        // finished epoch, ready for breed()
+        for( const SimulationPtr& sim : m_simulations )
+            sim->kill();
+        m_fitness.resize( m_simulations.size() );
+        for( size_t k = 0; k < m_simulations.size(); k++ )
+            m_fitness[k] = entries[k].fitness;
+        selectTopOfAll();
+        m_epochOver = true;
+        m_lastEpochEnd = EpochEnd( h.lastEpochEnd );
+    }
+    else
+    {
+        resetFitness();
+        startEpoch();
+    }
+
+    return true;
+}
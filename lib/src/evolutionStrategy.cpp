@@ -0,0 +1,211 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "evolutionStrategy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+EvolutionStrategy::EvolutionStrategy( const Eigen::VectorXd& mean, double sigma, Covariance covariance )
+: m_covariance( covariance ),
+  m_n( size_t( mean.size() ) ),
+  m_mean( mean ),
+  m_sigma( sigma ),
+  m_pathSigma( Eigen::VectorXd::Zero( mean.size() ) ),
+  m_pathC( Eigen::VectorXd::Zero( mean.size() ) ),
+  m_generation( 0 ),
+  m_evaluations( 0 ),
+  m_decomposedAt( 0 )
+{
+    if( m_covariance == Full )
+    {
+        m_C = Eigen::MatrixXd::Identity( m_n, m_n );
+        m_B = Eigen::MatrixXd::Identity( m_n, m_n );
+        m_D = Eigen::VectorXd::Ones( m_n );
+        m_BD = Eigen::MatrixXd::Identity( m_n, m_n );
+    }
+    else
+    {
+        m_diagC = Eigen::VectorXd::Ones( m_n );
+    }
+}
+
+void EvolutionStrategy::sample( Eigen::VectorXd& x, std::mt19937& gen ) const
+{
+    std::normal_distribution<double> normal( 0.0, 1.0 );
+
+    Eigen::VectorXd z( m_n );
+    for( size_t i = 0; i < m_n; i++ )
+        z(i) = normal( gen );
+
+    if( m_covariance == Full )
+        x = m_mean + m_sigma * ( m_BD * z );
+    else
+        x = m_mean + m_sigma * ( m_diagC.cwiseSqrt().cwiseProduct( z ) );
+}
+
+bool EvolutionStrategy::update( const std::vector<Eigen::VectorXd>& candidates, const std::vector<double>& fitness )
+{
+    const size_t lambda = candidates.size();
+    if( lambda < 2 || fitness.size() != lambda )
+    {
+        std::cout << "Error: Evolution strategy needs at least two evaluated candidates" << std::endl;
+        return false;
+    }
+
+    for( const Eigen::VectorXd& x : candidates )
+    {
+        if( size_t( x.size() ) != m_n )
+        {
+            std::cout << "Error: Candidate does not match the dimension of the evolution strategy" << std::endl;
+            return false;
+        }
+    }
+
+    // best first
+    std::vector<size_t> order( lambda );
+    std::iota( order.begin(), order.end(), 0 );
+    std::stable_sort( order.begin(), order.end(), [&fitness]( size_t a, size_t b ) { return fitness[a] > fitness[b]; } );
+
+    // log-linear recombination weights of the better half
+    const size_t mu = lambda / 2;
+    Eigen::VectorXd w( mu );
+    for( size_t i = 0; i < mu; i++ )
+        w(i) = std::log( double( mu ) + 0.5 ) - std::log( double( i + 1 ) );
+    w /= w.sum();
+    const double mueff = 1.0 / w.squaredNorm();
+
+    // strategy parameters, Hansen's defaults
+    const double n = double( m_n );
+    const double cc = ( 4.0 + mueff / n ) / ( n + 4.0 + 2.0 * mueff / n );
+    const double cs = ( mueff + 2.0 ) / ( n + mueff + 5.0 );
+    double c1 = 2.0 / ( ( n + 1.3 ) * ( n + 1.3 ) + mueff );
+    double cmu = std::min( 1.0 - c1, 2.0 * ( mueff - 2.0 + 1.0 / mueff ) / ( ( n + 2.0 ) * ( n + 2.0 ) + mueff ) );
+    if( m_covariance == Diagonal )
+    {
+        // the diagonal model learns faster
+        c1 = std::min( 1.0, c1 * ( n + 2.0 ) / 3.0 );
+        cmu = std::min( 1.0 - c1, cmu * ( n + 2.0 ) / 3.0 );
+    }
+    const double damps = 1.0 + 2.0 * std::max( 0.0, std::sqrt( ( mueff - 1.0 ) / ( n + 1.0 ) ) - 1.0 ) + cs;
+    const double chiN = std::sqrt( n ) * ( 1.0 - 1.0 / ( 4.0 * n ) + 1.0 / ( 21.0 * n * n ) );
+
+    // steps of the selected candidates, in units of sigma
+    Eigen::MatrixXd y( m_n, mu );
+    for( size_t i = 0; i < mu; i++ )
+        y.col( i ) = ( candidates[order[i]] - m_mean ) / m_sigma;
+
+    Eigen::VectorXd yw = y * w;
+    m_mean += m_sigma * yw;
+
+    // C^-1/2 * yw
+    Eigen::VectorXd whitened;
+    if( m_covariance == Full )
+        whitened = m_B * ( m_B.transpose() * yw ).cwiseQuotient( m_D );
+    else
+        whitened = yw.cwiseQuotient( m_diagC.cwiseSqrt() );
+
+    m_pathSigma = ( 1.0 - cs ) * m_pathSigma + std::sqrt( cs * ( 2.0 - cs ) * mueff ) * whitened;
+
+    m_generation++;
+    m_evaluations += lambda;
+
+    const double psNorm = m_pathSigma.norm() / std::sqrt( 1.0 - std::pow( 1.0 - cs, 2.0 * double( m_generation ) ) );
+    const bool hsig = psNorm / chiN < 1.4 + 2.0 / ( n + 1.0 );
+
+    m_pathC = ( 1.0 - cc ) * m_pathC;
+    if( hsig )
+        m_pathC += std::sqrt( cc * ( 2.0 - cc ) * mueff ) * yw;
+
+    const double correction = hsig ? 0.0 : c1 * cc * ( 2.0 - cc );
+
+    if( m_covariance == Full )
+    {
+        m_C = ( 1.0 - c1 - cmu + correction ) * m_C
+              + c1 * m_pathC * m_pathC.transpose()
+              + cmu * y * w.asDiagonal() * y.transpose();
+
+        // the decomposition is O(n^3), not needed every generation
+        if( double( m_evaluations - m_decomposedAt ) > double( lambda ) / ( c1 + cmu ) / n / 10.0 )
+            decompose();
+    }
+    else
+    {
+        m_diagC = ( 1.0 - c1 - cmu + correction ) * m_diagC
+                  + c1 * m_pathC.cwiseAbs2()
+                  + cmu * y.cwiseAbs2() * w;
+    }
+
+    m_sigma *= std::exp( ( cs / damps ) * ( m_pathSigma.norm() / chiN - 1.0 ) );
+
+    return true;
+}
+
+void EvolutionStrategy::decompose()
+{
+    m_decomposedAt = m_evaluations;
+
+    // enforce symmetry
+    Eigen::MatrixXd C = m_C.triangularView<Eigen::Upper>();
+    C.triangularView<Eigen::StrictlyLower>() = C.transpose().triangularView<Eigen::StrictlyLower>();
+    m_C = C;
+
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig( m_C );
+    m_B = eig.eigenvectors();
+    m_D = eig.eigenvalues().cwiseMax( 1e-20 ).cwiseSqrt();
+    m_BD = m_B * m_D.asDiagonal();
+}
+
+const Eigen::VectorXd& EvolutionStrategy::getMean() const
+{
+    return m_mean;
+}
+
+double EvolutionStrategy::getSigma() const
+{
+    return m_sigma;
+}
+
+size_t EvolutionStrategy::getDimension() const
+{
+    return m_n;
+}
+
+EvolutionStrategy::Covariance EvolutionStrategy::getCovariance() const
+{
+    return m_covariance;
+}
+
+size_t EvolutionStrategy::getNumberOfGenerations() const
+{
+    return m_generation;
+}
+
+Eigen::VectorXd EvolutionStrategy::getVariances() const
+{
+    if( m_covariance == Full )
+        return m_sigma * m_sigma * m_C.diagonal();
+    return m_sigma * m_sigma * m_diagC;
+}
@@ -0,0 +1,138 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "executor.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+Executor::Executor( size_t nbrOfThreads )
+{
+    if( nbrOfThreads == 0 )
+        nbrOfThreads = std::max( 1u, std::thread::hardware_concurrency() );
+
+    for( size_t k = 0; k < nbrOfThreads; k++ )
+        m_threads.push_back( std::thread( &Executor::run, this ) );
+}
+
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for( std::thread& th : m_threads )
+        th.join();
+}
+
+void Executor::post( std::function<void()> task )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_tasks.push_back( std::move( task ) );
+    }
+    m_cv.notify_one();
+}
+
+void Executor::parallelFor( size_t n, const std::function<void(size_t begin, size_t end)>& body )
+{
+    if( n == 0 )
+        return;
+
+    // a few chunks per thread balance uneven work
+    const size_t nbrOfChunks = std::min( n, 4 * ( getNumberOfThreads() + 1 ) );
+    const size_t chunkSize = ( n + nbrOfChunks - 1 ) / nbrOfChunks;
+
+    // Shared with the helper tasks. A helper starting late finds no chunk
+    // left and must not touch the stack of this function anymore.
+    struct State
+    {
+        std::function<void(size_t, size_t)> body;
+        std::atomic<size_t> nextChunk{0};
+        size_t chunksDone = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    std::shared_ptr<State> state( new State() );
+    state->body = body;
+
+    auto work = [state, n, nbrOfChunks, chunkSize]()
+    {
+        size_t processed = 0;
+        for( size_t c = state->nextChunk++; c < nbrOfChunks; c = state->nextChunk++ )
+        {
+            // rounding up the chunk size may leave the last chunks empty
+            state->body( std::min( n, c * chunkSize ), std::min( n, (c + 1) * chunkSize ) );
+            processed++;
+        }
+
+        if( processed > 0 )
+        {
+            std::lock_guard<std::mutex> lock( state->mutex );
+            state->chunksDone += processed;
+            if( state->chunksDone == nbrOfChunks )
+                state->done.notify_all();
+        }
+    };
+
+    const size_t nbrOfHelpers = std::min( getNumberOfThreads(), nbrOfChunks - 1 );
+    for( size_t k = 0; k < nbrOfHelpers; k++ )
+        post( work );
+
+    work();
+
+    std::unique_lock<std::mutex> lock( state->mutex );
+    state->done.wait( lock, [&state, nbrOfChunks]{ return state->chunksDone == nbrOfChunks; } );
+}
+
+Executor& Executor::global()
+{
+    static Executor executor;
+    return executor;
+}
+
+void Executor::run()
+{
+    Trace::setThreadName( "executor" );
+
+    for(;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_cv.wait( lock, [this]{ return m_stop || !m_tasks.empty(); } );
+            if( m_tasks.empty() )
+                return; // stopped and nothing left
+
+            task = std::move( m_tasks.front() );
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
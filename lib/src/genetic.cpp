@@ -23,44 +23,54 @@
 
 #include "genetic.h"
 #include "layer.h"
+#include "trace.h"
+#include "helpers.h"
 
 #include <iostream>
 #include <random>
 
 NetworkPtr Genetic::crossover(NetworkPtr a, NetworkPtr b, Genetic::CrossoverMethod method, double mutationRate )
 {
-    auto kv = a->getNetworkStructure();
-    auto qv = b->getNetworkStructure();
+    // shares the parameters of a, which are replaced without copying
+    NetworkPtr cross = std::shared_ptr<Network>( new Network(*(a.get())) );
+
+    if( !crossoverInto( cross, a, b, method, mutationRate ) )
+        return std::shared_ptr<Network>(nullptr);
+
+    return cross;
+}
+
+bool Genetic::crossoverInto( NetworkPtr target, NetworkPtr a, NetworkPtr b, Genetic::CrossoverMethod method, double mutationRate )
+{
+    EIDNN_TRACE_SCOPE( "genetic", "crossover" );
 
-    if( ! std::equal( a->getNetworkStructure().begin(), a->getNetworkStructure().end(),  b->getNetworkStructure().begin() ) )
+    if( a->getNetworkStructure() != b->getNetworkStructure() || a->getNetworkStructure() != target->getNetworkStructure() )
     {
         std::cout << "Genetic::crossover, Error mismatching network sizes" << std::endl;
-        return std::shared_ptr<Network>(nullptr);
+        return false;
     }
 
-    NetworkPtr cross = std::shared_ptr<Network>( new Network(*(a.get())) );
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937& gen = Helpers::randomGenerator();
     std::uniform_int_distribution<> crossOv(0, 1);
 
     std::uniform_real_distribution<double> mutation(0.0, 1.0);
     std::normal_distribution<double> mutationVal(0.0, 1.0);
 
-    for( unsigned int i = 0; i < cross->getNumberOfLayer(); i++ )
+    for( unsigned int i = 0; i < target->getNumberOfLayer(); i++ )
     {
-        auto al = a->getLayer(i);
-        auto bl = b->getLayer(i);
-        auto crl = cross->getLayer(i);
+        // keep the parent parameters alive, target might share them
+        std::shared_ptr<const LayerParameters> ap = a->getLayer(i)->getParameters();
+        std::shared_ptr<const LayerParameters> bp = b->getLayer(i)->getParameters();
+        LayerParameters& crp = target->getLayer(i)->getMutableParameters( false );
 
         // crossover weight matrix
-        auto aw = al->getWeightMatrix();
-        auto bw = bl->getWeightMatrix();
-        Eigen::MatrixXd crlw(aw.rows(), aw.cols());
+        const Eigen::MatrixXd& aw = ap->weights;
+        const Eigen::MatrixXd& bw = bp->weights;
+        Eigen::MatrixXd& crlw = crp.weights;
 
-        for( size_t m = 0; m < crlw.rows(); m++ )
+        for( long m = 0; m < crlw.rows(); m++ )
         {
-            for( size_t n = 0; n < crlw.cols(); n++ )
+            for( long n = 0; n < crlw.cols(); n++ )
             {
                 if( mutation(gen) < mutationRate )
                 {
@@ -79,14 +89,12 @@ NetworkPtr Genetic::crossover(NetworkPtr a, NetworkPtr b, Genetic::CrossoverMeth
             }
         }
 
-        crl->setWeights(crlw);
-
         // crossover bias vector
-        auto ab = al->getBiasVector();
-        auto bb = bl->getBiasVector();
-        Eigen::MatrixXd crlb(ab.rows(),1);
+        const Eigen::MatrixXd& ab = ap->biases;
+        const Eigen::MatrixXd& bb = bp->biases;
+        Eigen::MatrixXd& crlb = crp.biases;
 
-        for( size_t m = 0; m < crlb.rows(); m++ )
+        for( long m = 0; m < crlb.rows(); m++ )
         {
             if( mutation(gen) < mutationRate )
             {
@@ -102,9 +110,54 @@ NetworkPtr Genetic::crossover(NetworkPtr a, NetworkPtr b, Genetic::CrossoverMeth
                     crlb(m) = bb(m);
             }
         }
+    }
+
+    return true;
+}
 
-        crl->setBiases(crlb);
+size_t Genetic::getNumberOfParameters( const NetworkPtr& net )
+{
+    size_t n = 0;
+    for( unsigned int i = 0; i < net->getNumberOfLayer(); i++ )
+    {
+        std::shared_ptr<const LayerParameters> p = net->getLayer(i)->getParameters();
+        n += size_t( p->weights.size() + p->biases.size() );
     }
+    return n;
+}
 
-    return cross;
+Eigen::VectorXd Genetic::getParameterVector( const NetworkPtr& net )
+{
+    Eigen::VectorXd params( getNumberOfParameters( net ) );
+
+    Eigen::Index offset = 0;
+    for( unsigned int i = 0; i < net->getNumberOfLayer(); i++ )
+    {
+        std::shared_ptr<const LayerParameters> p = net->getLayer(i)->getParameters();
+        params.segment( offset, p->weights.size() ) = Eigen::Map<const Eigen::VectorXd>( p->weights.data(), p->weights.size() );
+        offset += p->weights.size();
+        params.segment( offset, p->biases.size() ) = Eigen::Map<const Eigen::VectorXd>( p->biases.data(), p->biases.size() );
+        offset += p->biases.size();
+    }
+    return params;
+}
+
+bool Genetic::setParameterVector( NetworkPtr net, const Eigen::VectorXd& params )
+{
+    if( size_t( params.size() ) != getNumberOfParameters( net ) )
+    {
+        std::cout << "Genetic::setParameterVector, Error mismatching number of parameters" << std::endl;
+        return false;
+    }
+
+    Eigen::Index offset = 0;
+    for( unsigned int i = 0; i < net->getNumberOfLayer(); i++ )
+    {
+        LayerParameters& p = net->getLayer(i)->getMutableParameters( false );
+        Eigen::Map<Eigen::VectorXd>( p.weights.data(), p.weights.size() ) = params.segment( offset, p.weights.size() );
+        offset += p.weights.size();
+        Eigen::Map<Eigen::VectorXd>( p.biases.data(), p.biases.size() ) = params.segment( offset, p.biases.size() );
+        offset += p.biases.size();
+    }
+    return true;
 }
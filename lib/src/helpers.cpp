@@ -74,3 +74,15 @@ Eigen::MatrixXd Helpers::mean( const std::vector<Eigen::MatrixXd>& input )
 
     return accum;
 }
+
+std::mt19937& Helpers::randomGenerator()
+{
+    // seeding a generator per use is expensive
+    thread_local std::mt19937 gen( std::random_device{}() );
+    return gen;
+}
+
+void Helpers::seedRandomGenerator( unsigned int seed )
+{
+    randomGenerator().seed( seed );
+}
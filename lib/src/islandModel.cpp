@@ -0,0 +1,233 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "islandModel.h"
+#include "network.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+Island::Island( size_t id, size_t nbrOfIslands, std::shared_ptr<Evolution> evolution,
+                std::shared_ptr<MigrationTopology> topology, std::shared_ptr<MigrationChannel> channel )
+: m_id( id ),
+  m_nbrOfIslands( nbrOfIslands ),
+  m_evolution( evolution ),
+  m_topology( topology ),
+  m_channel( channel ),
+  m_migrationInterval( 5 ),
+  m_nbrOfMigrants( 2 ),
+  m_migrationTimeout( 60.0 ),
+  m_round( 0 ),
+  m_nbrOfImmigrants( 0 )
+{
+}
+
+bool Island::run( size_t epochs )
+{
+    if( m_evolution->isSteadyState() )
+    {
+        std::cout << "Error: Islands need the generational mode" << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    for( size_t e = 1; e <= epochs; e++ )
+    {
+        m_evolution->doEpoch();
+        if( e == epochs )
+            break;
+
+        if( m_migrationInterval > 0 && e % m_migrationInterval == 0 )
+            ok = breedAndMigrate() && ok;
+        else
+            m_evolution->breed();
+    }
+    return ok;
+}
+
+bool Island::breedAndMigrate()
+{
+    // the best of the finished epoch, breeding replaces them
+    MigrationMessage message;
+    message.round = m_round++;
+    message.source = uint32_t( m_id );
+    for( const SimulationPtr& sim : m_evolution->getSimulationsOrderedByFitness( m_nbrOfMigrants ) )
+        message.genomes.push_back( sim->getNetwork()->serialize() );
+
+    m_evolution->breed();
+
+    bool ok = true;
+    for( size_t target : m_topology->getTargets( m_id, m_nbrOfIslands ) )
+    {
+        if( !m_channel->send( target, message ) )
+        {
+            std::cout << "Error: Island " << m_id << " could not send migrants to island " << target << std::endl;
+            ok = false;
+        }
+    }
+
+    std::vector<size_t> sources = m_topology->getSources( m_id, m_nbrOfIslands );
+    std::vector<MigrationMessage> received;
+    if( !m_channel->receive( message.round, sources.size(), received, m_migrationTimeout ) )
+    {
+        std::cout << "Error: Island " << m_id << " missed migrants of round " << message.round << std::endl;
+        ok = false;
+    }
+
+    std::vector<NetworkPtr> immigrants;
+    for( const MigrationMessage& m : received )
+    {
+        for( const std::string& genome : m.genomes )
+        {
+            NetworkPtr net( Network::deserialize( genome ) );
+            if( !net )
+            {
+                std::cout << "Error: Island " << m_id << " dropped a corrupt migrant of island " << m.source << std::endl;
+                ok = false;
+                continue;
+            }
+            immigrants.push_back( net );
+        }
+    }
+
+    m_evolution->immigrate( immigrants );
+    m_nbrOfImmigrants += immigrants.size();
+
+    return ok;
+}
+
+void Island::setMigrationInterval( size_t epochs )
+{
+    m_migrationInterval = epochs;
+}
+
+size_t Island::getMigrationInterval() const
+{
+    return m_migrationInterval;
+}
+
+void Island::setNumberOfMigrants( size_t n )
+{
+    m_nbrOfMigrants = n;
+}
+
+size_t Island::getNumberOfMigrants() const
+{
+    return m_nbrOfMigrants;
+}
+
+void Island::setMigrationTimeout( double seconds )
+{
+    m_migrationTimeout = seconds;
+}
+
+double Island::getMigrationTimeout() const
+{
+    return m_migrationTimeout;
+}
+
+size_t Island::getNumberOfImmigrants() const
+{
+    return m_nbrOfImmigrants;
+}
+
+size_t Island::getId() const
+{
+    return m_id;
+}
+
+const std::shared_ptr<Evolution>& Island::getEvolution() const
+{
+    return m_evolution;
+}
+
+IslandModel::IslandModel( size_t nbrOfIslands, EvolutionCreator creator, std::shared_ptr<MigrationTopology> topology )
+: m_nbrOfIslands( nbrOfIslands ),
+  m_creator( creator ),
+  m_topology( topology ),
+  m_migrationInterval( 5 ),
+  m_nbrOfMigrants( 2 ),
+  m_migrationTimeout( 60.0 )
+{
+}
+
+void IslandModel::setMigrationInterval( size_t epochs )
+{
+    m_migrationInterval = epochs;
+}
+
+void IslandModel::setNumberOfMigrants( size_t n )
+{
+    m_nbrOfMigrants = n;
+}
+
+void IslandModel::setMigrationTimeout( double seconds )
+{
+    m_migrationTimeout = seconds;
+}
+
+bool IslandModel::run( size_t epochs )
+{
+    std::vector<std::shared_ptr<LocalMigrationChannel>> channels = LocalMigrationChannel::createGroup( m_nbrOfIslands );
+
+    m_islands.assign( m_nbrOfIslands, std::shared_ptr<Island>() );
+    std::vector<char> results( m_nbrOfIslands, 0 );
+
+    std::vector<std::thread> threads;
+    for( size_t k = 0; k < m_nbrOfIslands; k++ )
+    {
+        threads.emplace_back( [this, k, epochs, &channels, &results]()
+        {
+            std::shared_ptr<Island> island( new Island( k, m_nbrOfIslands, m_creator( k ), m_topology, channels[k] ) );
+            island->setMigrationInterval( m_migrationInterval );
+            island->setNumberOfMigrants( m_nbrOfMigrants );
+            island->setMigrationTimeout( m_migrationTimeout );
+            m_islands[k] = island;
+
+            results[k] = island->run( epochs );
+        });
+    }
+
+    for( std::thread& t : threads )
+        t.join();
+
+    return std::all_of( results.begin(), results.end(), []( char r ) { return r != 0; } );
+}
+
+const std::vector<std::shared_ptr<Island>>& IslandModel::getIslands() const
+{
+    return m_islands;
+}
+
+SimulationPtr IslandModel::getFittest() const
+{
+    SimulationPtr fittest;
+    for( const std::shared_ptr<Island>& island : m_islands )
+    {
+        std::vector<SimulationPtr> best = island->getEvolution()->getFittest();
+        if( !best.empty() && ( !fittest || best.front()->getFitness() > fittest->getFitness() ) )
+            fittest = best.front();
+    }
+    return fittest;
+}
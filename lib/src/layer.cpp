@@ -21,6 +21,8 @@
 **
 *****************************************************************************/
 
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <random>
 #include <inc/layer.h>
@@ -33,45 +35,49 @@
 
 using namespace std;
 
-Layer::Layer(const uint& nbr_of_neurons , const uint &nbr_of_inputs, const LayerOutputType& type) :
+Layer::Layer(const uint& nbr_of_neurons , const uint &nbr_of_inputs, const LayerOutputType& type, const bool& randomInit ) :
     m_nbr_of_neurons( nbr_of_neurons ),
     m_nbr_of_inputs( nbr_of_inputs ),
     m_layer_type(type),
     m_outputLayerCost(0.0)
 {
-    initLayer();
+    initLayer( randomInit );
 }
 
 Layer::Layer( const uint& nbr_of_inputs, const vector<Eigen::VectorXd>& weights, const vector<double>& biases, const LayerOutputType& type ) :
-    Layer::Layer( uint(weights.size()), nbr_of_inputs, type )
+    Layer::Layer( uint(weights.size()), nbr_of_inputs, type, false )
 {
     assert( weights.size() ==  biases.size() );
 
     // write weight matrix and bias vector
+    LayerParameters& params = getMutableParameters();
     for( unsigned int n = 0; n < weights.size(); n++ )
     {
-        m_weightMatrix.row(n) = weights.at(n).transpose();
-        m_biasVector(n,0) = biases.at(n);
+        params.weights.row(n) = weights.at(n).transpose();
+        params.biases(n,0) = biases.at(n);
     }
 
     m_regularization.reset( new Regularization(Regularization::RegularizationMethod::NoneRegularization, 1.0 ));
 }
 
-Layer::Layer( const Layer& l ) : Layer( l.getNbrOfNeurons(), l.getNbrOfNeuronInputs(), l.getLayerType() )
+Layer::Layer( const Layer& l ) : Layer( l.getNbrOfNeurons(), l.getNbrOfNeuronInputs(), l.getLayerType(), false )
 {
     // Note: Temporary results like activations and derivatives are not copied.
-    m_weightMatrix = l.getWeightMatrix();
-    m_biasVector = l.getBiasVector();
+    m_params = l.m_params;
     m_regularization = l.getRegularizationMethod();
 }
 
 
 // init vectors and neurons
-void Layer::initLayer()
+void Layer::initLayer( const bool& randomInit )
 {
-    m_weightMatrix = Eigen::MatrixXd( m_nbr_of_neurons , m_nbr_of_inputs );
-    m_biasVector = Eigen::MatrixXd( m_nbr_of_neurons, 1 );
-    resetRandomlyWeightsAndBiases();
+    std::shared_ptr<LayerParameters> params( new LayerParameters() );
+    params->weights = Eigen::MatrixXd( m_nbr_of_neurons , m_nbr_of_inputs );
+    params->biases = Eigen::MatrixXd( m_nbr_of_neurons, 1 );
+    m_params = params;
+
+    if( randomInit )
+        resetRandomlyWeightsAndBiases();
 
     // init with size 1 -> dimensionso of these matrices will change corrsponding to input signal
     m_activation_in = Eigen::MatrixXd( 1, 1 );
@@ -92,6 +98,8 @@ Layer::~Layer()
 
 bool Layer::feedForward(const Eigen::MatrixXd &x_in )
 {
+    EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[LayerStats::FeedForward] );
+
     if( x_in.rows() != m_nbr_of_inputs )
     {
         std::cout << "Error: Layer input vector size mismatch" << std::endl;
@@ -99,28 +107,33 @@ bool Layer::feedForward(const Eigen::MatrixXd &x_in )
     }
 
     m_activation_in = x_in;
-    m_z_weighted_input = m_weightMatrix * x_in + m_biasVector.replicate(1, x_in.cols());
-    m_activation_out = Eigen::MatrixXd(m_z_weighted_input.rows(), m_z_weighted_input.cols());
+    m_z_weighted_input = getWeightMatrix() * x_in + getBiasVector().replicate(1, x_in.cols());
+    activation( m_z_weighted_input, m_layer_type, m_activation_out );
 
-    if( m_layer_type == Sigmoid )
+    return true;
+}
+
+void Layer::activation( const Eigen::MatrixXd& z, const LayerOutputType& type, Eigen::MatrixXd& a_out )
+{
+    a_out = Eigen::MatrixXd(z.rows(), z.cols());
+
+    if( type == Sigmoid )
     {
         // compute sigmoid of weighted input matrix
-        for( unsigned int m = 0; m < m_z_weighted_input.rows(); m++ )
-            for( unsigned int n = 0; n < m_z_weighted_input.cols(); n++ )
-                m_activation_out(m,n) = Neuron::sigmoid( m_z_weighted_input(m,n) );
+        for( unsigned int m = 0; m < z.rows(); m++ )
+            for( unsigned int n = 0; n < z.cols(); n++ )
+                a_out(m,n) = Neuron::sigmoid( z(m,n) );
     }
-    else if( m_layer_type == Softmax )
+    else if( type == Softmax )
     {
         // compute softmax of weighted input matrix
-        Eigen::MatrixXd expZ = (m_z_weighted_input.array().exp()).matrix();
+        Eigen::MatrixXd expZ = (z.array().exp()).matrix();
         Eigen::MatrixXd expSums = expZ.colwise().sum();
 
-        for( unsigned int n = 0; n < m_z_weighted_input.cols(); n++ ) // each sample
-            for( unsigned int m = 0; m < m_z_weighted_input.rows(); m++ ) // each neuron
-                m_activation_out(m,n) = expZ(m,n) / expSums(0,n);
+        for( unsigned int n = 0; n < z.cols(); n++ ) // each sample
+            for( unsigned int m = 0; m < z.rows(); m++ ) // each neuron
+                a_out(m,n) = expZ(m,n) / expSums(0,n);
     }
-
-    return true;
 }
 
 
@@ -132,21 +145,35 @@ bool Layer::setWeights( const vector<Eigen::VectorXd>& weights )
         return false;
     }
 
+    LayerParameters& params = getMutableParameters();
     for( unsigned int n = 0; n < weights.size(); n++ )
-        m_weightMatrix.row(n) = weights.at(n).transpose();
+        params.weights.row(n) = weights.at(n).transpose();
 
     return true;
 }
 
 bool Layer::setWeights( const Eigen::MatrixXd& weights )
 {
-    if( weights.rows() != m_weightMatrix.rows() || weights.cols() != m_weightMatrix.cols() )
+    if( weights.rows() != getWeightMatrix().rows() || weights.cols() != getWeightMatrix().cols() )
     {
         std::cout << "Error: Weights matrix size mismatches" << std::endl;
         return false;
     }
 
-    m_weightMatrix = weights;
+    if( m_params.use_count() == 1 )
+    {
+        // orders the last reads of a snapshot that just released them before the write
+        std::atomic_thread_fence( std::memory_order_acquire );
+        getMutableParameters().weights = weights;
+    }
+    else
+    {
+        // shared -> do not copy the weights which get overwritten anyway
+        std::shared_ptr<LayerParameters> params( new LayerParameters() );
+        params->weights = weights;
+        params->biases = getBiasVector();
+        m_params = params;
+    }
     return true;
 }
 
@@ -158,8 +185,9 @@ bool Layer::setBiases( const vector<double>& biases )
         return false;
     }
 
+    LayerParameters& params = getMutableParameters();
     for( unsigned int n = 0; n < biases.size(); n++ )
-        m_biasVector(n,0) = biases.at(n);
+        params.biases(n,0) = biases.at(n);
 
     return true;
 }
@@ -172,50 +200,81 @@ bool Layer::setBiases( const Eigen::MatrixXd& biases )
         return false;
     }
 
-    m_biasVector = biases;
+    getMutableParameters().biases = biases;
 
     return true;
 }
 
 void Layer::setWeight( const double& weight )
 {
-    Eigen::VectorXd uniformWeight = Eigen::VectorXd::Constant(getNbrOfNeuronInputs(), weight);
-
-    for( unsigned int n = 0; n < getNbrOfNeurons(); n++ )
-        m_weightMatrix.row(n) = uniformWeight.transpose();
+    getMutableParameters().weights.setConstant( weight );
 }
 
 
 void Layer::setBias(const double &bias )
 {
-    m_biasVector = Eigen::MatrixXd::Constant(getNbrOfNeurons(), 1, bias);
+    getMutableParameters().biases.setConstant( bias );
 }
 
 void Layer::resetRandomlyWeightsAndBiases()
 {
-    std::random_device mch;
-    std::default_random_engine weightGenerator(mch());
+    std::mt19937& gen = Helpers::randomGenerator();
     double stdDev = 1.0;
     if( m_nbr_of_inputs > 0 )
         stdDev = 1 / std::sqrt( m_nbr_of_inputs );
     std::normal_distribution<double> weightDist(0.0, stdDev);
 
-    std::default_random_engine biasGenerator(mch());
     std::normal_distribution<double> biasDist(0.0, 1);
 
+    LayerParameters& params = getMutableParameters( false );
     for( unsigned int i = 0; i < getNbrOfNeurons(); i++ )
     {
-        double b = biasDist(biasGenerator);
-        m_biasVector(i,0) = b;
+        params.biases(i,0) = biasDist(gen);
 
-        Eigen::VectorXd thisWeights = Eigen::VectorXd( getNbrOfNeuronInputs() );
         for( unsigned int k = 0; k < getNbrOfNeuronInputs(); k++ )
-            thisWeights(k) = weightDist(weightGenerator);
+            params.weights(i,k) = weightDist(gen);
+    }
+}
+
 
-        m_weightMatrix.row(i) = thisWeights.transpose();
+LayerParameters& Layer::getMutableParameters( const bool& keepValues )
+{
+    if( m_params.use_count() != 1 )
+    {
+        if( keepValues )
+        {
+            m_params = std::shared_ptr<const LayerParameters>( new LayerParameters( *m_params ) );
+        }
+        else
+        {
+            std::shared_ptr<LayerParameters> params( new LayerParameters() );
+            params->weights = Eigen::MatrixXd( m_nbr_of_neurons , m_nbr_of_inputs );
+            params->biases = Eigen::MatrixXd( m_nbr_of_neurons, 1 );
+            m_params = params;
+        }
+    }
+    else
+    {
+        // orders the last reads of a snapshot that just released them before the write
+        std::atomic_thread_fence( std::memory_order_acquire );
     }
+
+    // the parameters are only shared as const, here this layer is the only owner
+    return const_cast<LayerParameters&>( *m_params );
 }
 
+bool Layer::setParameters( const std::shared_ptr<const LayerParameters>& params )
+{
+    if( !params || params->weights.rows() != getNbrOfNeurons() || params->weights.cols() != getNbrOfNeuronInputs()
+            || params->biases.rows() != getNbrOfNeurons() || params->biases.cols() != 1 )
+    {
+        std::cout << "Error: Layer parameters size mismatch" << std::endl;
+        return false;
+    }
+
+    m_params = params;
+    return true;
+}
 
 bool Layer::setActivationOutput( const Eigen::MatrixXd& activation_out )
 {
@@ -231,6 +290,8 @@ bool Layer::setActivationOutput( const Eigen::MatrixXd& activation_out )
 
 bool Layer::computeBackpropagationOutputLayerError(const Eigen::MatrixXd &expectedNetworkOutput )
 {
+    EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[LayerStats::BackpropagationError] );
+
     if( m_activation_out.rows() != expectedNetworkOutput.rows() ||
             m_activation_out.cols() != expectedNetworkOutput.cols())
     {
@@ -255,6 +316,8 @@ bool Layer::computeBackpropagationOutputLayerError(const Eigen::MatrixXd &expect
 
 bool Layer::computeBackprogationError(const Eigen::MatrixXd &errorNextLayer, const Eigen::MatrixXd& weightMatrixNextLayer )
 {
+    EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[LayerStats::BackpropagationError] );
+
     if( m_z_weighted_input.rows() != weightMatrixNextLayer.cols()  ||  errorNextLayer.rows() != weightMatrixNextLayer.rows() )
     {
         std::cout << "Error: computeBackprogationError Layer dimension mismatch" << std::endl;
@@ -267,6 +330,8 @@ bool Layer::computeBackprogationError(const Eigen::MatrixXd &errorNextLayer, con
 
 void Layer::computePartialDerivatives()
 {
+    EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[LayerStats::PartialDerivatives] );
+
     Eigen::MatrixXd delta = getBackpropagationError();
 
     m_bias_partialDerivatives.clear();
@@ -290,21 +355,21 @@ void Layer::updateWeightsAndBiases(const double &eta, const unsigned int& sample
 
 void Layer::updateWeightsAndBiases(const Eigen::MatrixXd& deltaBias, const Eigen::MatrixXd& deltaWeight, const double& eta)
 {
+    EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[LayerStats::Update] );
 
-    const Eigen::MatrixXd newBiases = getBiasVector() - deltaBias;
-    setBiases( newBiases );
+    // update in place, unless the parameters are shared with a copy of this layer
+    LayerParameters& params = getMutableParameters();
+    params.biases -= deltaBias;
 
-    Eigen::MatrixXd newWeights;
     switch( getRegularizationMethod()->m_method )
     {
         case Regularization::RegularizationMethod::WeightDecay:
-            newWeights = (1-getRegularizationMethod()->m_lamda * eta) * getWeightMatrix()  -   deltaWeight;
+            params.weights = (1-getRegularizationMethod()->m_lamda * eta) * params.weights  -   deltaWeight;
             break;
 
         default:
-            newWeights = getWeightMatrix() - deltaWeight;
+            params.weights -= deltaWeight;
     }
-    setWeights( newWeights );
 }
 
 void Layer::print() const
@@ -327,12 +392,12 @@ std::string Layer::serialize( ) const
     double* weightBuf = new double[ nbrOfDoublesWeightMatrix ];
     for( size_t m = 0; m < m_nbr_of_neurons; m++ )
         for( size_t n = 0; n < m_nbr_of_inputs; n++ )
-            weightBuf[ m*m_nbr_of_inputs + n ] = m_weightMatrix( long(m), long(n) );
+            weightBuf[ m*m_nbr_of_inputs + n ] = getWeightMatrix()( long(m), long(n) );
 
     size_t nbrOfDoublesBias = m_nbr_of_neurons;
     double* biasBuf = new double[ nbrOfDoublesBias ];
     for( size_t m = 0; m < nbrOfDoublesBias; m++ )
-        biasBuf[ m ] = m_biasVector( long(m), 0 );
+        biasBuf[ m ] = getBiasVector()( long(m), 0 );
 
     string retBuffer;
     retBuffer.append( string( (char*)topoBuf, 3*sizeof(unsigned int) ) );
@@ -349,27 +414,54 @@ std::string Layer::serialize( ) const
 Layer* Layer::deserialize( const string& buffer )
 {
     const char* buf = buffer.c_str();
+    const size_t headerSize = 3 * sizeof(unsigned int);
 
-    unsigned int nbrOfNeurons = ((unsigned int*)(buf))[0];
-    unsigned int nbrOfInputs = ((unsigned int*)(buf))[1];
-    Layer::LayerOutputType lType = static_cast<Layer::LayerOutputType>(((unsigned int*)(buf))[2]);
+    if( buffer.size() < headerSize )
+    {
+        cout << "Error: Layer data too short" << endl;
+        return NULL;
+    }
 
-    size_t offset = 3 * sizeof(unsigned int);
+    unsigned int header[3];
+    std::memcpy( header, buf, headerSize );
+    unsigned int nbrOfNeurons = header[0];
+    unsigned int nbrOfInputs = header[1];
 
+    // the sizes must match the buffer exactly, checked without overflow
+    const uint64_t nbrOfDoubles = ( buffer.size() - headerSize ) / sizeof(double);
+    if( header[2] > static_cast<unsigned int>(Layer::Softmax) ||
+        uint64_t(nbrOfNeurons) > nbrOfDoubles / ( uint64_t(nbrOfInputs) + 1 ) ||
+        buffer.size() != headerSize + uint64_t(nbrOfNeurons) * ( uint64_t(nbrOfInputs) + 1 ) * sizeof(double) )
+    {
+        cout << "Error: Corrupt layer data" << endl;
+        return NULL;
+    }
+    Layer::LayerOutputType lType = static_cast<Layer::LayerOutputType>( header[2] );
+
+    size_t offset = headerSize;
+
+    // the doubles are not aligned in the buffer
     Eigen::MatrixXd weightMatrix = Eigen::MatrixXd( nbrOfNeurons , nbrOfInputs );
-    const double* weightBuf = (const double*)((buf + offset));
+    double value;
     for( size_t m = 0; m < nbrOfNeurons; m++ )
+    {
         for( size_t n = 0; n < nbrOfInputs; n++ )
-            weightMatrix( long(m), long(n) ) = weightBuf[ m*nbrOfInputs + n ] ;
+        {
+            std::memcpy( &value, buf + offset + ( m*nbrOfInputs + n ) * sizeof(double), sizeof(double) );
+            weightMatrix( long(m), long(n) ) = value;
+        }
+    }
 
-    offset = offset + nbrOfNeurons*nbrOfInputs*sizeof(double);
+    offset = offset + size_t(nbrOfNeurons)*nbrOfInputs*sizeof(double);
 
     Eigen::MatrixXd biasVector = Eigen::MatrixXd( nbrOfNeurons, 1 );
-    const double* biasBuf = (const double*)((buf + offset));
     for( size_t m = 0; m < nbrOfNeurons; m++ )
-        biasVector( long(m), 0 ) = biasBuf[ m ];
+    {
+        std::memcpy( &value, buf + offset + m * sizeof(double), sizeof(double) );
+        biasVector( long(m), 0 ) = value;
+    }
 
-    Layer* l = new Layer( nbrOfNeurons, nbrOfInputs, lType );
+    Layer* l = new Layer( nbrOfNeurons, nbrOfInputs, lType, false );
     l->setBiases( biasVector );
     l->setWeights( weightMatrix );
 
@@ -388,7 +480,7 @@ void Layer::setLayerType( const LayerOutputType& type)
 
 double Layer::getSumOfWeightSquares() const
 {
-    return (m_weightMatrix.cwiseProduct(m_weightMatrix)).sum();
+    return getWeightMatrix().squaredNorm();
 }
 
 void Layer::setRegularizationMethod(std::shared_ptr<Regularization> reg)
@@ -404,3 +496,17 @@ std::shared_ptr<Regularization> Layer::getRegularizationMethod() const
 
 
 
+
+LayerStats Layer::getStats() const
+{
+    LayerStats s;
+    for( int p = 0; p < LayerStats::NumberOfPhases; p++ )
+        s.phases[p] = m_stats[p].get();
+    return s;
+}
+
+void Layer::resetStats()
+{
+    for( PhaseCounter& c : m_stats )
+        c.reset();
+}
@@ -0,0 +1,358 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "migration.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    const uint32_t messageMagic = 0x45494953; // EIIS
+
+    // a single message is never that large, protects against garbage
+    const uint64_t maxMessageSize = uint64_t(1) << 30;
+
+    template<typename T>
+    void append( std::string& buffer, const T& value )
+    {
+        buffer.append( reinterpret_cast<const char*>( &value ), sizeof(T) );
+    }
+
+    template<typename T>
+    bool extract( const std::string& buffer, size_t& offset, T& value )
+    {
+        if( buffer.size() - offset < sizeof(T) )
+            return false;
+        std::memcpy( &value, buffer.data() + offset, sizeof(T) );
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool writeAll( int fd, const char* data, size_t size )
+    {
+        while( size > 0 )
+        {
+            ssize_t n = ::send( fd, data, size, MSG_NOSIGNAL );
+            if( n <= 0 )
+                return false;
+            data += n;
+            size -= size_t(n);
+        }
+        return true;
+    }
+
+    bool readAll( int fd, char* data, size_t size )
+    {
+        while( size > 0 )
+        {
+            ssize_t n = ::recv( fd, data, size, 0 );
+            if( n <= 0 )
+                return false;
+            data += n;
+            size -= size_t(n);
+        }
+        return true;
+    }
+
+    bool socketAddress( const std::string& path, sockaddr_un& addr )
+    {
+        std::memset( &addr, 0, sizeof(addr) );
+        addr.sun_family = AF_UNIX;
+        if( path.size() >= sizeof(addr.sun_path) )
+        {
+            std::cout << "Error: Socket path too long " << path << std::endl;
+            return false;
+        }
+        std::memcpy( addr.sun_path, path.c_str(), path.size() );
+        return true;
+    }
+}
+
+MigrationTopology::~MigrationTopology()
+{
+}
+
+std::vector<size_t> MigrationTopology::getSources( size_t island, size_t nbrOfIslands ) const
+{
+    std::vector<size_t> sources;
+    for( size_t k = 0; k < nbrOfIslands; k++ )
+    {
+        std::vector<size_t> targets = getTargets( k, nbrOfIslands );
+        if( std::find( targets.begin(), targets.end(), island ) != targets.end() )
+            sources.push_back( k );
+    }
+    return sources;
+}
+
+std::vector<size_t> RingTopology::getTargets( size_t island, size_t nbrOfIslands ) const
+{
+    if( nbrOfIslands < 2 )
+        return {};
+    return { ( island + 1 ) % nbrOfIslands };
+}
+
+std::vector<size_t> FullyConnectedTopology::getTargets( size_t island, size_t nbrOfIslands ) const
+{
+    std::vector<size_t> targets;
+    for( size_t k = 0; k < nbrOfIslands; k++ )
+        if( k != island )
+            targets.push_back( k );
+    return targets;
+}
+
+MigrationChannel::~MigrationChannel()
+{
+}
+
+bool MigrationChannel::receive( uint32_t round, size_t nbrOfMessages, std::vector<MigrationMessage>& messages, double timeout )
+{
+    messages.clear();
+
+    std::unique_lock<std::mutex> lock( m_inboxMutex );
+    auto arrived = [this, round]()
+    {
+        return size_t( std::count_if( m_inbox.begin(), m_inbox.end(),
+                                      [round]( const MigrationMessage& m ) { return m.round == round; } ) );
+    };
+
+    bool complete = m_arrived.wait_for( lock, std::chrono::duration<double>( timeout ),
+                                        [&]() { return arrived() >= nbrOfMessages; } );
+
+    // messages of later rounds stay in the inbox
+    auto later = std::stable_partition( m_inbox.begin(), m_inbox.end(),
+                                        [round]( const MigrationMessage& m ) { return m.round == round; } );
+    std::move( m_inbox.begin(), later, std::back_inserter( messages ) );
+    m_inbox.erase( m_inbox.begin(), later );
+
+    // independent of the arrival order
+    std::sort( messages.begin(), messages.end(),
+               []( const MigrationMessage& a, const MigrationMessage& b ) { return a.source < b.source; } );
+
+    return complete;
+}
+
+void MigrationChannel::deliver( MigrationMessage&& message )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_inboxMutex );
+        m_inbox.push_back( std::move( message ) );
+    }
+    m_arrived.notify_all();
+}
+
+std::vector<std::shared_ptr<LocalMigrationChannel>> LocalMigrationChannel::createGroup( size_t nbrOfIslands )
+{
+    std::shared_ptr<std::vector<std::weak_ptr<LocalMigrationChannel>>> group(
+            new std::vector<std::weak_ptr<LocalMigrationChannel>>() );
+
+    std::vector<std::shared_ptr<LocalMigrationChannel>> channels;
+    for( size_t k = 0; k < nbrOfIslands; k++ )
+    {
+        std::shared_ptr<LocalMigrationChannel> channel( new LocalMigrationChannel() );
+        channel->m_group = group;
+        group->push_back( channel );
+        channels.push_back( channel );
+    }
+    return channels;
+}
+
+bool LocalMigrationChannel::send( size_t target, const MigrationMessage& message )
+{
+    if( target >= m_group->size() )
+        return false;
+
+    std::shared_ptr<LocalMigrationChannel> receiver = (*m_group)[target].lock();
+    if( !receiver )
+        return false;
+
+    MigrationMessage copy = message;
+    receiver->deliver( std::move( copy ) );
+    return true;
+}
+
+SocketMigrationChannel::SocketMigrationChannel( const std::string& dir, size_t island, double connectTimeout )
+: m_dir( dir ), m_path( socketPath( dir, island ) ), m_connectTimeout( connectTimeout ), m_socket( -1 ), m_stop( false )
+{
+    sockaddr_un addr;
+    if( !socketAddress( m_path, addr ) )
+        return;
+
+    m_socket = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( m_socket < 0 )
+    {
+        std::cout << "Error: Could not create socket " << m_path << std::endl;
+        return;
+    }
+
+    // left over from a former run
+    unlink( m_path.c_str() );
+
+    if( bind( m_socket, reinterpret_cast<sockaddr*>( &addr ), sizeof(addr) ) != 0 || ::listen( m_socket, 64 ) != 0 )
+    {
+        std::cout << "Error: Could not listen on " << m_path << std::endl;
+        close( m_socket );
+        m_socket = -1;
+        return;
+    }
+
+    m_listener = std::thread( &SocketMigrationChannel::listen, this );
+}
+
+SocketMigrationChannel::~SocketMigrationChannel()
+{
+    m_stop = true;
+    if( m_listener.joinable() )
+        m_listener.join();
+
+    if( m_socket >= 0 )
+    {
+        close( m_socket );
+        unlink( m_path.c_str() );
+    }
+}
+
+bool SocketMigrationChannel::isListening() const
+{
+    return m_socket >= 0;
+}
+
+std::string SocketMigrationChannel::socketPath( const std::string& dir, size_t island )
+{
+    return dir + "/island" + std::to_string( island ) + ".sock";
+}
+
+std::string SocketMigrationChannel::encode( const MigrationMessage& message )
+{
+    std::string buffer;
+    append( buffer, messageMagic );
+    append( buffer, message.round );
+    append( buffer, message.source );
+    append( buffer, uint32_t( message.genomes.size() ) );
+    for( const std::string& genome : message.genomes )
+    {
+        append( buffer, uint64_t( genome.size() ) );
+        buffer.append( genome );
+    }
+    return buffer;
+}
+
+bool SocketMigrationChannel::decode( const std::string& buffer, MigrationMessage& message )
+{
+    size_t offset = 0;
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    if( !extract( buffer, offset, magic ) || magic != messageMagic ||
+        !extract( buffer, offset, message.round ) || !extract( buffer, offset, message.source ) ||
+        !extract( buffer, offset, count ) )
+        return false;
+
+    message.genomes.clear();
+    for( uint32_t k = 0; k < count; k++ )
+    {
+        uint64_t size = 0;
+        if( !extract( buffer, offset, size ) || buffer.size() - offset < size )
+            return false;
+        message.genomes.push_back( buffer.substr( offset, size ) );
+        offset += size;
+    }
+
+    return offset == buffer.size();
+}
+
+bool SocketMigrationChannel::send( size_t target, const MigrationMessage& message )
+{
+    sockaddr_un addr;
+    if( !socketAddress( socketPath( m_dir, target ), addr ) )
+        return false;
+
+    // the target process may not listen yet
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>( m_connectTimeout ) );
+
+    int fd = -1;
+    while( true )
+    {
+        fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+        if( fd < 0 )
+            return false;
+
+        if( connect( fd, reinterpret_cast<sockaddr*>( &addr ), sizeof(addr) ) == 0 )
+            break;
+
+        close( fd );
+        if( std::chrono::steady_clock::now() > deadline )
+        {
+            std::cout << "Error: Could not connect to island " << target << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    std::string body = encode( message );
+    uint64_t size = body.size();
+    bool ok = writeAll( fd, reinterpret_cast<const char*>( &size ), sizeof(size) ) && writeAll( fd, body.data(), body.size() );
+    close( fd );
+
+    if( !ok )
+        std::cout << "Error: Could not send to island " << target << std::endl;
+    return ok;
+}
+
+void SocketMigrationChannel::listen()
+{
+    while( !m_stop )
+    {
+        // wake up regularly to check for stop
+        pollfd pfd = { m_socket, POLLIN, 0 };
+        if( poll( &pfd, 1, 100 ) <= 0 )
+            continue;
+
+        int fd = accept( m_socket, nullptr, nullptr );
+        if( fd < 0 )
+            continue;
+
+        timeval tv = { 5, 0 };
+        setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) );
+
+        uint64_t size = 0;
+        std::string body;
+        MigrationMessage message;
+        if( readAll( fd, reinterpret_cast<char*>( &size ), sizeof(size) ) && size <= maxMessageSize )
+        {
+            body.resize( size );
+            if( readAll( fd, &body[0], body.size() ) && decode( body, message ) )
+                deliver( std::move( message ) );
+            else
+                std::cout << "Error: Invalid migration message on " << m_path << std::endl;
+        }
+        close( fd );
+    }
+}
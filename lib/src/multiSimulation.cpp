@@ -0,0 +1,238 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "multiSimulation.h"
+#include "genetic.h"
+
+#include <algorithm>
+#include <limits>
+
+MultiSimulation::MultiSimulation( const std::vector<SimulationPtr>& children, Aggregation aggregation )
+: m_children( children ), m_aggregation( aggregation )
+{
+    m_network = m_children.front()->getNetwork();
+}
+
+double MultiSimulation::getFitness()
+{
+    if( m_aggregation == Min )
+    {
+        double fitness = std::numeric_limits<double>::max();
+        for( const SimulationPtr& c : m_children )
+            fitness = std::min( fitness, c->getFitness() );
+        return fitness;
+    }
+
+    double sum = 0.0;
+    for( const SimulationPtr& c : m_children )
+        sum += c->getFitness();
+    return sum / double( m_children.size() );
+}
+
+void MultiSimulation::setNetwork( const std::shared_ptr<Network>& network )
+{
+    m_network = network;
+    m_children.front()->setNetwork( network );
+
+    // own activations, shared weights
+    for( size_t k = 1; k < m_children.size(); k++ )
+        m_children[k]->setNetwork( NetworkPtr( new Network( *network ) ) );
+}
+
+void MultiSimulation::kill()
+{
+    Simulation::kill();
+    for( const SimulationPtr& c : m_children )
+        c->kill();
+}
+
+void MultiSimulation::reset()
+{
+    Simulation::reset();
+    for( const SimulationPtr& c : m_children )
+        c->reset();
+}
+
+const std::vector<SimulationPtr>& MultiSimulation::getChildren() const
+{
+    return m_children;
+}
+
+void MultiSimulation::setChildren( const std::vector<SimulationPtr>& children )
+{
+    m_children = children;
+    m_network = m_children.front()->getNetwork();
+    Simulation::reset();
+}
+
+void MultiSimulation::finishStep( double dt )
+{
+    m_stepDuration = dt;
+    m_clock += dt;
+    m_steps++;
+    m_alive = anyChildAlive();
+}
+
+MultiSimulation::Aggregation MultiSimulation::getAggregation() const
+{
+    return m_aggregation;
+}
+
+void MultiSimulation::update()
+{
+    for( const SimulationPtr& c : m_children )
+        c->doStep( getStepDuration() );
+    m_alive = anyChildAlive();
+}
+
+bool MultiSimulation::anyChildAlive() const
+{
+    return std::any_of( m_children.begin(), m_children.end(), []( const SimulationPtr& c ) { return c->isAlive(); } );
+}
+
+MultiSimulationFactory::MultiSimulationFactory( const std::vector<SimFactoryPtr>& factories, MultiSimulation::Aggregation aggregation )
+: m_factories( factories ), m_aggregation( aggregation )
+{
+}
+
+std::shared_ptr<MultiSimulation> MultiSimulationFactory::asMulti( const SimulationPtr& sim ) const
+{
+    std::shared_ptr<MultiSimulation> multi = std::dynamic_pointer_cast<MultiSimulation>( sim );
+    if( multi && multi->getChildren().size() != m_factories.size() )
+        return std::shared_ptr<MultiSimulation>();
+    return multi;
+}
+
+SimulationPtr MultiSimulationFactory::first( const SimulationPtr& sim ) const
+{
+    std::shared_ptr<MultiSimulation> multi = std::dynamic_pointer_cast<MultiSimulation>( sim );
+    return multi ? multi->getChildren().front() : sim;
+}
+
+SimulationPtr MultiSimulationFactory::assemble( SimulationPtr first, const std::shared_ptr<MultiSimulation>& recycled ) const
+{
+    if( !first )
+        return SimulationPtr();
+
+    std::vector<SimulationPtr> children( m_factories.size() );
+    children[0] = first;
+
+    // the other children get the genome bred in the first one
+    Eigen::VectorXd params = Genetic::getParameterVector( first->getNetwork() );
+    for( size_t k = 1; k < m_factories.size(); k++ )
+    {
+        SimulationPtr rc = recycled ? recycled->getChildren()[k] : SimulationPtr();
+        children[k] = m_factories[k]->recycleWithParameters( rc, first, params );
+    }
+
+    if( recycled )
+    {
+        recycled->setChildren( children );
+        return recycled;
+    }
+
+    return SimulationPtr( new MultiSimulation( children, m_aggregation ) );
+}
+
+SimulationPtr MultiSimulationFactory::createRandomSimulation()
+{
+    return assemble( m_factories.front()->createRandomSimulation(), std::shared_ptr<MultiSimulation>() );
+}
+
+SimulationPtr MultiSimulationFactory::createSimulation( NetworkPtr network )
+{
+    return assemble( m_factories.front()->createSimulation( network ), std::shared_ptr<MultiSimulation>() );
+}
+
+SimulationPtr MultiSimulationFactory::createCrossover( SimulationPtr a, SimulationPtr b, double mutationRate )
+{
+    return assemble( m_factories.front()->createCrossover( first( a ), first( b ), mutationRate ), std::shared_ptr<MultiSimulation>() );
+}
+
+SimulationPtr MultiSimulationFactory::recycleCrossover( SimulationPtr recycled, SimulationPtr a, SimulationPtr b, double mutationRate )
+{
+    std::shared_ptr<MultiSimulation> multi = asMulti( recycled );
+    SimulationPtr rc = multi ? multi->getChildren().front() : SimulationPtr();
+    return assemble( m_factories.front()->recycleCrossover( rc, first( a ), first( b ), mutationRate ), multi );
+}
+
+SimulationPtr MultiSimulationFactory::recycleWithParameters( SimulationPtr recycled, SimulationPtr prototype, const Eigen::VectorXd& parameters )
+{
+    std::shared_ptr<MultiSimulation> multi = asMulti( recycled );
+    SimulationPtr rc = multi ? multi->getChildren().front() : SimulationPtr();
+    return assemble( m_factories.front()->recycleWithParameters( rc, first( prototype ), parameters ), multi );
+}
+
+SimulationPtr MultiSimulationFactory::copy( SimulationPtr a )
+{
+    return assemble( m_factories.front()->copy( first( a ) ), std::shared_ptr<MultiSimulation>() );
+}
+
+bool MultiSimulationFactory::doSteps( const std::vector<SimulationPtr>& sims, size_t start, size_t end, double dt )
+{
+    if( dt <= 0.0 )
+        return SimulationFactory::doSteps( sims, start, end, dt );
+
+    thread_local std::vector<MultiSimulation*> stepped;
+    thread_local std::vector<std::vector<SimulationPtr>> children;
+    stepped.clear();
+    children.resize( m_factories.size() );
+
+    bool anyAlive = false;
+    for( size_t k = start; k < end; k++ )
+    {
+        Simulation* s = sims[k].get();
+        if( !s->isAlive() )
+            continue;
+
+        anyAlive = true;
+        MultiSimulation* multi = dynamic_cast<MultiSimulation*>( s );
+        if( !multi || multi->getChildren().size() != m_factories.size() )
+        {
+            s->doStep( dt );
+            continue;
+        }
+
+        stepped.push_back( multi );
+        for( size_t t = 0; t < m_factories.size(); t++ )
+            children[t].push_back( multi->getChildren()[t] );
+    }
+
+    // each factory steps its children together
+    for( size_t t = 0; t < m_factories.size(); t++ )
+        m_factories[t]->doSteps( children[t], 0, children[t].size(), dt );
+
+    for( MultiSimulation* multi : stepped )
+        multi->finishStep( dt );
+
+    // do not keep the children alive until the next step
+    for( std::vector<SimulationPtr>& c : children )
+        c.clear();
+
+    return anyAlive;
+}
+
+const std::vector<SimFactoryPtr>& MultiSimulationFactory::getFactories() const
+{
+    return m_factories;
+}
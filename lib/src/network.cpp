@@ -26,8 +26,11 @@
 #include "helpers.h"
 #include "crossEntropyCost.h"
 #include "quadraticCost.h"
+#include "trace.h"
+#include "executor.h"
 
 #include <random>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
@@ -35,15 +38,17 @@
 
 using namespace std;
 
-Network::Network( const vector<unsigned int> networkStructure ) :
-    m_NetworkStructure( networkStructure ), m_oberserver( NULL ), m_asyncOperation{}, m_operationInProgress( false )
+Network::Network( const vector<unsigned int> networkStructure, const bool& randomInit ) :
+    m_NetworkStructure( networkStructure ), m_oberserver( NULL )
 {
-    initNetwork();
+    initNetwork( randomInit );
 }
 
 Network::Network( const Network& n ) :
-    m_NetworkStructure( n.getNetworkStructure() ), m_oberserver( n.m_oberserver ), m_asyncOperation{}, m_operationInProgress( false )
+    m_NetworkStructure( n.getNetworkStructure() ), m_oberserver( NULL ), m_observerRateLimit( n.m_observerRateLimit )
 {
+    setObserver( n.m_oberserver );
+
     // copy layers
     m_Layers.clear();
     for( unsigned int l = 0; l < n.getNumberOfLayer(); l++ )
@@ -62,19 +67,35 @@ Network::Network( const Network& n ) :
 }
 
 
+Network::Network( const NetworkSnapshot& snapshot ) :
+    m_NetworkStructure( snapshot.getNetworkStructure() ), m_oberserver( NULL )
+{
+    initNetwork( false );
+
+    for( unsigned int l = 0; l < getNumberOfLayer(); l++ )
+    {
+        m_Layers[l]->setParameters( snapshot.getLayerParameters(l) );
+        m_Layers[l]->setLayerType( snapshot.getLayerType(l) );
+    }
+
+    getOutputLayer()->setCostFunction( snapshot.getCostFunction() );
+    m_trainedBatches = snapshot.getVersion();
+}
+
 Network::~Network()
 {
-    if( m_asyncOperation.joinable() )
-        m_asyncOperation.detach();
+    // queued jobs reference this network
+    cancelOperations();
+    waitForOperations();
 }
 
-void Network::initNetwork()
+void Network::initNetwork( const bool& randomInit )
 {
     unsigned int nbrOfInputs = 0; // for input layer, there is no input needed.
 
     for( unsigned int nbrOfNeuronsInLayer : m_NetworkStructure )
     {
-        m_Layers.push_back( shared_ptr<Layer>( new Layer(nbrOfNeuronsInLayer, nbrOfInputs) ) );
+        m_Layers.push_back( shared_ptr<Layer>( new Layer(nbrOfNeuronsInLayer, nbrOfInputs, Layer::Sigmoid, randomInit) ) );
         nbrOfInputs = nbrOfNeuronsInLayer; // the next layer has same number of inputs as neurons in this layer.
     }
 
@@ -145,71 +166,91 @@ bool Network::gradientDescent( const Eigen::MatrixXd& x_in, const Eigen::MatrixX
     return true;
 }
 
-bool Network::stochasticGradientDescentAsync(const std::vector<Eigen::MatrixXd> &samples, const std::vector<Eigen::MatrixXd> &lables,
-                                             const unsigned int& batchsize, const double& eta, const int& userId)
+NetworkJobPtr Network::stochasticGradientDescentAsync(const std::vector<Eigen::MatrixXd> &samples, const std::vector<Eigen::MatrixXd> &lables,
+                                                      const unsigned int& batchsize, const double& eta, const int& userId)
 {
-    if( !prepareForNextAsynchronousOperation() )
-        return false;
+    NetworkJobPtr job( new NetworkJob( NetworkOperationCallback::OpStochasticGradientDescent, userId ) );
+    job->m_work = [this, samples, lables, batchsize, eta]( NetworkJob& j )
+    {
+        return doStochasticGradientDescent( samples, lables, batchsize, eta, j.getCancellationFlag() );
+    };
 
-    m_userID = userId;
-    m_asyncOperation = std::thread(&Network::stochasticGradientDescent, this,  samples, lables, batchsize, eta);
-    return true;
+    return enqueueJob( job );
 }
 
 bool Network::stochasticGradientDescent(const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
                                         const unsigned int& batchsize, const double& eta)
-{    
-    bool retValue = false;
+{
+    bool retValue = doStochasticGradientDescent( samples, lables, batchsize, eta, NULL );
+
+    if( retValue )
+    {
+        sendProg2Obs(NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpResultOk, 1.0);
+    }
+    else
+    {
+        sendProg2Obs(NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpResultErr, 1.0);
+    }
+
+    return retValue;
+}
+
+bool Network::doStochasticGradientDescent( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                                           const unsigned int& batchsize, const double& eta, const std::atomic<bool>* cancel )
+{
+    EIDNN_TRACE_SCOPE( "network", "sgd epoch" );
+
     size_t nbrOfSamples = samples.size();
 
     if( samples.size() != lables.size() )
     {
         cout << "Error: number of samples and lables mismatch" << endl;
+        return false;
     }
     else if( nbrOfSamples < batchsize )
     {
         cout << "Error: batchsize exceeds number of available smaples" << endl;
+        return false;
     }
-    else
-    {
-        // one epoch
-        unsigned long nbrOfBatches = nbrOfSamples / batchsize;
 
-        std::vector<size_t> randIndices = randomIndices(nbrOfSamples);
+    // one epoch
+    unsigned long nbrOfBatches = nbrOfSamples / batchsize;
 
-        Eigen::MatrixXd batch_in( samples.at(0).rows(), batchsize );
-        Eigen::MatrixXd batch_out( lables.at(0).rows(), batchsize );
+    std::vector<size_t> randIndices = randomIndices(nbrOfSamples);
 
-        for( unsigned int batch = 0; batch < nbrOfBatches; batch++ )
+    Eigen::MatrixXd batch_in( samples.at(0).rows(), batchsize );
+    Eigen::MatrixXd batch_out( lables.at(0).rows(), batchsize );
+
+    for( unsigned int batch = 0; batch < nbrOfBatches; batch++ )
+    {
+        if( cancel != NULL && cancel->load( std::memory_order_relaxed ) )
+            return false;
+
+        EIDNN_TRACE_SCOPE( "network", "sgd batch" );
+
+        // generate a random sample set
         {
-            // generate a random sample set
+            EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[NetworkStats::BatchGather] );
             for( unsigned int b = 0; b < batchsize; b++ )
             {
                 size_t rIdx =  randIndices[batch*batchsize+b];
                 batch_in.col(b) = samples.at(rIdx);
                 batch_out.col(b) = lables.at(rIdx);
             }
-
-            doStochasticGradientDescentBatch(batch_in, batch_out, eta);
-
-            sendProg2Obs( NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpInProgress, double(batch)/double(nbrOfBatches) );
         }
 
-        retValue = true;
-    }
+        doStochasticGradientDescentBatch(batch_in, batch_out, eta);
 
-    m_operationInProgress = false;
+        m_trainedBatches++;
+        if( m_snapshotInterval > 0 && m_trainedBatches % m_snapshotInterval == 0 )
+            publishSnapshot();
 
-    if( retValue )
-    {
-        sendProg2Obs(NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpResultOk, 1.0);
-    }
-    else
-    {
-        sendProg2Obs(NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpResultErr, 1.0);
+        sendProg2Obs( NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpInProgress, double(batch)/double(nbrOfBatches) );
     }
 
-    return retValue;
+    publishSnapshot();
+
+    return true;
 }
 
 bool Network::doStochasticGradientDescentBatch(const Eigen::MatrixXd& batch_in, const Eigen::MatrixXd& batch_out, const double& eta)
@@ -225,24 +266,34 @@ bool Network::doStochasticGradientDescentBatch(const Eigen::MatrixXd& batch_in,
     {
         const std::shared_ptr<Layer>& l = getLayer(j);
 
-        Eigen::MatrixXd biasSum = Eigen::MatrixXd::Constant( l->getNbrOfNeurons(), 1, 0.0 );
-        Eigen::MatrixXd weightSum = Eigen::MatrixXd::Constant( l->getNbrOfNeurons(), l->getNbrOfNeuronInputs(), 0.0 );
+        Eigen::MatrixXd avgPDBias;
+        Eigen::MatrixXd avgPDWeights;
+        {
+            EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[NetworkStats::GradientReduction] );
 
-        vector<Eigen::MatrixXd> pd_biases = l->getPartialDerivativesBiases();
-        vector<Eigen::MatrixXd> pd_weigths = l->getPartialDerivativesWeights();
+            Eigen::MatrixXd biasSum = Eigen::MatrixXd::Constant( l->getNbrOfNeurons(), 1, 0.0 );
+            Eigen::MatrixXd weightSum = Eigen::MatrixXd::Constant( l->getNbrOfNeurons(), l->getNbrOfNeuronInputs(), 0.0 );
 
-        for( unsigned int k = 0; k < pd_biases.size(); k++ )
-        {
-            biasSum = biasSum + pd_biases.at(k);
-            weightSum = weightSum + pd_weigths.at(k);
+            const vector<Eigen::MatrixXd>& pd_biases = l->getPartialDerivativesBiases();
+            const vector<Eigen::MatrixXd>& pd_weigths = l->getPartialDerivativesWeights();
+
+            for( unsigned int k = 0; k < pd_biases.size(); k++ )
+            {
+                biasSum = biasSum + pd_biases.at(k);
+                weightSum = weightSum + pd_weigths.at(k);
+            }
+
+            avgPDBias = biasSum * ( eta / double(batchsize) );
+            avgPDWeights = weightSum * ( eta / double(batchsize) );
         }
 
         // update weights and biases in layer
-        Eigen::MatrixXd avgPDBias = biasSum * ( eta / double(batchsize) );
-        Eigen::MatrixXd avgPDWeights = weightSum * ( eta / double(batchsize) );
         l->updateWeightsAndBiases(avgPDBias, avgPDWeights, eta);
     }
 
+    EIDNN_STATS_COUNT( m_statsEnabled, m_statsBatches, 1 );
+    EIDNN_STATS_COUNT( m_statsEnabled, m_statsSamples, uint64_t(batchsize) );
+
     return true;
 }
 
@@ -332,63 +383,165 @@ void Network::sendProg2Obs( const NetworkOperationCallback::NetworkOperationId&
                                       const NetworkOperationCallback::NetworkOperationStatus& opStatus,
                                       const double& progress  )
 {
-    if( m_oberserver != NULL )
-        m_oberserver->networkOperationProgress( opId, opStatus, progress, m_userID );
+    EIDNN_STATS_SCOPE( m_statsEnabled, m_stats[NetworkStats::ObserverCallback] );
+    EIDNN_TRACE_SCOPE( "network", "observer callback" );
+
+    if( m_eventChannel )
+        m_eventChannel->progress( opId, opStatus, progress, m_userID );
 }
 
-bool Network::prepareForNextAsynchronousOperation()
+void Network::setObserver( NetworkOperationCallback* observer )
 {
-    if( isOperationInProgress() )
-    {
-        cout << "Error: Asynchronous operation already in progress" << endl;
-        return false;
-    }
-
-    m_operationInProgress = true;
-    if( m_asyncOperation.joinable() ) // Join former thread if done yet
-        m_asyncOperation.join();
+    // destroying the former channel delivers its pending events
+    m_eventChannel.reset();
+    m_oberserver = observer;
 
-    return true;
+    if( m_oberserver != NULL )
+        m_eventChannel.reset( new NetworkEventChannel( m_oberserver, m_observerRateLimit ) );
 }
 
-bool Network::testNetworkAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
-                       const double& euclideanDistanceThreshold, const int& userId )
+void Network::setObserverRateLimit( double maxProgressEventsPerSecond )
 {
-    if( !prepareForNextAsynchronousOperation() )
-        return false;
+    m_observerRateLimit = maxProgressEventsPerSecond;
+    if( m_eventChannel )
+        m_eventChannel->setMaxProgressEventsPerSecond( maxProgressEventsPerSecond );
+}
 
-    m_userID = userId;
-    m_asyncOperation = std::thread(&Network::doTestAsync, this,  samples, lables, euclideanDistanceThreshold);
-    return true;
+void Network::waitForObserver()
+{
+    if( m_eventChannel )
+        m_eventChannel->flush();
 }
 
-// this intermediate function is necessary because testNetwork results are passed by reference
-void Network::doTestAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
-                           const double& euclideanDistanceThreshold )
+NetworkJobPtr Network::enqueueJob( NetworkJobPtr job )
 {
-    double successRateEuclidean; double successRateMaxIdx; double avgCost; std::vector<size_t> failedSamples;
-    bool res = testNetwork( samples, lables, euclideanDistanceThreshold, true, successRateEuclidean, successRateMaxIdx, avgCost, failedSamples );
+    m_nbrOfPendingJobs++;
 
-    m_operationInProgress = false;
+    std::lock_guard<std::mutex> lock( m_jobsMutex );
+    m_jobs.push_back( job );
 
-    if( m_oberserver != NULL )
+    if( !m_jobsRunnerActive )
+    {
+        m_jobsRunnerActive = true;
+        Executor::global().post( [this]{ runJobs(); } );
+    }
+
+    return job;
+}
+
+void Network::runJobs()
+{
+    for(;;)
     {
-        if( res )
+        NetworkJobPtr job;
         {
-            m_oberserver->networkOperationProgress( NetworkOperationCallback::OpTestNetwork, NetworkOperationCallback::OpResultOk, 1.0, m_userID );
-            m_oberserver->networkTestResults( successRateEuclidean, successRateMaxIdx, avgCost, failedSamples, m_userID );
+            std::lock_guard<std::mutex> lock( m_jobsMutex );
+            m_runningJob.reset();
+            if( m_jobs.empty() )
+            {
+                // nothing must touch this network after the lock is released
+                m_jobsRunnerActive = false;
+                m_jobsIdle.notify_all();
+                return;
+            }
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            m_runningJob = job;
+        }
+
+        NetworkOperationCallback::NetworkOperationStatus opStatus = NetworkOperationCallback::OpCancelled;
+        NetworkJob::JobStatus jobStatus = NetworkJob::JobCancelled;
+
+        if( !job->isCancellationRequested() )
+        {
+            job->setRunning();
+            m_userID = job->getUserId();
+
+            bool res = job->m_work( *job );
+            if( job->isCancellationRequested() )
+            {
+                // result of an interrupted operation is not meaningful
+            }
+            else if( res )
+            {
+                opStatus = NetworkOperationCallback::OpResultOk;
+                jobStatus = NetworkJob::JobDone;
+            }
+            else
+            {
+                opStatus = NetworkOperationCallback::OpResultErr;
+                jobStatus = NetworkJob::JobFailed;
+            }
         }
-        else
+
+        job->m_work = nullptr; // release the captured samples
+        m_nbrOfPendingJobs--;
+
+        if( m_eventChannel )
         {
-            m_oberserver->networkOperationProgress( NetworkOperationCallback::OpTestNetwork, NetworkOperationCallback::OpResultErr, 1.0, m_userID );
+            m_eventChannel->progress( job->getOperationId(), opStatus, 1.0, job->getUserId() );
+            if( job->getOperationId() == NetworkOperationCallback::OpTestNetwork && jobStatus == NetworkJob::JobDone )
+            {
+                const NetworkTestResults& r = job->getTestResults();
+                m_eventChannel->testResults( r.successRateEuclidean, r.successRateMaxIdx, r.averageCost, r.failedSamplesIdx, job->getUserId() );
+            }
         }
+
+        job->finish( jobStatus );
     }
 }
 
+void Network::cancelOperations()
+{
+    std::lock_guard<std::mutex> lock( m_jobsMutex );
+    for( NetworkJobPtr& job : m_jobs )
+        job->cancel();
+
+    if( m_runningJob )
+        m_runningJob->cancel();
+}
+
+void Network::waitForOperations()
+{
+    std::unique_lock<std::mutex> lock( m_jobsMutex );
+    m_jobsIdle.wait( lock, [this]{ return !m_jobsRunnerActive; } );
+}
+
+NetworkJobPtr Network::testNetworkAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                                         const double& euclideanDistanceThreshold, const int& userId )
+{
+    NetworkJobPtr job( new NetworkJob( NetworkOperationCallback::OpTestNetwork, userId ) );
+    job->m_work = [this, samples, lables, euclideanDistanceThreshold]( NetworkJob& j )
+    {
+        NetworkTestResults& r = j.m_testResults;
+        return doTestNetwork( samples, lables, euclideanDistanceThreshold, true, r.successRateEuclidean, r.successRateMaxIdx,
+                              r.averageCost, r.failedSamplesIdx, j.getCancellationFlag() );
+    };
+
+    return enqueueJob( job );
+}
+
 bool Network::testNetwork(  const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
                             const double& euclideanDistanceThreshold, bool doCallback, double& successRateEuclideanDistance,
                             double& successRateIdenticalMax, double& avgCost, std::vector<size_t>& failedSamplesIdx )
 {
+    bool retValue = doTestNetwork( samples, lables, euclideanDistanceThreshold, doCallback, successRateEuclideanDistance,
+                                   successRateIdenticalMax, avgCost, failedSamplesIdx, NULL );
+
+    if( retValue && doCallback )
+        sendProg2Obs( NetworkOperationCallback::OpTestNetwork, NetworkOperationCallback::OpResultOk, 1.0 );
+
+    return retValue;
+}
+
+bool Network::doTestNetwork( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                             const double& euclideanDistanceThreshold, bool doCallback, double& successRateEuclideanDistance,
+                             double& successRateIdenticalMax, double& avgCost, std::vector<size_t>& failedSamplesIdx,
+                             const std::atomic<bool>* cancel )
+{
+    EIDNN_TRACE_SCOPE( "network", "test network" );
+
     if( samples.size() != lables.size() )
     {
         cout << "Error: samples and lables size mismatch" << endl;
@@ -402,6 +555,9 @@ bool Network::testNetwork(  const std::vector<Eigen::MatrixXd>& samples, const s
 
     for( size_t t = 0; t < nbrOfTestSamples; t++ )
     {
+        if( cancel != NULL && cancel->load( std::memory_order_relaxed ) )
+            return false;
+
         if( !feedForward(samples.at(t)) )
             return false;
 
@@ -440,9 +596,6 @@ bool Network::testNetwork(  const std::vector<Eigen::MatrixXd>& samples, const s
     successRateEuclideanDistance = successRateEuclideanDistance / double(nbrOfTestSamples);
     successRateIdenticalMax = successRateIdenticalMax / double(nbrOfTestSamples);
 
-    if( doCallback )
-        sendProg2Obs( NetworkOperationCallback::OpTestNetwork, NetworkOperationCallback::OpResultOk, 1.0 );
-
     return true;
 }
 
@@ -474,33 +627,68 @@ string Network::serialize() const
 Network* Network::deserialize( const string& buffer )
 {
     const char* buf = buffer.c_str();
+    const size_t size = buffer.size();
 
-    unsigned int nbrOfLayers = ((unsigned int*)buf)[0];
-    std::vector<unsigned int> networkStructure;
-    for( unsigned int i = 0; i < nbrOfLayers; i++ )
-        networkStructure.push_back( ((unsigned int*)buf)[i+1] );
+    unsigned int nbrOfLayers = 0;
+    if( size >= sizeof(unsigned int) )
+        std::memcpy( &nbrOfLayers, buf, sizeof(unsigned int) );
 
-    size_t offset = (nbrOfLayers+1) * sizeof(unsigned int);
+    if( nbrOfLayers == 0 || nbrOfLayers >= size / sizeof(unsigned int) )
+    {
+        cout << "Error: Corrupt network data" << endl;
+        return NULL;
+    }
 
-    Network* n = new Network( networkStructure );
+    std::vector<unsigned int> networkStructure( nbrOfLayers );
+    std::memcpy( networkStructure.data(), buf + sizeof(unsigned int), nbrOfLayers * sizeof(unsigned int) );
 
+    size_t offset = (nbrOfLayers+1) * sizeof(unsigned int);
+
+    // all layers are checked before the network is allocated
+    std::vector< unique_ptr<Layer> > layers;
     for( unsigned int i = 0; i < nbrOfLayers; i++ )
     {
-        const char* layerBuf = buf + offset;
-
-        unsigned int sizeOfThisLayer = ((unsigned int*)layerBuf)[0];
-        string layerData( layerBuf + sizeof(unsigned int), sizeOfThisLayer );
-        Layer* l = Layer::deserialize( layerData );
+        unsigned int sizeOfThisLayer = 0;
+        bool complete = size - offset >= sizeof(unsigned int);
+        if( complete )
+        {
+            std::memcpy( &sizeOfThisLayer, buf + offset, sizeof(unsigned int) );
+            complete = size - offset - sizeof(unsigned int) >= sizeOfThisLayer;
+        }
 
-        n->getLayer(i)->setBiases( l->getBiasVector() );
-        n->getLayer(i)->setWeights(l->getWeightMatrix() );
-        n->getLayer(i)->setLayerType( l->getLayerType() );
+        if( !complete )
+        {
+            cout << "Error: Network data too short" << endl;
+            return NULL;
+        }
 
-        delete l;
+        string layerData( buf + offset + sizeof(unsigned int), sizeOfThisLayer );
+        unique_ptr<Layer> l( Layer::deserialize( layerData ) );
+        if( !l || l->getNbrOfNeurons() != networkStructure[i] ||
+            l->getNbrOfNeuronInputs() != ( i == 0 ? 0 : networkStructure[i-1] ) )
+        {
+            cout << "Error: Layer does not match the network structure" << endl;
+            return NULL;
+        }
+        layers.push_back( std::move( l ) );
 
         offset = offset + sizeOfThisLayer + sizeof(unsigned int);
     }
 
+    if( offset != size )
+    {
+        cout << "Error: Unexpected data after the network" << endl;
+        return NULL;
+    }
+
+    Network* n = new Network( networkStructure, false );
+
+    for( unsigned int i = 0; i < nbrOfLayers; i++ )
+    {
+        n->getLayer(i)->setParameters( layers[i]->getParameters() );
+        n->getLayer(i)->setLayerType( layers[i]->getLayerType() );
+    }
+
     return n;
 }
 
@@ -564,9 +752,7 @@ std::vector<size_t> Network::randomIndices(size_t numberOfElements) const
     size_t n = 0;
     std::generate(rInd.begin(), rInd.end(), [n] () mutable { return n++; });
 
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(rInd.begin(), rInd.end(),g);
+    std::shuffle(rInd.begin(), rInd.end(), Helpers::randomGenerator());
 
     return rInd;
 }
@@ -607,3 +793,66 @@ void Network::resetWeights()
     for( std::shared_ptr<Layer>& l : m_Layers )
         l->resetRandomlyWeightsAndBiases();
 }
+
+NetworkSnapshotPtr Network::createSnapshot() const
+{
+    std::vector< std::shared_ptr<const LayerParameters> > params;
+    std::vector<Layer::LayerOutputType> types;
+    for( const std::shared_ptr<Layer>& l : m_Layers )
+    {
+        params.push_back( l->getParameters() );
+        types.push_back( l->getLayerType() );
+    }
+
+    double regCost = 0.0;
+    std::shared_ptr<Regularization> reg = getOutputLayer()->getRegularizationMethod();
+    if( reg->m_method == Regularization::RegularizationMethod::WeightDecay )
+        regCost = reg->m_lamda / 2.0 * getSumOfWeighSquares();
+
+    return NetworkSnapshotPtr( new NetworkSnapshot( m_NetworkStructure, params, types, getOutputLayer()->getCostFunction(),
+                                                    regCost, m_trainedBatches ) );
+}
+
+void Network::publishSnapshot()
+{
+    std::atomic_store( &m_snapshot, createSnapshot() );
+}
+
+NetworkSnapshotPtr Network::getSnapshot() const
+{
+    return std::atomic_load( &m_snapshot );
+}
+
+void Network::setStatsEnabled( bool enable )
+{
+    m_statsEnabled = enable;
+    for( std::shared_ptr<Layer>& l : m_Layers )
+        l->setStatsEnabled( enable );
+}
+
+NetworkStats Network::getStats() const
+{
+    NetworkStats s;
+    for( int p = 0; p < NetworkStats::NumberOfPhases; p++ )
+        s.phases[p] = m_stats[p].get();
+
+    for( const std::shared_ptr<Layer>& l : m_Layers )
+        s.layers.push_back( l->getStats() );
+
+    s.batches = m_statsBatches.load( std::memory_order_relaxed );
+    s.samples = m_statsSamples.load( std::memory_order_relaxed );
+
+    return s;
+}
+
+void Network::resetStats()
+{
+    for( PhaseCounter& c : m_stats )
+        c.reset();
+
+    for( std::shared_ptr<Layer>& l : m_Layers )
+        l->resetStats();
+
+    m_statsBatches = 0;
+    m_statsSamples = 0;
+}
@@ -0,0 +1,199 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "networkEventChannel.h"
+
+using namespace std;
+
+NetworkEventChannel::NetworkEventChannel( NetworkOperationCallback* observer, double maxProgressEventsPerSecond, size_t capacity ) :
+    m_observer( observer ), m_queue( capacity ), m_minProgressIntervalNs( 0 ), m_lastProgress()
+{
+    setMaxProgressEventsPerSecond( maxProgressEventsPerSecond );
+    m_consumer = std::thread( &NetworkEventChannel::run, this );
+}
+
+NetworkEventChannel::~NetworkEventChannel()
+{
+    m_stop = true;
+    {
+        std::lock_guard<std::mutex> lock( m_wakeMutex );
+        m_wake.notify_all();
+    }
+
+    if( m_consumer.joinable() )
+        m_consumer.join();
+}
+
+void NetworkEventChannel::setMaxProgressEventsPerSecond( double maxProgressEventsPerSecond )
+{
+    if( maxProgressEventsPerSecond > 0.0 )
+        m_minProgressIntervalNs = int64_t( 1.0e9 / maxProgressEventsPerSecond );
+    else
+        m_minProgressIntervalNs = 0;
+}
+
+void NetworkEventChannel::progress( const NetworkOperationCallback::NetworkOperationId& opId,
+                                    const NetworkOperationCallback::NetworkOperationStatus& opStatus,
+                                    const double& progress, const int& userId )
+{
+    const bool mandatory = opStatus != NetworkOperationCallback::OpInProgress;
+    std::lock_guard<std::mutex> producerLock( m_producerMutex );
+    if( !mandatory )
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if( chrono::duration_cast<chrono::nanoseconds>( now - m_lastProgress ).count() < m_minProgressIntervalNs )
+        {
+            m_skipped++;
+            return;
+        }
+        m_lastProgress = now;
+    }
+
+    NetworkEvent event;
+    event.type = NetworkEvent::Progress;
+    event.userId = userId;
+    event.opId = opId;
+    event.opStatus = opStatus;
+    event.progress = progress;
+    push( std::move( event ), mandatory );
+}
+
+void NetworkEventChannel::testResults( const double& successRateEuclidean, const double& successRateMaxIdx, const double& averageCost,
+                                       const std::vector<std::size_t>& failedSamplesIdx, const int& userId )
+{
+    NetworkEvent event;
+    event.type = NetworkEvent::TestResults;
+    event.userId = userId;
+    event.successRateEuclidean = successRateEuclidean;
+    event.successRateMaxIdx = successRateMaxIdx;
+    event.averageCost = averageCost;
+    event.failedSamplesIdx = failedSamplesIdx;
+
+    std::lock_guard<std::mutex> producerLock( m_producerMutex );
+    push( std::move( event ), true );
+}
+
+void NetworkEventChannel::push( NetworkEvent&& event, bool mandatory )
+{
+    // Once a result event went to the overflow list, later events
+    // must follow it there to keep the order.
+    bool overflowPending;
+    {
+        std::lock_guard<std::mutex> lock( m_overflowMutex );
+        overflowPending = !m_overflow.empty();
+        if( overflowPending && mandatory )
+        {
+            m_overflow.push_back( std::move( event ) );
+            m_queued++;
+        }
+    }
+
+    if( overflowPending )
+    {
+        if( !mandatory )
+            m_skipped++;
+    }
+    else if( m_queue.push( std::move( event ) ) )
+    {
+        m_queued++;
+    }
+    else if( mandatory )
+    {
+        // The observer does not keep up. The overflow mutex is never held
+        // while the observer is called, hence this does not wait for it.
+        std::lock_guard<std::mutex> lock( m_overflowMutex );
+        m_overflow.push_back( std::move( event ) );
+        m_queued++;
+    }
+    else
+    {
+        m_skipped++;
+        return;
+    }
+
+    m_wake.notify_one();
+}
+
+void NetworkEventChannel::flush()
+{
+    const uint64_t target = m_queued;
+    std::unique_lock<std::mutex> lock( m_wakeMutex );
+    m_wake.notify_one();
+    m_flushed.wait( lock, [this, target]{ return m_delivered >= target; } );
+}
+
+void NetworkEventChannel::run()
+{
+    NetworkEvent event;
+    std::vector<NetworkEvent> overflow;
+
+    for(;;)
+    {
+        bool idle = true;
+
+        while( m_queue.pop( event ) )
+        {
+            deliver( event );
+            idle = false;
+        }
+
+        // overflow events are always younger than the queued ones
+        {
+            std::lock_guard<std::mutex> lock( m_overflowMutex );
+            if( m_queue.empty() )
+                overflow.swap( m_overflow );
+        }
+        for( const NetworkEvent& e : overflow )
+        {
+            deliver( e );
+            idle = false;
+        }
+        overflow.clear();
+
+        if( !idle )
+            continue;
+
+        std::unique_lock<std::mutex> lock( m_wakeMutex );
+        m_flushed.notify_all();
+
+        if( m_stop )
+            break;
+
+        // producer does not take the mutex for notifying -> poll as fallback
+        m_wake.wait_for( lock, chrono::milliseconds( 10 ) );
+    }
+}
+
+void NetworkEventChannel::deliver( const NetworkEvent& event )
+{
+    if( m_observer != nullptr )
+    {
+        if( event.type == NetworkEvent::Progress )
+            m_observer->networkOperationProgress( event.opId, event.opStatus, event.progress, event.userId );
+        else
+            m_observer->networkTestResults( event.successRateEuclidean, event.successRateMaxIdx, event.averageCost,
+                                            event.failedSamplesIdx, event.userId );
+    }
+
+    m_delivered++;
+}
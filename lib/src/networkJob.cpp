@@ -0,0 +1,77 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "networkJob.h"
+
+#include <chrono>
+
+NetworkJob::NetworkJob( const NetworkOperationCallback::NetworkOperationId& opId, const int& userId ) :
+    m_opId( opId ), m_userId( userId )
+{
+}
+
+void NetworkJob::wait() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_finished.wait( lock, [this]{ return m_status != JobQueued && m_status != JobRunning; } );
+}
+
+bool NetworkJob::waitFor( const double& seconds ) const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_finished.wait_for( lock, std::chrono::duration<double>( seconds ),
+                                [this]{ return m_status != JobQueued && m_status != JobRunning; } );
+}
+
+bool NetworkJob::get() const
+{
+    wait();
+    return getStatus() == JobDone;
+}
+
+NetworkJob::JobStatus NetworkJob::getStatus() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_status;
+}
+
+bool NetworkJob::isFinished() const
+{
+    JobStatus status = getStatus();
+    return status != JobQueued && status != JobRunning;
+}
+
+void NetworkJob::setRunning()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_status = JobRunning;
+}
+
+void NetworkJob::finish( const JobStatus& status )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_status = status;
+    }
+    m_finished.notify_all();
+}
@@ -0,0 +1,159 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "networkSnapshot.h"
+#include "costFunction.h"
+#include "executor.h"
+#include "networkEventChannel.h"
+#include "helpers.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+NetworkSnapshot::NetworkSnapshot( const std::vector<unsigned int>& networkStructure,
+                                  const std::vector< std::shared_ptr<const LayerParameters> >& layerParameters,
+                                  const std::vector<Layer::LayerOutputType>& layerTypes,
+                                  const std::shared_ptr<CostFunction>& costFunction,
+                                  const double& regularizationCost, const uint64_t& version ) :
+    m_networkStructure( networkStructure ), m_layerParameters( layerParameters ), m_layerTypes( layerTypes ),
+    m_costFunction( costFunction ), m_regularizationCost( regularizationCost ), m_version( version )
+{
+}
+
+bool NetworkSnapshot::feedForward( const Eigen::MatrixXd& x_in, Eigen::MatrixXd& out ) const
+{
+    if( m_networkStructure.empty() || x_in.rows() != m_networkStructure.front() )
+    {
+        cout << "Error: Snapshot input signal size mismatch" << endl;
+        return false;
+    }
+
+    // first layer is the input layer
+    out = x_in;
+    Eigen::MatrixXd z;
+    for( unsigned int k = 1; k < getNumberOfLayer(); k++ )
+    {
+        const LayerParameters& p = *m_layerParameters[k];
+        z = p.weights * out + p.biases.replicate(1, out.cols());
+        Layer::activation( z, m_layerTypes[k], out );
+    }
+
+    return true;
+}
+
+bool NetworkSnapshot::test( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                            const double& euclideanDistanceThreshold, NetworkTestResults& results,
+                            const std::atomic<bool>* cancel ) const
+{
+    EIDNN_TRACE_SCOPE( "network", "test snapshot" );
+
+    if( samples.size() != lables.size() || samples.empty() )
+    {
+        cout << "Error: samples and lables size mismatch" << endl;
+        return false;
+    }
+
+    results = NetworkTestResults();
+
+    Eigen::MatrixXd outputSignal;
+    for( size_t t = 0; t < samples.size(); t++ )
+    {
+        if( cancel != nullptr && cancel->load( std::memory_order_relaxed ) )
+            return false;
+
+        if( !feedForward( samples[t], outputSignal ) )
+            return false;
+
+        const Eigen::MatrixXd& expectedSignal = lables[t];
+        results.averageCost += m_costFunction->cost( outputSignal, expectedSignal ) + m_regularizationCost;
+
+        if( (outputSignal - expectedSignal).norm() < euclideanDistanceThreshold )
+            results.successRateEuclidean += 1.0;
+
+        unsigned long expected_m, expected_n, out_m, out_n; double maxElem;
+        Helpers::maxElement(expectedSignal, expected_m, expected_n, maxElem);
+        Helpers::maxElement(outputSignal, out_m, out_n, maxElem);
+        if( out_m == expected_m )
+            results.successRateMaxIdx += 1.0;
+        else
+            results.failedSamplesIdx.push_back( t );
+    }
+
+    const double n = double( samples.size() );
+    results.averageCost /= n;
+    results.successRateEuclidean /= n;
+    results.successRateMaxIdx /= n;
+
+    return true;
+}
+
+NetworkJobPtr NetworkSnapshot::testAsync( const std::vector<Eigen::MatrixXd>& samples, const std::vector<Eigen::MatrixXd>& lables,
+                                          const double& euclideanDistanceThreshold, const int& userId,
+                                          const std::shared_ptr<NetworkEventChannel>& channel ) const
+{
+    NetworkJobPtr job( new NetworkJob( NetworkOperationCallback::OpTestNetwork, userId ) );
+    NetworkSnapshotPtr self = shared_from_this();
+
+    Executor::global().post( [self, job, samples, lables, euclideanDistanceThreshold, userId, channel]()
+    {
+        NetworkOperationCallback::NetworkOperationStatus opStatus = NetworkOperationCallback::OpCancelled;
+        NetworkJob::JobStatus jobStatus = NetworkJob::JobCancelled;
+
+        if( !job->isCancellationRequested() )
+        {
+            job->setRunning();
+            bool res = self->test( samples, lables, euclideanDistanceThreshold, job->m_testResults, job->getCancellationFlag() );
+            if( job->isCancellationRequested() )
+            {
+                // result of an interrupted test is not meaningful
+            }
+            else if( res )
+            {
+                opStatus = NetworkOperationCallback::OpResultOk;
+                jobStatus = NetworkJob::JobDone;
+            }
+            else
+            {
+                opStatus = NetworkOperationCallback::OpResultErr;
+                jobStatus = NetworkJob::JobFailed;
+            }
+        }
+
+        if( channel )
+        {
+            channel->progress( NetworkOperationCallback::OpTestNetwork, opStatus, 1.0, userId );
+            if( jobStatus == NetworkJob::JobDone )
+            {
+                const NetworkTestResults& r = job->getTestResults();
+                channel->testResults( r.successRateEuclidean, r.successRateMaxIdx, r.averageCost, r.failedSamplesIdx, userId );
+            }
+        }
+
+        job->finish( jobStatus );
+    });
+
+    return job;
+}
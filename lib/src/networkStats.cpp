@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "networkStats.h"
+
+#include <iomanip>
+#include <sstream>
+
+std::string LayerStats::phaseName( Phase phase )
+{
+    switch( phase )
+    {
+        case FeedForward:          return "feedforward";
+        case BackpropagationError: return "delta";
+        case PartialDerivatives:   return "partial derivatives";
+        case Update:               return "update";
+        default:                   return "";
+    }
+}
+
+std::string NetworkStats::phaseName( Phase phase )
+{
+    switch( phase )
+    {
+        case BatchGather:       return "batch gather";
+        case GradientReduction: return "gradient reduction";
+        case ObserverCallback:  return "observer callback";
+        default:                return "";
+    }
+}
+
+PhaseStats NetworkStats::total( LayerStats::Phase phase ) const
+{
+    PhaseStats t;
+    for( const LayerStats& l : layers )
+    {
+        t.count += l.phases[phase].count;
+        t.nanoseconds += l.phases[phase].nanoseconds;
+    }
+    return t;
+}
+
+std::string NetworkStats::toString() const
+{
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(3);
+    s << "batches: " << batches << ", samples: " << samples << std::endl;
+
+    for( size_t l = 1; l < layers.size(); l++ )
+    {
+        s << "layer " << l << ":";
+        for( int p = 0; p < LayerStats::NumberOfPhases; p++ )
+        {
+            const PhaseStats& ps = layers[l].phases[p];
+            s << "  " << LayerStats::phaseName( LayerStats::Phase(p) ) << " " << ps.seconds() * 1000.0 << " ms (" << ps.count << ")";
+        }
+        s << std::endl;
+    }
+
+    for( int p = 0; p < NumberOfPhases; p++ )
+        s << phaseName( Phase(p) ) << ": " << phases[p].seconds() * 1000.0 << " ms (" << phases[p].count << ")" << std::endl;
+
+    return s.str();
+}
+
+bool NetworkStats::isCompiledIn()
+{
+#ifdef EIDNN_STATS
+    return true;
+#else
+    return false;
+#endif
+}
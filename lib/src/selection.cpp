@@ -0,0 +1,162 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "selection.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    size_t drawCumulative( const std::vector<double>& cumulative, std::mt19937& gen )
+    {
+        std::uniform_real_distribution<double> dist( 0.0, cumulative.back() );
+        size_t k = size_t( std::upper_bound( cumulative.begin(), cumulative.end(), dist( gen ) ) - cumulative.begin() );
+        return std::min( k, cumulative.size() - 1 );
+    }
+}
+
+Selection::~Selection()
+{
+}
+
+size_t Selection::getNumberOfCandidates( size_t nbrOfSimulations ) const
+{
+    return nbrOfSimulations;
+}
+
+void Selection::prepare( const std::vector<double>& fitness )
+{
+    m_nbrOfCandidates = fitness.size();
+}
+
+std::pair<size_t, size_t> Selection::selectParents( std::mt19937& gen ) const
+{
+    size_t a = select( gen );
+    size_t b = select( gen );
+
+    // a few retries, a dominating candidate may be drawn again and again
+    for( int k = 0; k < 8 && b == a && m_nbrOfCandidates > 1; k++ )
+        b = select( gen );
+
+    return std::make_pair( a, b );
+}
+
+size_t TopTwoSelection::getNumberOfCandidates( size_t nbrOfSimulations ) const
+{
+    return std::min<size_t>( nbrOfSimulations, 2 );
+}
+
+size_t TopTwoSelection::select( std::mt19937& ) const
+{
+    return 0;
+}
+
+std::pair<size_t, size_t> TopTwoSelection::selectParents( std::mt19937& ) const
+{
+    return std::make_pair( 0, std::min<size_t>( 1, m_nbrOfCandidates - 1 ) );
+}
+
+EliteSelection::EliteSelection( size_t k )
+: m_k( std::max<size_t>( k, 2 ) )
+{
+}
+
+size_t EliteSelection::getNumberOfCandidates( size_t nbrOfSimulations ) const
+{
+    return std::min( nbrOfSimulations, m_k );
+}
+
+size_t EliteSelection::select( std::mt19937& gen ) const
+{
+    std::uniform_int_distribution<size_t> dist( 0, m_nbrOfCandidates - 1 );
+    return dist( gen );
+}
+
+TournamentSelection::TournamentSelection( size_t k )
+: m_k( std::max<size_t>( k, 1 ) )
+{
+}
+
+size_t TournamentSelection::select( std::mt19937& gen ) const
+{
+    // candidates are ordered, the smallest index wins
+    std::uniform_int_distribution<size_t> dist( 0, m_nbrOfCandidates - 1 );
+    size_t winner = std::numeric_limits<size_t>::max();
+    for( size_t k = 0; k < m_k; k++ )
+        winner = std::min( winner, dist( gen ) );
+    return winner;
+}
+
+RankSelection::RankSelection( double pressure )
+: m_pressure( std::min( std::max( pressure, 1.0 ), 2.0 ) )
+{
+}
+
+void RankSelection::prepare( const std::vector<double>& fitness )
+{
+    Selection::prepare( fitness );
+
+    const double n = double( fitness.size() );
+    m_cumulative.resize( fitness.size() );
+
+    double sum = 0.0;
+    for( size_t rank = 0; rank < fitness.size(); rank++ )
+    {
+        // rank 0 is the best
+        double position = n > 1.0 ? ( n - 1.0 - double( rank ) ) / ( n - 1.0 ) : 1.0;
+        sum += ( 2.0 - m_pressure ) + 2.0 * ( m_pressure - 1.0 ) * position;
+        m_cumulative[rank] = sum;
+    }
+}
+
+size_t RankSelection::select( std::mt19937& gen ) const
+{
+    return drawCumulative( m_cumulative, gen );
+}
+
+void FitnessProportionalSelection::prepare( const std::vector<double>& fitness )
+{
+    Selection::prepare( fitness );
+    m_cumulative.resize( fitness.size() );
+    if( fitness.empty() )
+        return;
+
+    double worst = *std::min_element( fitness.begin(), fitness.end() );
+    double range = *std::max_element( fitness.begin(), fitness.end() ) - worst;
+
+    // the worst keeps a small chance, all equal -> uniform
+    double floor = range > 0.0 ? range * 1e-3 : 1.0;
+
+    double sum = 0.0;
+    for( size_t k = 0; k < fitness.size(); k++ )
+    {
+        sum += fitness[k] - worst + floor;
+        m_cumulative[k] = sum;
+    }
+}
+
+size_t FitnessProportionalSelection::select( std::mt19937& gen ) const
+{
+    return drawCumulative( m_cumulative, gen );
+}
@@ -43,8 +43,23 @@ void Simulation::doStep()
 {
     if( isAlive() )
     {
+        std::chrono::milliseconds n = now();
+        m_stepDuration = (n - m_lastUpdate).count() / 1000.0;
         update();
-        setLastUpdateTime(now());
+        m_clock += m_stepDuration;
+        m_steps++;
+        setLastUpdateTime(n);
+    }
+}
+
+void Simulation::doStep( double dt )
+{
+    if( isAlive() )
+    {
+        m_stepDuration = dt;
+        update();
+        m_clock += dt;
+        m_steps++;
     }
 }
 
@@ -79,6 +94,11 @@ double Simulation::getTimeSinceLastUpdate() const
     return (now() - m_lastUpdate).count() / 1000.0;
 }
 
+double Simulation::getStepDuration() const
+{
+    return m_stepDuration;
+}
+
 const std::shared_ptr<Network>& Simulation::getNetwork() const
 {
     return m_network;
@@ -96,7 +116,12 @@ bool Simulation::isAlive() const
 
 double Simulation::getAge() const
 {
-    return ((double)(m_lastUpdate - m_creation).count()) / 1000.0;
+    return m_clock;
+}
+
+size_t Simulation::getNumberOfSteps() const
+{
+    return m_steps;
 }
 
 void Simulation::kill()
@@ -104,6 +129,16 @@ void Simulation::kill()
     m_alive = false;
 }
 
+void Simulation::reset()
+{
+    m_alive = true;
+    m_clock = 0.0;
+    m_stepDuration = 0.0;
+    m_steps = 0;
+    m_creation = now();
+    setLastUpdateTime(m_creation);
+}
+
 
 // Factory
 
@@ -120,18 +155,66 @@ SimulationPtr SimulationFactory::createRandomSimulation()
     return std::shared_ptr<Simulation>();
 }
 
-SimulationPtr SimulationFactory::createCrossover( SimulationPtr a, SimulationPtr b, double mutationRate)
+SimulationPtr SimulationFactory::createSimulation( NetworkPtr network )
 {
-    NetworkPtr cr = Genetic::crossover(a->getNetwork(), b->getNetwork(), Genetic::CrossoverMethod::Uniform, mutationRate);
     SimulationPtr crs = createRandomSimulation();
-    crs->setNetwork(cr);
+    if( crs )
+        crs->setNetwork(network);
     return crs;
 }
 
+SimulationPtr SimulationFactory::createCrossover( SimulationPtr a, SimulationPtr b, double mutationRate)
+{
+    NetworkPtr cr = Genetic::crossover(a->getNetwork(), b->getNetwork(), Genetic::CrossoverMethod::Uniform, mutationRate);
+    return createSimulation(cr);
+}
+
+SimulationPtr SimulationFactory::recycleCrossover( SimulationPtr recycled, SimulationPtr a, SimulationPtr b, double mutationRate )
+{
+    if( !recycled || !recycled->getNetwork() ||
+        !Genetic::crossoverInto(recycled->getNetwork(), a->getNetwork(), b->getNetwork(), Genetic::CrossoverMethod::Uniform, mutationRate) )
+    {
+        return createCrossover(a, b, mutationRate);
+    }
+
+    recycled->reset();
+    return recycled;
+}
+
+SimulationPtr SimulationFactory::recycleWithParameters( SimulationPtr recycled, SimulationPtr prototype, const Eigen::VectorXd& parameters )
+{
+    if( !recycled || !recycled->getNetwork() || !Genetic::setParameterVector( recycled->getNetwork(), parameters ) )
+    {
+        NetworkPtr net( new Network( *(prototype->getNetwork()) ) );
+        Genetic::setParameterVector( net, parameters );
+        return createSimulation( net );
+    }
+
+    recycled->reset();
+    return recycled;
+}
+
+bool SimulationFactory::doSteps( const std::vector<SimulationPtr>& sims, size_t start, size_t end, double dt )
+{
+    bool anyAlive = false;
+    for( size_t k = start; k < end; k++ )
+    {
+        const SimulationPtr& s = sims[k];
+        if( s->isAlive() )
+        {
+            if( dt > 0.0 )
+                s->doStep( dt );
+            else
+                s->doStep();
+            anyAlive = true;
+        }
+    }
+    return anyAlive;
+}
+
 SimulationPtr SimulationFactory::copy( SimulationPtr a )
 {
-    SimulationPtr crs = createRandomSimulation();
-    crs->setNetwork(a->getNetwork());
-    return crs;
+    // own network object, but shared weights
+    return createSimulation( NetworkPtr( new Network( *(a->getNetwork()) ) ) );
 }
 
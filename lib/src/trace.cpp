@@ -0,0 +1,247 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace
+{
+    // All fields are atomics, so the exporter may read a slot while the
+    // owning thread overwrites it. Such events are discarded when exporting.
+    struct TraceEvent
+    {
+        std::atomic<const char*> category{nullptr};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> start{0};
+        std::atomic<uint64_t> end{0};
+        std::atomic<uint32_t> tid{0};
+    };
+
+    struct ThreadBuffer
+    {
+        ThreadBuffer() : events( Trace::EventsPerThread ) { }
+
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> head{0};      // number of events written so far
+        std::atomic<uint64_t> cleared{0};   // events before this index were cleared
+        bool inUse = true;                  // guarded by registry mutex
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::map<uint32_t, std::string> threadNames;
+    };
+
+    Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+
+    std::atomic<uint32_t> s_nextTid{1};
+
+    // Per thread handle. When the thread ends, its buffer is handed over to
+    // the next new thread. The recorded events keep their thread id.
+    struct ThreadHandle
+    {
+        ThreadHandle() : tid( s_nextTid++ ) { }
+
+        ~ThreadHandle()
+        {
+            if( buffer )
+            {
+                std::lock_guard<std::mutex> guard( registry().mutex );
+                buffer->inUse = false;
+            }
+        }
+
+        ThreadBuffer* get()
+        {
+            if( !buffer )
+            {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> guard( r.mutex );
+                for( const std::shared_ptr<ThreadBuffer>& b : r.buffers )
+                {
+                    if( !b->inUse )
+                    {
+                        b->inUse = true;
+                        buffer = b;
+                        break;
+                    }
+                }
+
+                if( !buffer )
+                {
+                    buffer.reset( new ThreadBuffer() );
+                    r.buffers.push_back( buffer );
+                }
+            }
+
+            return buffer.get();
+        }
+
+        const uint32_t tid;
+        std::shared_ptr<ThreadBuffer> buffer;
+    };
+
+    thread_local ThreadHandle t_handle;
+
+    const std::chrono::steady_clock::time_point s_clockBase = std::chrono::steady_clock::now();
+
+    std::string jsonEscape( const std::string& in )
+    {
+        std::string out;
+        for( char c : in )
+        {
+            if( c == '"' || c == '\\' )
+                out.push_back( '\\' );
+            if( static_cast<unsigned char>(c) >= 0x20 )
+                out.push_back( c );
+        }
+        return out;
+    }
+}
+
+void Trace::setEnabled( bool enable )
+{
+    s_enabled.store( enable, std::memory_order_relaxed );
+}
+
+uint64_t Trace::now()
+{
+    return uint64_t( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - s_clockBase ).count() );
+}
+
+void Trace::record( const char* category, const char* name, uint64_t startNs, uint64_t endNs )
+{
+    ThreadBuffer* b = t_handle.get();
+
+    // single writer per buffer
+    uint64_t h = b->head.load( std::memory_order_relaxed );
+    TraceEvent& e = b->events[ h % EventsPerThread ];
+    e.category.store( category, std::memory_order_relaxed );
+    e.name.store( name, std::memory_order_relaxed );
+    e.start.store( startNs, std::memory_order_relaxed );
+    e.end.store( endNs, std::memory_order_relaxed );
+    e.tid.store( t_handle.tid, std::memory_order_relaxed );
+    b->head.store( h + 1, std::memory_order_release );
+}
+
+void Trace::setThreadName( const std::string& name )
+{
+    std::lock_guard<std::mutex> guard( registry().mutex );
+    registry().threadNames[t_handle.tid] = name;
+}
+
+void Trace::exportChromeJson( std::ostream& out )
+{
+    Registry& r = registry();
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::map<uint32_t, std::string> names;
+    {
+        std::lock_guard<std::mutex> guard( r.mutex );
+        buffers = r.buffers;
+        names = r.threadNames;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    for( const auto& n : names )
+    {
+        out << (first ? "" : ",") << std::endl;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << n.first
+            << ",\"args\":{\"name\":\"" << jsonEscape( n.second ) << "\"}}";
+        first = false;
+    }
+
+    struct Copy { const char* category; const char* name; uint64_t start; uint64_t end; uint32_t tid; };
+    std::vector<Copy> copies;
+
+    for( const std::shared_ptr<ThreadBuffer>& b : buffers )
+    {
+        uint64_t headBefore = b->head.load( std::memory_order_acquire );
+        uint64_t begin = headBefore > EventsPerThread ? headBefore - EventsPerThread : 0;
+        begin = std::max( begin, b->cleared.load( std::memory_order_relaxed ) );
+
+        copies.clear();
+        for( uint64_t i = begin; i < headBefore; i++ )
+        {
+            const TraceEvent& e = b->events[ i % EventsPerThread ];
+            copies.push_back( { e.category.load( std::memory_order_relaxed ), e.name.load( std::memory_order_relaxed ),
+                                e.start.load( std::memory_order_relaxed ), e.end.load( std::memory_order_relaxed ),
+                                e.tid.load( std::memory_order_relaxed ) } );
+        }
+
+        // discard events which could have been overwritten meanwhile
+        std::atomic_thread_fence( std::memory_order_acquire );
+        uint64_t headAfter = b->head.load( std::memory_order_relaxed );
+        uint64_t firstValid = headAfter >= EventsPerThread ? headAfter - EventsPerThread + 1 : 0;
+
+        for( uint64_t i = begin; i < headBefore; i++ )
+        {
+            const Copy& c = copies[ i - begin ];
+            if( i < firstValid || c.name == nullptr || c.category == nullptr )
+                continue;
+
+            out << (first ? "" : ",") << std::endl;
+            out << "{\"name\":\"" << c.name << "\",\"cat\":\"" << c.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << c.tid
+                << ",\"ts\":" << double(c.start) / 1000.0 << ",\"dur\":" << double(c.end - c.start) / 1000.0 << "}";
+            first = false;
+        }
+    }
+
+    out << std::endl << "]}" << std::endl;
+}
+
+bool Trace::save( const std::string& filePath )
+{
+    std::ofstream traceFile( filePath );
+    if( !traceFile.is_open() )
+        return false;
+
+    exportChromeJson( traceFile );
+    return traceFile.good();
+}
+
+void Trace::clear()
+{
+    std::lock_guard<std::mutex> guard( registry().mutex );
+    for( const std::shared_ptr<ThreadBuffer>& b : registry().buffers )
+        b->cleared.store( b->head.load( std::memory_order_acquire ), std::memory_order_relaxed );
+}
@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#ifndef ONESTEPSIMULATIONHEADER
+#define ONESTEPSIMULATIONHEADER
+
+#include "simulation.h"
+#include "network.h"
+
+/**
+ * Test simulation ending after one step. Its network is the fitter, the
+ * closer its output for a fixed input is to (0.5, 0.5).
+ */
+class OneStepSimulation: public Simulation
+{
+public:
+
+    OneStepSimulation()
+    {
+        std::vector<unsigned int> map = {2,10,2};
+        m_network = NetworkPtr( new Network(map) );
+    }
+
+    ~OneStepSimulation()
+    {
+
+    }
+
+    double getFitness() override
+    {
+        Eigen::MatrixXd should(2,1);
+        should(0,0) = 0.5;
+        should(1,0) = 0.5;
+
+        double diff = (should - m_network->getOutputActivation()).norm();
+        double fitness = 1.0 / diff;
+        return fitness;
+    }
+
+protected:
+
+    void update() override
+    {
+        Eigen::MatrixXd mat(2,1);
+        mat(0,0) = 0.2;
+        mat(1,0) = 0.4;
+        m_network->feedForward(mat);
+        m_alive = false;
+    }
+
+};
+
+class OneStepSimFactory: public SimulationFactory
+{
+public:
+    OneStepSimFactory()
+    {
+
+    }
+
+    ~OneStepSimFactory()
+    {
+
+    }
+
+    std::shared_ptr<Simulation> createRandomSimulation() override
+    {
+        return std::shared_ptr<OneStepSimulation>(new OneStepSimulation());
+    }
+
+};
+
+#endif // ONESTEPSIMULATIONHEADER
@@ -26,68 +26,14 @@
 #include "network.h"
 #include "genetic.h"
 #include "helpers.h"
+#include "tripleBuffer.h"
+#include "oneStepSimulation.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <memory>
-
-
-class OneStepSimulation: public Simulation
-{
-public:
-
-    OneStepSimulation()
-    {
-        std::vector<unsigned int> map = {2,10,2};
-        m_network = NetworkPtr( new Network(map) );
-    }
-
-    ~OneStepSimulation()
-    {
-
-    }
-
-    double getFitness() override
-    {
-        Eigen::MatrixXd should(2,1);
-        should(0,0) = 0.5;
-        should(1,0) = 0.5;
-
-        double diff = (should - m_network->getOutputActivation()).norm();
-        double fitness = 1.0 / diff;
-        return fitness;
-    }
-
-protected:
-
-    void update() override
-    {
-        Eigen::MatrixXd mat(2,1);
-        mat(0,0) = 0.2;
-        mat(1,0) = 0.4;
-        m_network->feedForward(mat);
-        m_alive = false;
-    }
-
-};
-
-class OneStepSimFactory: public SimulationFactory
-{
-public:
-    OneStepSimFactory()
-    {
-
-    }
-
-    ~OneStepSimFactory()
-    {
-
-    }
-
-    std::shared_ptr<Simulation> createRandomSimulation() override
-    {
-        return std::shared_ptr<OneStepSimulation>(new OneStepSimulation());
-    }
-
-};
-
+#include <set>
+#include <thread>
 
 
 TEST(Evolution, InitialRun)
@@ -181,4 +127,598 @@ TEST(Evolution, SaveAndLoad)
 
     delete e;
     delete q;
-}
\ No newline at end of file
+}
+TEST(Evolution, BreedRecyclesSimulations)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    Evolution* e = new Evolution(50,50,f,3);
+    e->doEpoch();
+
+    std::set<Simulation*> former;
+    SimulationPtr kept;
+    {
+        std::vector<SimulationPtr> sims = e->getSimulationsOrderedByFitness();
+        for( const SimulationPtr& s : sims )
+            former.insert( s.get() );
+        kept = sims.back(); // referenced from outside -> must not be reused
+    }
+
+    e->breed();
+
+    // offsprings and parents, all alive again
+    ASSERT_EQ( e->getNumberAliveAndDead().first, 52u );
+    ASSERT_EQ( e->getNumberAliveAndDead().second, 0u );
+    e->doEpoch();
+
+    std::vector<SimulationPtr> sims = e->getSimulationsOrderedByFitness();
+    ASSERT_EQ( sims.size(), 52u );
+
+    size_t reused = 0;
+    for( const SimulationPtr& s : sims )
+    {
+        ASSERT_NE( s.get(), kept.get() );
+        if( former.count( s.get() ) )
+            reused++;
+    }
+
+    // all but the two parents and the kept one
+    ASSERT_EQ( reused, 47u );
+    ASSERT_FALSE( kept->isAlive() );
+
+    delete e;
+}
+
+TEST(Evolution, FixedTimeStepReproducible)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    auto run = [f]() -> std::vector<double>
+    {
+        Helpers::seedRandomGenerator(42);
+
+        Evolution e(40,60,f,3);
+        e.setMutationRate(0.1);
+        e.setFixedTimeStep(0.05);
+
+        std::vector<double> fitnesses;
+        for( int k = 0; k < 4; k++ )
+        {
+            e.doEpoch();
+            for( const SimulationPtr& s : e.getSimulationsOrderedByFitness() )
+                fitnesses.push_back( s->getFitness() );
+            EXPECT_DOUBLE_EQ( e.getEpochSimulatedTime(), 0.05 );
+            e.breed();
+        }
+        return fitnesses;
+    };
+
+    std::vector<double> first = run();
+    std::vector<double> second = run();
+
+    // do not make the following tests deterministic
+    Helpers::seedRandomGenerator( std::random_device{}() );
+
+    ASSERT_EQ( first.size(), 40u + 3*62u );
+    ASSERT_EQ( first, second );
+}
+
+TEST(Evolution, Checkpoint)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    auto runEpochs = []( Evolution& e ) -> std::vector<double>
+    {
+        std::vector<double> fitnesses;
+        for( int k = 0; k < 3; k++ )
+        {
+            e.breed();
+            e.doEpoch();
+            for( const SimulationPtr& s : e.getSimulationsOrderedByFitness() )
+                fitnesses.push_back( s->getFitness() );
+        }
+        return fitnesses;
+    };
+
+    Helpers::seedRandomGenerator(42);
+    Evolution e(40,60,f,3);
+    e.setMutationRate(0.1);
+    e.setFixedTimeStep(0.05);
+    e.doEpoch();
+    ASSERT_TRUE( e.saveCheckpointAsync("evolution.pop") );
+    std::vector<double> first = runEpochs( e );
+    ASSERT_TRUE( e.waitForCheckpoint() );
+
+    // different random generator state and settings, all replaced by the checkpoint
+    Helpers::seedRandomGenerator(7);
+    Evolution q(10,20,f,3);
+    ASSERT_TRUE( q.loadCheckpoint("evolution.pop") );
+    ASSERT_TRUE( q.isEpochOver() );
+    ASSERT_DOUBLE_EQ( q.getMutationRate(), 0.1 );
+    ASSERT_EQ( q.getSimulationsOrderedByFitness().size(), 40u );
+    std::vector<double> second = runEpochs( q );
+
+    Helpers::seedRandomGenerator( std::random_device{}() );
+
+    ASSERT_EQ( first.size(), 3*62u );
+    ASSERT_EQ( first, second );
+
+    // invalid files leave the evolution untouched
+    ASSERT_FALSE( q.loadCheckpoint("missing.pop") );
+    {
+        std::ofstream out( "corrupt.pop", std::ios::binary | std::ios::trunc );
+        out << std::string( 200, 'x' );
+    }
+    ASSERT_FALSE( q.loadCheckpoint("corrupt.pop") );
+    ASSERT_EQ( q.getSimulationsOrderedByFitness().size(), 62u );
+
+    // a corrupt layer count of the first genome, the genomes of the
+    // 40 simulations and the fittest are the end of the file
+    {
+        std::ifstream in( "evolution.pop", std::ios::binary );
+        std::string file( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+        size_t genomeSize = f->createRandomSimulation()->getNetwork()->serialize().size();
+        ASSERT_GT( file.size(), 41 * genomeSize );
+        std::memset( &file[file.size() - 41 * genomeSize], 0xff, sizeof(unsigned int) );
+
+        std::ofstream out( "corrupt.pop", std::ios::binary | std::ios::trunc );
+        out << file;
+    }
+    ASSERT_FALSE( q.loadCheckpoint("corrupt.pop") );
+    ASSERT_EQ( q.getSimulationsOrderedByFitness().size(), 62u );
+
+    // crafted header fields, at their offsets in the header
+    auto writeHeaderField = []( size_t offset, uint64_t value, size_t bytes, uint64_t blobSize )
+    {
+        std::ifstream in( "evolution.pop", std::ios::binary );
+        std::string file( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+        std::memcpy( &file[offset], &value, bytes );
+        if( blobSize > 0 )
+            std::memcpy( &file[112], &blobSize, sizeof(blobSize) );
+
+        std::ofstream out( "corrupt.pop", std::ios::binary | std::ios::trunc );
+        out << file;
+        return file.size();
+    };
+
+    // more simulations than the file holds, with the blob size wrapping
+    // the end of the blob around to the file size
+    uint32_t rngSize = 0;
+    {
+        std::ifstream in( "evolution.pop", std::ios::binary );
+        in.seekg( 108 );
+        in.read( reinterpret_cast<char*>( &rngSize ), sizeof(rngSize) );
+    }
+    const uint64_t nbrOfSimulations = 1000;
+    size_t fileSize = writeHeaderField( 40, nbrOfSimulations, sizeof(uint64_t), 0 );
+    uint64_t blobPos = 128 + rngSize + ( nbrOfSimulations + 1 ) * 24;
+    ASSERT_GT( blobPos, fileSize );
+    writeHeaderField( 40, nbrOfSimulations, sizeof(uint64_t), uint64_t( fileSize ) - blobPos );
+    ASSERT_FALSE( q.loadCheckpoint("corrupt.pop") );
+
+    // a simulation count overflowing the genome count
+    writeHeaderField( 40, ~uint64_t( 0 ), sizeof(uint64_t), 0 );
+    ASSERT_FALSE( q.loadCheckpoint("corrupt.pop") );
+
+    // an unknown epoch end
+    writeHeaderField( 104, 99, sizeof(uint32_t), 0 );
+    ASSERT_FALSE( q.loadCheckpoint("corrupt.pop") );
+    ASSERT_EQ( q.getSimulationsOrderedByFitness().size(), 62u );
+
+    // settings are limited like by their setters
+    writeHeaderField( 64, 0, sizeof(uint64_t), 0 );
+    ASSERT_TRUE( q.loadCheckpoint("corrupt.pop") );
+    ASSERT_EQ( q.getTopK(), 2u );
+    q.breed();
+    ASSERT_FALSE( q.isEpochOver() );
+}
+
+TEST(Evolution, Statistics)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    Evolution e(40,60,f,3);
+    ASSERT_TRUE( e.getStepStatistics().empty() );
+
+    for( int k = 0; k < 3; k++ )
+    {
+        e.doEpoch();
+        ASSERT_DOUBLE_EQ( e.getEpochStatistics(1).front().maxFitness, e.getFittest().front()->getFitness() );
+        e.breed();
+    }
+
+    // one step per epoch
+    std::vector<Evolution::StepStatistics> steps = e.getStepStatistics();
+    ASSERT_EQ( steps.size(), 3u );
+    ASSERT_EQ( e.getStepStatistics(1).size(), 1u );
+    ASSERT_EQ( steps.front().step, 1u );
+    ASSERT_EQ( steps.back().step, 3u );
+    ASSERT_EQ( steps.front().alive, 0u );
+    ASSERT_EQ( steps.front().dead, 40u );
+    ASSERT_EQ( steps.back().dead, 62u );
+
+    std::vector<Evolution::EpochStatistics> epochs = e.getEpochStatistics();
+    ASSERT_EQ( epochs.size(), 3u );
+    ASSERT_EQ( epochs.front().simulations, 40u );
+    ASSERT_EQ( epochs.front().breedSeconds, 0.0 );
+    ASSERT_GT( epochs.back().breedSeconds, 0.0 );
+    ASSERT_EQ( epochs.front().end, Evolution::EpochEnd::AllDead );
+
+    for( size_t k = 0; k < epochs.size(); k++ )
+    {
+        const Evolution::EpochStatistics& s = epochs[k];
+        ASSERT_EQ( s.steps, 1u );
+        ASSERT_EQ( s.maxFitness, steps[k].maxFitness );
+        ASSERT_DOUBLE_EQ( s.meanFitness, steps[k].meanFitness );
+        ASSERT_LE( s.minFitness, s.fitnessPercentiles[0] );
+        for( size_t p = 1; p < Evolution::EpochStatistics::NumberOfPercentiles; p++ )
+            ASSERT_LE( s.fitnessPercentiles[p-1], s.fitnessPercentiles[p] );
+        ASSERT_LE( s.fitnessPercentiles[Evolution::EpochStatistics::NumberOfPercentiles-1], s.maxFitness );
+        ASSERT_EQ( s.survival[0], 0.0 );
+    }
+}
+
+TEST(Evolution, RunOnThread)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    Evolution e(40,60,f,2);
+    e.setFixedTimeStep(0.05);
+
+    TripleBuffer<size_t> nbrOfSims;
+    std::atomic<size_t> calls{0};
+    e.start( [&]( const std::vector<SimulationPtr>& sims )
+    {
+        nbrOfSims.getWriteBuffer() = sims.size();
+        nbrOfSims.publish();
+        calls++;
+    }, 2 );
+    ASSERT_TRUE( e.isRunning() );
+
+    // consume snapshots while the evolution goes on
+    std::vector<size_t> seen;
+    for( int k = 0; k < 2000 && ( e.getNumberOfEpochs() < 5 || seen.empty() ); k++ )
+    {
+        if( nbrOfSims.update() )
+            seen.push_back( nbrOfSims.getReadBuffer() );
+        std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+    }
+
+    e.stop();
+    ASSERT_FALSE( e.isRunning() );
+    size_t callsAfterStop = calls;
+
+    ASSERT_GE( e.getNumberOfEpochs(), 5u );
+    ASSERT_FALSE( seen.empty() );
+    for( size_t n : seen )
+        ASSERT_TRUE( n == 40u || n == 62u );
+
+    // stopped, no more steps
+    std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+    ASSERT_EQ( calls, callsAfterStop );
+}
+
+TEST(Evolution, TopK)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    Evolution e(100,100,f,3);
+    e.setTopK(5);
+    ASSERT_EQ( e.getTopK(), 5u );
+
+    for( int k = 0; k < 3; k++ )
+    {
+        e.doEpoch();
+
+        std::vector<SimulationPtr> fittest = e.getFittest();
+        std::vector<SimulationPtr> ordered = e.getSimulationsOrderedByFitness();
+        ASSERT_EQ( fittest.size(), 5u );
+        ASSERT_EQ( ordered.size(), e.getNumberAliveAndDead().second );
+
+        for( size_t i = 0; i < fittest.size(); i++ )
+            ASSERT_EQ( fittest[i], ordered[i] );
+        for( size_t i = 1; i < ordered.size(); i++ )
+            ASSERT_GE( ordered[i-1]->getFitness(), ordered[i]->getFitness() );
+
+        // partial ordering
+        std::vector<SimulationPtr> best3 = e.getSimulationsOrderedByFitness( 3 );
+        ASSERT_EQ( best3.size(), 3u );
+        for( size_t i = 0; i < best3.size(); i++ )
+            ASSERT_EQ( best3[i], ordered[i] );
+
+        e.breed();
+    }
+
+    // at least the two parents
+    e.setTopK(1);
+    ASSERT_EQ( e.getTopK(), 2u );
+}
+
+TEST(Evolution, Elitism)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    Evolution e(100,40,f,3);
+    ASSERT_EQ( e.getElitism(), 2u );
+    e.setKeepParents( false );
+    ASSERT_EQ( e.getElitism(), 0u );
+    ASSERT_FALSE( e.isKeepParents() );
+
+    // more than the top known of an epoch
+    e.setElitism( 5 );
+    ASSERT_TRUE( e.isKeepParents() );
+
+    double best = 0.0;
+    for( int k = 0; k < 3; k++ )
+    {
+        e.doEpoch();
+        std::vector<SimulationPtr> ordered = e.getSimulationsOrderedByFitness();
+        ASSERT_GE( ordered.front()->getFitness(), best );
+        best = ordered.front()->getFitness();
+
+        std::vector<Eigen::VectorXd> elites;
+        for( size_t i = 0; i < 5; i++ )
+            elites.push_back( Genetic::getParameterVector( ordered[i]->getNetwork() ) );
+
+        e.breed();
+        ASSERT_EQ( e.getNumberAliveAndDead().first, 45u );
+
+        // unchanged, after the offsprings
+        std::vector<SimulationPtr> next = e.getSimulationsOrderedByFitness();
+        for( size_t i = 0; i < 5; i++ )
+            ASSERT_EQ( Genetic::getParameterVector( next[40 + i]->getNetwork() ), elites[i] );
+    }
+}
+
+TEST(Evolution, Selection)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    auto run = [f]( std::shared_ptr<Selection> selection ) -> std::vector<double>
+    {
+        Helpers::seedRandomGenerator( 21 );
+        Evolution e(60,40,f,3);
+        e.setMutationRate( 0.1 );
+        e.setSelection( selection );
+
+        std::vector<double> best;
+        for( int k = 0; k < 6; k++ )
+        {
+            e.doEpoch();
+            best.push_back( e.getFittest().front()->getFitness() );
+            e.breed();
+
+            // offsprings plus the two kept parents
+            EXPECT_EQ( e.getNumberAliveAndDead().first, 42u );
+        }
+        return best;
+    };
+
+    std::vector<std::shared_ptr<Selection>> strategies = {
+        std::shared_ptr<Selection>( new TournamentSelection( 3 ) ),
+        std::shared_ptr<Selection>( new RankSelection() ),
+        std::shared_ptr<Selection>( new FitnessProportionalSelection() ),
+        std::shared_ptr<Selection>( new EliteSelection( 10 ) ) };
+
+    for( std::shared_ptr<Selection> s : strategies )
+    {
+        std::vector<double> best = run( s );
+
+        // the best are kept
+        for( size_t k = 1; k < best.size(); k++ )
+            ASSERT_GE( best[k], best[k-1] );
+
+        // independent of the thread scheduling
+        ASSERT_EQ( best, run( s ) );
+    }
+}
+
+TEST(Evolution, EvolutionStrategy)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    auto run = [f]( EvolutionStrategy::Covariance covariance ) -> std::vector<double>
+    {
+        Helpers::seedRandomGenerator( 5 );
+        Evolution e(40,20,f,3);
+        e.setKeepParents( false );
+
+        // away from the optimum, the zero network hits the target exactly
+        size_t n = Genetic::getNumberOfParameters( e.getFittest().front()->getNetwork() );
+        std::shared_ptr<EvolutionStrategy> es( new EvolutionStrategy( Eigen::VectorXd::Constant( n, 1.0 ), 1.0, covariance ) );
+        EXPECT_TRUE( e.setEvolutionStrategy( es ) );
+
+        std::vector<double> best;
+        for( int k = 0; k < 60; k++ )
+        {
+            e.doEpoch();
+            e.breed();
+
+            // the mean of the strategy
+            SimulationPtr mean = f->createRandomSimulation();
+            Genetic::setParameterVector( mean->getNetwork(), es->getMean() );
+            mean->doStep( 0.1 );
+            best.push_back( mean->getFitness() );
+            EXPECT_EQ( e.getNumberAliveAndDead().first, 20u );
+        }
+        // the random first epoch was not sampled from the strategy
+        EXPECT_EQ( es->getNumberOfGenerations(), 59u );
+        return best;
+    };
+
+    for( EvolutionStrategy::Covariance c : { EvolutionStrategy::Full, EvolutionStrategy::Diagonal } )
+    {
+        std::vector<double> best = run( c );
+        ASSERT_GT( best.back(), best.front() );
+
+        // independent of the thread scheduling
+        ASSERT_EQ( best, run( c ) );
+    }
+
+    // a strategy not matching the networks or without two offsprings to
+    // update it is refused, the run would stall in breed()
+    Evolution e(10,1,f,3);
+    size_t n = Genetic::getNumberOfParameters( e.getFittest().front()->getNetwork() );
+    ASSERT_FALSE( e.setEvolutionStrategy( std::make_shared<EvolutionStrategy>( Eigen::VectorXd::Zero( n ), 1.0 ) ) );
+    Evolution g(10,10,f,3);
+    ASSERT_FALSE( g.setEvolutionStrategy( std::make_shared<EvolutionStrategy>( Eigen::VectorXd::Zero( n + 1 ), 1.0 ) ) );
+    ASSERT_TRUE( g.setEvolutionStrategy( std::make_shared<EvolutionStrategy>( Eigen::VectorXd::Zero( n ), 1.0 ) ) );
+    ASSERT_TRUE( g.setEvolutionStrategy( nullptr ) );
+}
+
+TEST(Evolution, SteadyState)
+{
+    std::shared_ptr<OneStepSimFactory> f(new OneStepSimFactory());
+
+    auto run = [f]() -> std::vector<double>
+    {
+        Helpers::seedRandomGenerator(7);
+
+        Evolution e(200,200,f,3);
+        e.setMutationRate(0.05);
+        e.setFixedTimeStep(0.05);
+        e.setSteadyState(true);
+        e.setArchiveSize(10);
+        EXPECT_TRUE( e.isSteadyState() );
+
+        for( int k = 0; k < 30; k++ )
+        {
+            e.doStep();
+
+            // dead ones are replaced right away
+            EXPECT_FALSE( e.isEpochOver() );
+            EXPECT_EQ( e.getNumberAliveAndDead().first, 200u );
+        }
+
+        EXPECT_EQ( e.getNumberOfEpochs(), 0u );
+        EXPECT_EQ( e.getNumberOfReplacements(), 30u * 200u );
+
+        std::vector<SimulationPtr> archive = e.getArchive();
+        EXPECT_EQ( archive.size(), 10u );
+
+        std::vector<double> fitnesses;
+        for( const SimulationPtr& s : archive )
+            fitnesses.push_back( s->getFitness() );
+        return fitnesses;
+    };
+
+    std::vector<double> first = run();
+    std::vector<double> second = run();
+
+    // do not make the following tests deterministic
+    Helpers::seedRandomGenerator( std::random_device{}() );
+
+    ASSERT_EQ( first, second );
+    ASSERT_TRUE( std::is_sorted( first.rbegin(), first.rend() ) );
+
+    // offsprings of the archive improve
+    ASSERT_GT( first.front(), 50.0 );
+}
+
+// dies after a number of steps, every second one never dies
+class TimedSimulation: public Simulation
+{
+public:
+    TimedSimulation( size_t lifeSteps, bool growing ): m_lifeSteps(lifeSteps), m_growing(growing)
+    {
+        m_network = NetworkPtr( new Network( {2,2} ) );
+    }
+
+    double getFitness() override
+    {
+        return m_growing ? getAge() : 1.0;
+    }
+
+protected:
+    void update() override
+    {
+        if( m_lifeSteps > 0 && getNumberOfSteps() + 1 >= m_lifeSteps )
+            m_alive = false;
+    }
+
+private:
+    size_t m_lifeSteps;
+    bool m_growing;
+};
+
+class TimedSimFactory: public SimulationFactory
+{
+public:
+    TimedSimFactory( bool growing ): m_growing(growing) { }
+
+    std::shared_ptr<Simulation> createRandomSimulation() override
+    {
+        m_count++;
+        return std::make_shared<TimedSimulation>( m_count % 2 ? 2 : 0, m_growing );
+    }
+
+private:
+    size_t m_count = 0;
+    bool m_growing;
+};
+
+TEST(Evolution, EpochTermination)
+{
+    // survivors are cut off after the simulated time, their fitness counts
+    {
+        Evolution e(10,10,std::make_shared<TimedSimFactory>(true),2);
+        e.setFixedTimeStep(0.1);
+        Evolution::EpochTermination t;
+        t.maxSimulatedTime = 0.95;
+        e.setEpochTermination(t);
+
+        size_t steps = 0;
+        while( !e.isEpochOver() && steps < 100 )
+        {
+            e.doStep();
+            steps++;
+        }
+
+        ASSERT_EQ( steps, 10u );
+        ASSERT_EQ( e.getLastEpochEnd(), Evolution::EpochEnd::SimulatedTime );
+        ASSERT_EQ( e.getNumberAliveAndDead().first, 0u );
+        ASSERT_NEAR( e.getFittest().front()->getFitness(), 1.0, 1e-9 );
+    }
+
+    // step cap per simulation
+    {
+        Evolution e(10,10,std::make_shared<TimedSimFactory>(true),2);
+        e.setFixedTimeStep(0.1);
+        Evolution::EpochTermination t;
+        t.maxStepsPerSimulation = 5;
+        e.setEpochTermination(t);
+
+        size_t steps = 0;
+        while( !e.isEpochOver() && steps < 100 )
+        {
+            e.doStep();
+            steps++;
+        }
+
+        ASSERT_EQ( steps, 5u );
+        ASSERT_EQ( e.getLastEpochEnd(), Evolution::EpochEnd::AllDead );
+        for( const SimulationPtr& s : e.getSimulationsOrderedByFitness() )
+            ASSERT_LE( s->getNumberOfSteps(), 5u );
+    }
+
+    // half of them dead, leader does not improve anymore
+    {
+        Evolution e(10,10,std::make_shared<TimedSimFactory>(false),2);
+        e.setFixedTimeStep(0.1);
+        Evolution::EpochTermination t;
+        t.deadFraction = 0.5;
+        t.convergenceSteps = 20;
+        e.setEpochTermination(t);
+
+        size_t steps = 0;
+        while( !e.isEpochOver() && steps < 100 )
+        {
+            e.doStep();
+            steps++;
+        }
+
+        ASSERT_EQ( steps, 21u );
+        ASSERT_EQ( e.getLastEpochEnd(), Evolution::EpochEnd::Converged );
+        ASSERT_EQ( e.getNumberAliveAndDead().first, 0u );
+    }
+}
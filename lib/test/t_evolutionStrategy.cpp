@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+#include "evolutionStrategy.h"
+
+namespace
+{
+    /**
+     * Runs the strategy on an ellipsoid with its optimum at target.
+     * @return Number of generations until the mean is within tolerance.
+     */
+    size_t optimizeEllipsoid( EvolutionStrategy& es, const Eigen::VectorXd& target, size_t lambda, double tolerance )
+    {
+        std::mt19937 gen( 17 );
+        Eigen::VectorXd scale = Eigen::VectorXd::LinSpaced( target.size(), 1.0, 10.0 );
+
+        std::vector<Eigen::VectorXd> x( lambda );
+        std::vector<double> fitness( lambda );
+        for( size_t g = 1; g <= 2000; g++ )
+        {
+            for( size_t k = 0; k < lambda; k++ )
+            {
+                es.sample( x[k], gen );
+                fitness[k] = -( x[k] - target ).cwiseProduct( scale ).squaredNorm();
+            }
+            EXPECT_TRUE( es.update( x, fitness ) );
+
+            if( ( es.getMean() - target ).norm() < tolerance )
+                return g;
+        }
+        return 0;
+    }
+}
+
+TEST(EvolutionStrategy, FullCovariance)
+{
+    Eigen::VectorXd target = Eigen::VectorXd::LinSpaced( 8, -2.0, 3.0 );
+    EvolutionStrategy es( Eigen::VectorXd::Zero( 8 ), 1.0, EvolutionStrategy::Full );
+
+    size_t generations = optimizeEllipsoid( es, target, 12, 1e-4 );
+    ASSERT_GT( generations, 0u );
+    ASSERT_LT( generations, 400u );
+    ASSERT_EQ( es.getNumberOfGenerations(), generations );
+
+    // converged: small steps, the variance follows the ellipsoid
+    ASSERT_LT( es.getSigma(), 1e-2 );
+    Eigen::VectorXd var = es.getVariances();
+    ASSERT_GT( var(0), var(7) );
+}
+
+TEST(EvolutionStrategy, Diagonal)
+{
+    Eigen::VectorXd target = Eigen::VectorXd::LinSpaced( 30, -1.0, 1.0 );
+    EvolutionStrategy es( Eigen::VectorXd::Zero( 30 ), 1.0, EvolutionStrategy::Diagonal );
+
+    size_t generations = optimizeEllipsoid( es, target, 16, 1e-4 );
+    ASSERT_GT( generations, 0u );
+    ASSERT_LT( generations, 1000u );
+    ASSERT_EQ( es.getDimension(), 30u );
+}
+
+TEST(EvolutionStrategy, InvalidUpdate)
+{
+    EvolutionStrategy es( Eigen::VectorXd::Zero( 3 ) );
+
+    std::vector<Eigen::VectorXd> x = { Eigen::VectorXd::Zero( 3 ) };
+    ASSERT_FALSE( es.update( x, {1.0} ) );
+
+    x.push_back( Eigen::VectorXd::Zero( 4 ) );
+    ASSERT_FALSE( es.update( x, {1.0, 2.0} ) );
+    ASSERT_EQ( es.getNumberOfGenerations(), 0u );
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "executor.h"
+
+TEST(Executor, Post)
+{
+    std::atomic<int> counter{0};
+    {
+        Executor ex( 3 );
+        ASSERT_EQ( ex.getNumberOfThreads(), 3u );
+        for( int k = 0; k < 100; k++ )
+            ex.post( [&counter]{ counter++; } );
+    } // destructor executes the remaining tasks
+
+    ASSERT_EQ( counter, 100 );
+}
+
+TEST(Executor, ParallelFor)
+{
+    Executor ex( 3 );
+
+    for( size_t n : {0u, 1u, 7u, 52u, 1000u} )
+    {
+        std::vector<int> visited( n, 0 );
+        ex.parallelFor( n, [&visited, n]( size_t begin, size_t end )
+        {
+            EXPECT_LE( begin, end );
+            EXPECT_LE( end, n );
+            for( size_t k = begin; k < end; k++ )
+                visited[k]++;
+        });
+
+        for( size_t k = 0; k < n; k++ )
+            ASSERT_EQ( visited[k], 1 );
+    }
+
+    // nested call from a worker thread does not deadlock
+    std::atomic<size_t> sum{0};
+    ex.parallelFor( 4, [&ex, &sum]( size_t begin, size_t end )
+    {
+        for( size_t k = begin; k < end; k++ )
+            ex.parallelFor( 10, [&sum]( size_t b, size_t e ) { sum += e - b; } );
+    });
+    ASSERT_EQ( sum, 40u );
+}
@@ -178,4 +178,30 @@ TEST(Genetic, CrossoverMutation)
         ASSERT_FALSE((l_a->getBiasVector() - l_c->getBiasVector()).isMuchSmallerThan(0.00001));
         ASSERT_FALSE((l_a->getWeightMatrix() - l_c->getWeightMatrix()).isMuchSmallerThan(0.00001));
     }
-}
\ No newline at end of file
+}
+TEST(Genetic, ParameterVector)
+{
+    NetworkPtr a( new Network({3,4,2}) );
+    ASSERT_EQ( Genetic::getNumberOfParameters( a ), Genetic::getParameterVector( a ).size() );
+
+    size_t n = 0;
+    for( unsigned int i = 0; i < a->getNumberOfLayer(); i++ )
+        n += a->getLayer(i)->getWeightMatrix().size() + a->getLayer(i)->getBiasVector().size();
+    ASSERT_EQ( Genetic::getNumberOfParameters( a ), n );
+
+    // copies share the parameters until written
+    NetworkPtr b( new Network( *a ) );
+    Eigen::VectorXd p = Eigen::VectorXd::LinSpaced( n, -1.0, 1.0 );
+    ASSERT_TRUE( Genetic::setParameterVector( b, p ) );
+    ASSERT_TRUE( Genetic::getParameterVector( b ).isApprox( p ) );
+    ASSERT_FALSE( Genetic::getParameterVector( a ).isApprox( p ) );
+
+    // output layer: weights column major, then biases
+    const Eigen::MatrixXd& w = b->getOutputLayer()->getWeightMatrix();
+    const Eigen::MatrixXd& bias = b->getOutputLayer()->getBiasVector();
+    ASSERT_DOUBLE_EQ( bias(1), p(n-1) );
+    ASSERT_DOUBLE_EQ( w(1,3), p(n-3) );
+    ASSERT_DOUBLE_EQ( w(0,0), p(n-2-8) );
+
+    ASSERT_FALSE( Genetic::setParameterVector( b, Eigen::VectorXd::Zero( n + 1 ) ) );
+}
@@ -0,0 +1,167 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+#include "islandModel.h"
+#include "network.h"
+#include "oneStepSimulation.h"
+
+#include <cstdlib>
+#include <memory>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    std::shared_ptr<Evolution> createIslandEvolution( size_t )
+    {
+        return std::shared_ptr<Evolution>( new Evolution( 20, 20, SimFactoryPtr( new OneStepSimFactory() ), 1 ) );
+    }
+}
+
+TEST(Migration, Topologies)
+{
+    RingTopology ring;
+    ASSERT_EQ( ring.getTargets( 0, 4 ), std::vector<size_t>({1}) );
+    ASSERT_EQ( ring.getTargets( 3, 4 ), std::vector<size_t>({0}) );
+    ASSERT_EQ( ring.getSources( 0, 4 ), std::vector<size_t>({3}) );
+    ASSERT_TRUE( ring.getTargets( 0, 1 ).empty() );
+
+    FullyConnectedTopology full;
+    ASSERT_EQ( full.getTargets( 1, 3 ), std::vector<size_t>({0, 2}) );
+    ASSERT_EQ( full.getSources( 1, 3 ), std::vector<size_t>({0, 2}) );
+}
+
+TEST(Migration, EncodeDecode)
+{
+    MigrationMessage m;
+    m.round = 7;
+    m.source = 3;
+    m.genomes.push_back( NetworkPtr( new Network( {2,3,1} ) )->serialize() );
+    m.genomes.push_back( std::string( "\0ab", 3 ) );
+
+    std::string buffer = SocketMigrationChannel::encode( m );
+
+    MigrationMessage d;
+    ASSERT_TRUE( SocketMigrationChannel::decode( buffer, d ) );
+    ASSERT_EQ( d.round, 7 );
+    ASSERT_EQ( d.source, 3 );
+    ASSERT_EQ( d.genomes, m.genomes );
+
+    ASSERT_FALSE( SocketMigrationChannel::decode( buffer.substr( 0, buffer.size() - 1 ), d ) );
+    ASSERT_FALSE( SocketMigrationChannel::decode( "garbage", d ) );
+}
+
+TEST(Migration, LocalChannel)
+{
+    std::vector<std::shared_ptr<LocalMigrationChannel>> channels = LocalMigrationChannel::createGroup( 3 );
+
+    MigrationMessage m;
+    m.genomes.push_back( "x" );
+    for( uint32_t source : {2, 0} )
+    {
+        m.source = source;
+        ASSERT_TRUE( channels[source]->send( 1, m ) );
+    }
+
+    // a message of the next round stays in the inbox
+    m.round = 1;
+    ASSERT_TRUE( channels[0]->send( 1, m ) );
+
+    std::vector<MigrationMessage> received;
+    ASSERT_TRUE( channels[1]->receive( 0, 2, received, 1.0 ) );
+    ASSERT_EQ( received.size(), 2 );
+    ASSERT_EQ( received[0].source, 0 );
+    ASSERT_EQ( received[1].source, 2 );
+
+    ASSERT_FALSE( channels[1]->receive( 1, 2, received, 0.05 ) );
+    ASSERT_EQ( received.size(), 1 );
+}
+
+TEST(Islands, Threads)
+{
+    IslandModel model( 3, createIslandEvolution, std::shared_ptr<MigrationTopology>( new FullyConnectedTopology() ) );
+    model.setMigrationInterval( 2 );
+    model.setNumberOfMigrants( 2 );
+
+    // migrations after epoch 2 and 4
+    ASSERT_TRUE( model.run( 5 ) );
+    ASSERT_EQ( model.getIslands().size(), 3 );
+
+    for( const std::shared_ptr<Island>& island : model.getIslands() )
+    {
+        ASSERT_EQ( island->getNumberOfImmigrants(), 2 * 2 * 2 );
+        ASSERT_EQ( island->getEvolution()->getNumberOfEpochs(), 5u );
+        ASSERT_EQ( island->getEvolution()->getSimulationsOrderedByFitness().size(), 20 + ( island->getEvolution()->isKeepParents() ? 2 : 0 ) + 2 * 2 );
+    }
+
+    ASSERT_TRUE( model.getFittest() != nullptr );
+}
+
+TEST(Islands, Processes)
+{
+    char dirTemplate[] = "/tmp/eidnn_islandsXXXXXX";
+    ASSERT_TRUE( mkdtemp( dirTemplate ) != nullptr );
+    std::string dir( dirTemplate );
+
+    const size_t nbrOfIslands = 3;
+    std::cout.flush();
+
+    std::vector<pid_t> children;
+    for( size_t k = 0; k < nbrOfIslands; k++ )
+    {
+        pid_t pid = fork();
+        ASSERT_GE( pid, 0 );
+
+        if( pid == 0 )
+        {
+            int status = 1;
+            {
+                std::shared_ptr<SocketMigrationChannel> channel( new SocketMigrationChannel( dir, k, 10.0 ) );
+                Island island( k, nbrOfIslands, createIslandEvolution( k ),
+                               std::shared_ptr<MigrationTopology>( new RingTopology() ), channel );
+                island.setMigrationInterval( 2 );
+                island.setNumberOfMigrants( 3 );
+                island.setMigrationTimeout( 10.0 );
+
+                // migrations after epoch 2 and 4, one source each
+                if( channel->isListening() && island.run( 5 ) && island.getNumberOfImmigrants() == 2 * 3 )
+                    status = 0;
+            }
+            std::cout.flush();
+            _exit( status );
+        }
+        children.push_back( pid );
+    }
+
+    for( pid_t pid : children )
+    {
+        int status = 0;
+        ASSERT_EQ( waitpid( pid, &status, 0 ), pid );
+        EXPECT_TRUE( WIFEXITED( status ) );
+        EXPECT_EQ( WEXITSTATUS( status ), 0 );
+    }
+
+    rmdir( dir.c_str() );
+}
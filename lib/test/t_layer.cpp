@@ -415,3 +415,36 @@ TEST(LayerTest, Regularization)
     delete l2;
 }
 
+
+TEST(LayerTest, CopyOnWrite)
+{
+    Layer* l = new Layer(3,2);
+    Layer* l2 = new Layer(*l);
+
+    // copies share weights and biases
+    ASSERT_EQ( l->getWeightMatrix().data(), l2->getWeightMatrix().data() );
+    ASSERT_EQ( l->getBiasVector().data(), l2->getBiasVector().data() );
+
+    Eigen::MatrixXd w = l->getWeightMatrix();
+    Eigen::MatrixXd b = l->getBiasVector();
+
+    // writing detaches
+    l2->setBias( 0.5 );
+    ASSERT_NE( l->getBiasVector().data(), l2->getBiasVector().data() );
+    ASSERT_TRUE( l->getBiasVector().isApprox( b ) );
+    ASSERT_TRUE( l2->getWeightMatrix().isApprox( w ) );
+    ASSERT_FLOAT_EQ( l2->getBiasVector()(2,0), 0.5 );
+
+    // a taken snapshot does not change anymore
+    std::shared_ptr<const LayerParameters> snapshot = l->getParameters();
+    l->updateWeightsAndBiases( Eigen::MatrixXd::Ones(3,1), Eigen::MatrixXd::Ones(3,2), 1.0 );
+    ASSERT_TRUE( snapshot->weights.isApprox( w ) );
+    ASSERT_TRUE( l->getWeightMatrix().isApprox( w - Eigen::MatrixXd::Ones(3,2) ) );
+
+    ASSERT_TRUE( l2->setParameters( snapshot ) );
+    ASSERT_EQ( l2->getWeightMatrix().data(), snapshot->weights.data() );
+    ASSERT_FALSE( l2->setParameters( Layer(2,2).getParameters() ) );
+
+    delete l;
+    delete l2;
+}
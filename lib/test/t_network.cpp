@@ -23,6 +23,7 @@
 
 #include <random>
 #include <thread>
+#include <chrono>
 #include <cstdio>
 #include <unordered_set>
 
@@ -512,6 +513,8 @@ TEST(NetworkTest, Backpropagate_StochasticGD)
 
     std::cout << "Best Result =  " << bestResult * 100 <<  "%" << std::endl;
 
+    net->waitForObserver(); // observer is called from the event channel thread
+
     ASSERT_GT( bestResult, 0.9 );
     ASSERT_TRUE(  tb->m_lastOpId == NetworkOperationCallback::OpTestNetwork );
     ASSERT_TRUE( tb->m_lastOpStatus == NetworkOperationCallback::OpResultOk );
@@ -582,21 +585,74 @@ TEST(NetworkTest, Backpropagate_StochasticGD_Async)
     TestCallback2* tb = new TestCallback2();
     net->setObserver( tb );
 
-    ASSERT_TRUE( net->stochasticGradientDescentAsync( xin, yout, 100, 0.1, 1234 ) );
-    ASSERT_FALSE( net->stochasticGradientDescentAsync( xin, yout, 100, 0.1, 1234 ) ); // since already async operation in progress;
+    NetworkJobPtr first = net->stochasticGradientDescentAsync( xin, yout, 100, 0.1, 1234 );
+    NetworkJobPtr second = net->stochasticGradientDescentAsync( xin, yout, 100, 0.1, 4321 ); // queued behind the first one
     ASSERT_TRUE( net->isOperationInProgress() );
 
-    net->getCurrentAsyncOperation().join(); // waits till thread ends
-
-    ASSERT_EQ(tb->m_lastUserId, 1234);
+    ASSERT_TRUE( first->get() ); // waits till job ends
 
-    ASSERT_TRUE(net->stochasticGradientDescentAsync( xin, yout, 100, 0.1, 4321 ) ); // call a third time, now it should work again
-    net->getCurrentAsyncOperation().join(); // waits till thread ends
+    ASSERT_TRUE( second->get() );
+    net->waitForObserver();
     ASSERT_EQ(tb->m_lastUserId, 4321);
 
     ASSERT_FALSE( net->isOperationInProgress() );
     ASSERT_EQ( tb->m_lastStatus, NetworkOperationCallback::OpResultOk );
 
+    // test results are available from the job
+    NetworkJobPtr test = net->testNetworkAsync( xin, yout, 0.5, 99 );
+    ASSERT_TRUE( test->get() );
+    ASSERT_EQ( test->getOperationId(), NetworkOperationCallback::OpTestNetwork );
+    ASSERT_GT( test->getTestResults().successRateMaxIdx, 0.0 );
+    net->waitForObserver();
+    ASSERT_EQ(tb->m_lastUserId, 99);
+
+    delete net;
+    delete tb;
+}
+
+TEST(NetworkTest, Async_Cancel)
+{
+    std::vector<Eigen::MatrixXd> xin;
+    std::vector<Eigen::MatrixXd> yout;
+    for( uint k = 0; k < 20000; k++ )
+    {
+        xin.push_back( Eigen::MatrixXd::Random(10,1) );
+        yout.push_back( Eigen::MatrixXd::Random(10,1) );
+    }
+
+    std::vector<unsigned int> map = {10,200,200,10};
+    Network* net = new Network(map);
+
+    TestCallback2* tb = new TestCallback2();
+    net->setObserver( tb );
+    net->setSnapshotInterval( 1 ); // the snapshot version counts the trained batches
+
+    NetworkJobPtr running = net->stochasticGradientDescentAsync( xin, yout, 1, 0.1, 1 );
+    NetworkJobPtr queued = net->stochasticGradientDescentAsync( xin, yout, 1, 0.1, 2 );
+
+    while( running->getStatus() == NetworkJob::JobQueued )
+        std::this_thread::yield();
+
+    running->cancel();
+    queued->cancel();
+    running->wait();
+    queued->wait();
+
+    // stopped within the epoch, the queued job never trained
+    NetworkSnapshotPtr snapshot = net->getSnapshot();
+    uint64_t trainedBatches = snapshot ? snapshot->getVersion() : 0;
+    ASSERT_LT( trainedBatches, xin.size() );
+    ASSERT_EQ( running->getStatus(), NetworkJob::JobCancelled );
+    ASSERT_EQ( queued->getStatus(), NetworkJob::JobCancelled );
+    ASSERT_FALSE( net->isOperationInProgress() );
+
+    net->waitForObserver();
+    ASSERT_EQ( tb->m_lastStatus, NetworkOperationCallback::OpCancelled );
+    ASSERT_EQ( tb->m_lastUserId, 2 );
+
+    // destroying the network cancels and waits for its operations
+    net->stochasticGradientDescentAsync( xin, yout, 1, 0.1, 3 );
+    net->stochasticGradientDescentAsync( xin, yout, 1, 0.1, 4 );
     delete net;
     delete tb;
 }
@@ -659,6 +715,31 @@ TEST(NetworkTest, Serialize)
     delete copy;
 }
 
+TEST(NetworkTest, DeserializeCorrupt)
+{
+    std::vector<unsigned int> map = {3,5,2};
+    Network net(map);
+    std::string buf = net.serialize();
+
+    std::unique_ptr<Network> copy( Network::deserialize( buf ) );
+    ASSERT_TRUE( copy );
+    ASSERT_EQ( copy->getNetworkStructure(), map );
+
+    // every truncation and trailing data is detected
+    for( size_t k = 0; k < buf.size(); k++ )
+        ASSERT_EQ( Network::deserialize( buf.substr( 0, k ) ), nullptr );
+    ASSERT_EQ( Network::deserialize( buf + "x" ), nullptr );
+
+    // huge layer count and sizes
+    std::string corrupt = buf;
+    corrupt[3] = char(0x7f);
+    ASSERT_EQ( Network::deserialize( corrupt ), nullptr );
+    corrupt = buf;
+    corrupt[4 * 4 + 4] = char(0xff); // neurons of the first layer
+    ASSERT_EQ( Network::deserialize( corrupt ), nullptr );
+    ASSERT_EQ( Network::deserialize( std::string( 64, char(0xff) ) ), nullptr );
+}
+
 TEST(NetworkTest, SerializeToFile)
 {
     std::vector<unsigned int> map = {1,5,2,1};
@@ -810,3 +891,139 @@ TEST(NetworkTest, UserID)
 
     delete net;
 }
+
+TEST(NetworkTest, Stats)
+{
+    std::vector<Eigen::MatrixXd> xin;
+    std::vector<Eigen::MatrixXd> yout;
+    for( uint k = 0; k < 100; k++ )
+    {
+        xin.push_back( Eigen::MatrixXd::Random(4,1) );
+        yout.push_back( Eigen::MatrixXd::Constant(2,1,0.5) );
+    }
+
+    Network* net = new Network({4,5,2});
+    ASSERT_FALSE( net->isStatsEnabled() );
+
+    net->setStatsEnabled( true );
+    ASSERT_TRUE( net->stochasticGradientDescent( xin, yout, 10, 0.1 ) );
+
+    NetworkStats stats = net->getStats();
+    ASSERT_EQ( stats.layers.size(), 3 );
+
+    if( NetworkStats::isCompiledIn() )
+    {
+        ASSERT_EQ( stats.batches, 10 );
+        ASSERT_EQ( stats.samples, 100 );
+        ASSERT_EQ( stats.phases[NetworkStats::BatchGather].count, 10 );
+        ASSERT_EQ( stats.phases[NetworkStats::GradientReduction].count, 20 ); // 2 layers
+        ASSERT_EQ( stats.phases[NetworkStats::ObserverCallback].count, 11 ); // 10 progress + result
+
+        for( unsigned int l = 1; l < 3; l++ )
+        {
+            ASSERT_EQ( stats.layers[l].phases[LayerStats::FeedForward].count, 10 );
+            ASSERT_EQ( stats.layers[l].phases[LayerStats::BackpropagationError].count, 10 );
+            ASSERT_EQ( stats.layers[l].phases[LayerStats::PartialDerivatives].count, 10 );
+            ASSERT_EQ( stats.layers[l].phases[LayerStats::Update].count, 10 );
+            ASSERT_GT( stats.layers[l].phases[LayerStats::FeedForward].nanoseconds, 0 );
+        }
+
+        ASSERT_EQ( stats.total(LayerStats::FeedForward).count, 20 );
+
+        net->resetStats();
+        ASSERT_EQ( net->getStats().batches, 0 );
+        ASSERT_EQ( net->getStats().total(LayerStats::Update).count, 0 );
+    }
+    else
+    {
+        ASSERT_EQ( stats.batches, 0 );
+        ASSERT_EQ( stats.total(LayerStats::FeedForward).count, 0 );
+    }
+
+    // disabled -> nothing is measured
+    net->resetStats();
+    net->setStatsEnabled( false );
+    ASSERT_TRUE( net->stochasticGradientDescent( xin, yout, 10, 0.1 ) );
+    ASSERT_EQ( net->getStats().batches, 0 );
+    ASSERT_EQ( net->getStats().total(LayerStats::FeedForward).count, 0 );
+
+    delete net;
+}
+
+TEST(NetworkTest, Snapshot)
+{
+    std::vector<Eigen::MatrixXd> xin;
+    std::vector<Eigen::MatrixXd> yout;
+    for( uint k = 0; k < 2000; k++ )
+    {
+        Eigen::MatrixXd thisSample = Eigen::MatrixXd::Random(2,1);
+        Eigen::MatrixXd thisLable(2,1);
+        if( thisSample(0,0) > thisSample(1,0) )
+            thisLable << 1.0, 0.0;
+        else
+            thisLable << 0.0, 1.0;
+
+        xin.push_back( thisSample );
+        yout.push_back( thisLable );
+    }
+
+    std::vector<unsigned int> map = {2,8,2};
+    Network* net = new Network(map);
+    ASSERT_FALSE( net->getSnapshot() );
+
+    net->setSnapshotInterval( 10 );
+    NetworkJobPtr job = net->stochasticGradientDescentAsync( xin, yout, 5, 0.5, 0 );
+
+    // evaluate while training
+    uint64_t lastVersion = 0;
+    Eigen::MatrixXd out;
+    while( !job->isFinished() )
+    {
+        NetworkSnapshotPtr s = net->getSnapshot();
+        if( s )
+        {
+            ASSERT_GE( s->getVersion(), lastVersion );
+            lastVersion = s->getVersion();
+            ASSERT_TRUE( s->feedForward( xin[0], out ) );
+        }
+    }
+    ASSERT_TRUE( job->get() );
+
+    // the final snapshot matches the trained network
+    NetworkSnapshotPtr s = net->getSnapshot();
+    ASSERT_EQ( s->getVersion(), 400u );
+    ASSERT_TRUE( net->feedForward( xin[1] ) );
+    ASSERT_TRUE( s->feedForward( xin[1], out ) );
+    ASSERT_TRUE( out.isApprox( net->getOutputActivation() ) );
+
+    double successRateEuc; double successRateMaxIdx; double avgCost; std::vector<size_t> failedSamples;
+    ASSERT_TRUE( net->testNetwork( xin, yout, 0.3, false, successRateEuc, successRateMaxIdx, avgCost, failedSamples ) );
+    TestCallback2 tb;
+    net->setObserver( &tb );
+    NetworkJobPtr testJob = s->testAsync( xin, yout, 0.3, 7, net->getEventChannel() );
+    ASSERT_TRUE( testJob->get() );
+
+    // delivered through the event channel of the network
+    net->waitForObserver();
+    ASSERT_EQ( tb.m_lastUserId, 7 );
+    ASSERT_EQ( tb.m_lastStatus, NetworkOperationCallback::OpResultOk );
+    net->setObserver( NULL );
+
+    ASSERT_DOUBLE_EQ( testJob->getTestResults().successRateEuclidean, successRateEuc );
+    ASSERT_DOUBLE_EQ( testJob->getTestResults().successRateMaxIdx, successRateMaxIdx );
+    ASSERT_NEAR( testJob->getTestResults().averageCost, avgCost, 1e-9 );
+    ASSERT_EQ( testJob->getTestResults().failedSamplesIdx, failedSamples );
+
+    // training goes on without changing the snapshot
+    ASSERT_TRUE( net->stochasticGradientDescent( xin, yout, 5, 0.5 ) );
+    Eigen::MatrixXd outBefore = out;
+    ASSERT_TRUE( s->feedForward( xin[1], out ) );
+    ASSERT_TRUE( out.isApprox( outBefore ) );
+
+    // network from snapshot
+    Network fromSnapshot( *s );
+    ASSERT_TRUE( fromSnapshot.feedForward( xin[1] ) );
+    ASSERT_TRUE( fromSnapshot.getOutputActivation().isApprox( outBefore ) );
+
+    delete net;
+}
@@ -0,0 +1,159 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "spscQueue.h"
+#include "networkEventChannel.h"
+
+class SlowCallback: public NetworkOperationCallback
+{
+public:
+    void networkOperationProgress( const NetworkOperationId&, const NetworkOperationStatus& status,
+                                   const double&, const int& userId ) override
+    {
+        if( m_gated )
+        {
+            // blocks until the test opens the gate
+            std::unique_lock<std::mutex> lock( m_gateMutex );
+            m_gate.wait( lock, [this]{ return !m_gated; } );
+        }
+        else
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+        }
+
+        if( status == OpInProgress )
+            m_nbrInProgress++;
+        else
+            m_nbrResults++;
+        m_lastUserId = userId;
+    }
+
+    void networkTestResults( const double&, const double&, const double&,
+                             const std::vector<std::size_t>& failedSamplesIdx, const int& ) override
+    {
+        m_nbrTestResults++;
+        m_lastFailed = failedSamplesIdx.size();
+    }
+
+    void openGate()
+    {
+        std::lock_guard<std::mutex> lock( m_gateMutex );
+        m_gated = false;
+        m_gate.notify_all();
+    }
+
+    std::atomic<bool> m_gated{false};
+    std::mutex m_gateMutex;
+    std::condition_variable m_gate;
+
+    int m_nbrInProgress = 0;
+    int m_nbrResults = 0;
+    int m_nbrTestResults = 0;
+    int m_lastUserId = 0;
+    size_t m_lastFailed = 0;
+};
+
+TEST(SpscQueue, PushPop)
+{
+    SpscQueue<int> queue( 3 );
+    ASSERT_TRUE( queue.empty() );
+    ASSERT_TRUE( queue.push( 1 ) );
+    ASSERT_TRUE( queue.push( 2 ) );
+    ASSERT_TRUE( queue.push( 3 ) );
+    ASSERT_FALSE( queue.push( 4 ) ); // full
+
+    int v;
+    for( int k = 1; k <= 3; k++ )
+    {
+        ASSERT_TRUE( queue.pop( v ) );
+        ASSERT_EQ( v, k );
+    }
+    ASSERT_FALSE( queue.pop( v ) );
+
+    // wrap around in another thread
+    const int n = 100000;
+    std::thread producer( [&queue]() {
+        for( int k = 0; k < n; k++ )
+            while( !queue.push( int(k) ) )
+                std::this_thread::yield();
+    });
+
+    int expected = 0;
+    while( expected < n )
+    {
+        if( queue.pop( v ) )
+            ASSERT_EQ( v, expected++ );
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+}
+
+TEST(NetworkEventChannel, SlowObserver)
+{
+    SlowCallback cb;
+    cb.m_gated = true; // the observer blocks in its first call
+    NetworkEventChannel channel( &cb, 0.0, 8 ); // no rate limit, small queue
+
+    // the producer must not wait for the blocked observer, otherwise it never gets here
+    for( int k = 0; k < 1000; k++ )
+        channel.progress( NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpInProgress, k / 1000.0, 1 );
+    for( int k = 0; k < 20; k++ )
+        channel.progress( NetworkOperationCallback::OpStochasticGradientDescent, NetworkOperationCallback::OpResultOk, 1.0, 2 );
+    channel.testResults( 0.5, 0.5, 0.1, std::vector<size_t>( 7 ), 2 );
+    ASSERT_EQ( cb.m_nbrInProgress + cb.m_nbrResults, 0 );
+
+    cb.openGate();
+    channel.flush();
+
+    // result events are never dropped
+    ASSERT_EQ( cb.m_nbrResults, 20 );
+    ASSERT_EQ( cb.m_nbrTestResults, 1 );
+    ASSERT_EQ( cb.m_lastFailed, 7u );
+    ASSERT_EQ( cb.m_lastUserId, 2 );
+    ASSERT_GT( channel.getNumberOfSkippedEvents(), 0u );
+    ASSERT_EQ( uint64_t(cb.m_nbrInProgress) + channel.getNumberOfSkippedEvents(), 1000u );
+}
+
+TEST(NetworkEventChannel, RateLimit)
+{
+    SlowCallback cb;
+    NetworkEventChannel channel( &cb, 10.0 );
+
+    for( int k = 0; k < 100; k++ )
+        channel.progress( NetworkOperationCallback::OpTestNetwork, NetworkOperationCallback::OpInProgress, k / 100.0, 3 );
+    channel.progress( NetworkOperationCallback::OpTestNetwork, NetworkOperationCallback::OpResultOk, 1.0, 3 );
+    channel.flush();
+
+    ASSERT_LE( cb.m_nbrInProgress, 2 );
+    ASSERT_EQ( cb.m_nbrResults, 1 );
+    ASSERT_EQ( cb.m_lastUserId, 3 );
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+#include "selection.h"
+
+#include <vector>
+
+namespace
+{
+    std::vector<size_t> histogram( Selection& s, const std::vector<double>& fitness, size_t draws )
+    {
+        std::mt19937 gen( 11 );
+        s.prepare( fitness );
+
+        std::vector<size_t> hist( fitness.size(), 0 );
+        for( size_t k = 0; k < draws; k++ )
+        {
+            size_t idx = s.select( gen );
+            EXPECT_LT( idx, fitness.size() );
+            if( idx < fitness.size() )
+                hist[idx]++;
+        }
+        return hist;
+    }
+}
+
+TEST(Selection, TopTwo)
+{
+    TopTwoSelection s;
+    ASSERT_EQ( s.getNumberOfCandidates( 100 ), 2 );
+
+    std::mt19937 gen( 1 );
+    std::mt19937 untouched = gen;
+    s.prepare( {5.0, 4.0} );
+    std::pair<size_t, size_t> parents = s.selectParents( gen );
+    ASSERT_EQ( parents.first, 0 );
+    ASSERT_EQ( parents.second, 1 );
+    ASSERT_TRUE( gen == untouched );
+}
+
+TEST(Selection, Elite)
+{
+    EliteSelection s( 3 );
+    ASSERT_EQ( s.getNumberOfCandidates( 100 ), 3 );
+    ASSERT_EQ( s.getNumberOfCandidates( 2 ), 2 );
+
+    std::vector<size_t> hist = histogram( s, {3.0, 2.0, 1.0}, 3000 );
+    for( size_t h : hist )
+        ASSERT_GT( h, 800 );
+}
+
+TEST(Selection, Tournament)
+{
+    std::vector<double> fitness( 10, 1.0 );
+
+    // size 1 -> uniform
+    TournamentSelection uniform( 1 );
+    for( size_t h : histogram( uniform, fitness, 10000 ) )
+        ASSERT_GT( h, 800 );
+
+    // the best wins most tournaments of size 5
+    TournamentSelection s( 5 );
+    std::vector<size_t> hist = histogram( s, fitness, 10000 );
+    ASSERT_GT( hist[0], hist[1] );
+    ASSERT_GT( hist[1], hist[9] );
+    ASSERT_GT( hist[0], 3500 );
+}
+
+TEST(Selection, Rank)
+{
+    std::vector<double> fitness = {100.0, 10.0, 5.0, 1.0};
+
+    // pressure 2 -> probabilities 2/n * (n-1-rank)/(n-1): 0.5, 0.33, 0.17, 0
+    RankSelection s( 2.0 );
+    std::vector<size_t> hist = histogram( s, fitness, 12000 );
+    ASSERT_NEAR( hist[0], 6000, 400 );
+    ASSERT_NEAR( hist[1], 4000, 400 );
+    ASSERT_NEAR( hist[2], 2000, 400 );
+    ASSERT_EQ( hist[3], 0 );
+
+    // only the rank counts, not the fitness difference
+    RankSelection u( 1.0 );
+    for( size_t h : histogram( u, fitness, 12000 ) )
+        ASSERT_NEAR( h, 3000, 300 );
+}
+
+TEST(Selection, FitnessProportional)
+{
+    FitnessProportionalSelection s;
+    std::vector<size_t> hist = histogram( s, {5.0, 3.0, 1.0}, 12000 );
+    ASSERT_NEAR( hist[0], 8000, 400 );
+    ASSERT_NEAR( hist[1], 4000, 400 );
+    ASSERT_LT( hist[2], 100 );
+
+    // all equal -> uniform, negative fitness is fine
+    for( size_t h : histogram( s, {-2.0, -2.0, -2.0}, 12000 ) )
+        ASSERT_NEAR( h, 4000, 400 );
+}
+
+TEST(Selection, DifferentParents)
+{
+    EliteSelection s( 2 );
+    s.prepare( {2.0, 1.0} );
+
+    std::mt19937 gen( 3 );
+    size_t same = 0;
+    for( int k = 0; k < 1000; k++ )
+    {
+        std::pair<size_t, size_t> p = s.selectParents( gen );
+        if( p.first == p.second )
+            same++;
+    }
+    ASSERT_LT( same, 10 );
+}
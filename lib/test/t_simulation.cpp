@@ -27,6 +27,65 @@
 #include <thread>
 
 #include "simulation.h"
+#include "multiSimulation.h"
+#include "evolution.h"
+#include "genetic.h"
+#include "helpers.h"
+
+namespace
+{
+    /**
+     * Lives for a number of steps, the fitness depends on the network
+     * output and on a factor of the "track".
+     */
+    class TrackSimulation: public Simulation
+    {
+    public:
+        TrackSimulation( size_t life, double factor ): m_life( life ), m_factor( factor )
+        {
+            m_network = NetworkPtr( new Network( {2,3,1} ) );
+        }
+
+        double getFitness() override
+        {
+            return m_factor * m_network->getOutputActivation()(0,0) * double( getNumberOfSteps() );
+        }
+
+        size_t m_life;
+        double m_factor;
+
+    protected:
+        void update() override
+        {
+            m_network->feedForward( Eigen::MatrixXd::Constant( 2, 1, 0.5 ) );
+            if( getNumberOfSteps() + 1 >= m_life )
+                m_alive = false;
+        }
+    };
+
+    class TrackSimFactory: public SimulationFactory
+    {
+    public:
+        TrackSimFactory( size_t life, double factor ): m_life( life ), m_factor( factor ) { }
+
+        SimulationPtr createRandomSimulation() override
+        {
+            return SimulationPtr( new TrackSimulation( m_life, m_factor ) );
+        }
+
+        size_t m_life;
+        double m_factor;
+    };
+
+    std::shared_ptr<MultiSimulationFactory> createTracks( MultiSimulation::Aggregation aggregation )
+    {
+        std::vector<SimFactoryPtr> tracks = {
+            SimFactoryPtr( new TrackSimFactory( 4, 1.0 ) ),
+            SimFactoryPtr( new TrackSimFactory( 6, 2.0 ) ),
+            SimFactoryPtr( new TrackSimFactory( 2, 3.0 ) ) };
+        return std::make_shared<MultiSimulationFactory>( tracks, aggregation );
+    }
+}
 
 TEST(Simulation, TimeElapsed)
 {
@@ -44,4 +103,90 @@ TEST(Simulation, TimeElapsed)
     delete s;
 }
 
+TEST(Simulation, FixedTimeStep)
+{
+    Simulation s;
+
+    for(int k = 0; k < 10; k++ )
+    {
+        s.doStep(0.1);
+        ASSERT_DOUBLE_EQ(s.getStepDuration(), 0.1);
+    }
+
+    ASSERT_NEAR(s.getAge(), 1.0, 1e-9);
+
+    s.reset();
+    ASSERT_DOUBLE_EQ(s.getAge(), 0.0);
+}
+
+TEST(Simulation, MultiSimulation)
+{
+    std::shared_ptr<MultiSimulationFactory> f = createTracks( MultiSimulation::Mean );
+    std::shared_ptr<MultiSimulation> m = std::dynamic_pointer_cast<MultiSimulation>( f->createRandomSimulation() );
+    ASSERT_TRUE( m != nullptr );
+    ASSERT_EQ( m->getChildren().size(), 3u );
+
+    // one genome, own network objects
+    Eigen::VectorXd genome = Genetic::getParameterVector( m->getNetwork() );
+    ASSERT_EQ( m->getNetwork(), m->getChildren()[0]->getNetwork() );
+    for( const SimulationPtr& c : m->getChildren() )
+        ASSERT_TRUE( Genetic::getParameterVector( c->getNetwork() ).isApprox( genome ) );
+    ASSERT_NE( m->getChildren()[0]->getNetwork(), m->getChildren()[1]->getNetwork() );
+
+    // batched and single steps, lives as long as the longest living child
+    std::vector<SimulationPtr> sims = { m };
+    for( size_t k = 0; k < 3; k++ )
+        ASSERT_TRUE( f->doSteps( sims, 0, 1, 0.1 ) );
+    while( m->isAlive() )
+        m->doStep( 0.1 );
+    ASSERT_EQ( m->getNumberOfSteps(), 6u );
+    ASSERT_NEAR( m->getAge(), 0.6, 1e-9 );
+    ASSERT_FALSE( f->doSteps( sims, 0, 1, 0.1 ) );
+
+    double out = m->getNetwork()->getOutputActivation()(0,0);
+    ASSERT_NEAR( m->getFitness(), ( 1.0 * 4 + 2.0 * 6 + 3.0 * 2 ) * out / 3.0, 1e-9 );
+
+    std::shared_ptr<MultiSimulationFactory> fmin = createTracks( MultiSimulation::Min );
+    SimulationPtr mmin = fmin->createSimulation( m->getNetwork() );
+    while( mmin->isAlive() )
+        mmin->doStep( 0.1 );
+    ASSERT_NEAR( mmin->getFitness(), 4.0 * out, 1e-9 );
+
+    // recycling keeps the object, all children get the new genome
+    SimulationPtr a = f->createRandomSimulation();
+    SimulationPtr b = f->createRandomSimulation();
+    SimulationPtr r = f->recycleCrossover( m, a, b, 0.1 );
+    ASSERT_EQ( r, sims[0] );
+    ASSERT_TRUE( r->isAlive() );
+    ASSERT_EQ( r->getNumberOfSteps(), 0u );
+    genome = Genetic::getParameterVector( r->getNetwork() );
+    for( const SimulationPtr& c : m->getChildren() )
+    {
+        ASSERT_TRUE( c->isAlive() );
+        ASSERT_TRUE( Genetic::getParameterVector( c->getNetwork() ).isApprox( genome ) );
+    }
+}
+
+TEST(Simulation, MultiSimulationEvolution)
+{
+    auto run = []() -> std::vector<double>
+    {
+        Helpers::seedRandomGenerator( 3 );
+        Evolution e( 50, 30, createTracks( MultiSimulation::Min ), 3 );
+        e.setFixedTimeStep( 0.1 );
+        e.setMutationRate( 0.1 );
 
+        std::vector<double> best;
+        for( int k = 0; k < 5; k++ )
+        {
+            e.doEpoch();
+            best.push_back( e.getFittest().front()->getFitness() );
+            e.breed();
+        }
+        return best;
+    };
+
+    std::vector<double> best = run();
+    ASSERT_EQ( best, run() );
+    ASSERT_GE( best.back(), best.front() );
+}
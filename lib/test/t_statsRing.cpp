@@ -0,0 +1,91 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "statsRing.h"
+
+TEST(StatsRing, KeepsLatest)
+{
+    StatsRing<int> ring(4);
+    ASSERT_TRUE( ring.getLatest(10).empty() );
+
+    int value = 0;
+    ASSERT_FALSE( ring.get( 0, value ) );
+
+    for( int k = 1; k <= 6; k++ )
+        ring.push( k );
+
+    ASSERT_EQ( ring.getNumberOfRecords(), 6u );
+    ASSERT_EQ( ring.getLatest(10), std::vector<int>({ 3, 4, 5, 6 }) );
+    ASSERT_EQ( ring.getLatest(2), std::vector<int>({ 5, 6 }) );
+
+    // overwritten and not yet pushed
+    ASSERT_FALSE( ring.get( 1, value ) );
+    ASSERT_FALSE( ring.get( 6, value ) );
+    ASSERT_TRUE( ring.get( 2, value ) );
+    ASSERT_EQ( value, 3 );
+}
+
+TEST(StatsRing, ConsistentAcrossThreads)
+{
+    struct Record
+    {
+        int64_t a;
+        int64_t b;
+        double c;
+    };
+
+    StatsRing<Record> ring(8);
+    const int64_t n = 100000;
+
+    std::thread writer( [&ring]
+    {
+        for( int64_t k = 1; k <= n; k++ )
+            ring.push( Record{ k, -k, double(k) } );
+    });
+
+    // records are never torn and in order, asserted after the writer is joined
+    int64_t last = 0;
+    size_t torn = 0;
+    size_t unordered = 0;
+    while( last < n )
+    {
+        std::vector<Record> records = ring.getLatest(8);
+        for( size_t k = 0; k < records.size(); k++ )
+        {
+            if( records[k].a != -records[k].b || double(records[k].a) != records[k].c )
+                torn++;
+            if( k > 0 && records[k].a <= records[k-1].a )
+                unordered++;
+        }
+        if( !records.empty() )
+            last = records.back().a;
+    }
+
+    writer.join();
+    ASSERT_EQ( torn, 0u );
+    ASSERT_EQ( unordered, 0u );
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "trace.h"
+
+static size_t countOccurrences( const std::string& str, const std::string& what )
+{
+    size_t count = 0;
+    for( size_t pos = str.find(what); pos != std::string::npos; pos = str.find(what, pos + what.size()) )
+        count++;
+    return count;
+}
+
+TEST(Trace, RecordAndExport)
+{
+    Trace::clear();
+    Trace::setEnabled( true );
+
+    {
+        TraceScope s( "test", "main scope" );
+    }
+
+    std::thread th( []() {
+        Trace::setThreadName( "test worker" );
+        for( int k = 0; k < 3; k++ )
+            TraceScope s( "test", "worker scope" );
+    });
+    th.join();
+
+    Trace::setEnabled( false );
+    {
+        TraceScope s( "test", "disabled scope" );
+    }
+
+    std::ostringstream out;
+    Trace::exportChromeJson( out );
+    std::string json = out.str();
+
+    ASSERT_EQ( countOccurrences( json, "\"main scope\"" ), 1 );
+    ASSERT_EQ( countOccurrences( json, "\"worker scope\"" ), 3 );
+    ASSERT_EQ( countOccurrences( json, "\"disabled scope\"" ), 0 );
+    ASSERT_EQ( countOccurrences( json, "\"test worker\"" ), 1 );
+    ASSERT_EQ( json.find( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" ), 0 );
+
+    Trace::clear();
+    std::ostringstream outCleared;
+    Trace::exportChromeJson( outCleared );
+    ASSERT_EQ( countOccurrences( outCleared.str(), "scope\"" ), 0 );
+}
+
+TEST(Trace, RingBufferOverwrite)
+{
+    Trace::clear();
+
+    std::thread th( []() {
+        uint64_t t = Trace::now();
+        Trace::record( "test", "old", t, t + 1 );
+        for( size_t k = 0; k < Trace::EventsPerThread; k++ )
+            Trace::record( "test", "new", t, t + 1 );
+    });
+    th.join();
+
+    std::ostringstream out;
+    Trace::exportChromeJson( out );
+    std::string json = out.str();
+
+    // oldest event got overwritten, the ring keeps the last ones
+    ASSERT_EQ( countOccurrences( json, "\"old\"" ), 0 );
+    ASSERT_GE( countOccurrences( json, "\"new\"" ), Trace::EventsPerThread - 1 );
+    ASSERT_LE( countOccurrences( json, "\"new\"" ), Trace::EventsPerThread );
+
+    Trace::clear();
+}
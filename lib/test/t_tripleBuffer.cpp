@@ -0,0 +1,96 @@
+/****************************************************************************
+** Copyright (c) 2017 Adrian Schneider
+**
+** Permission is hereby granted, free of charge, to any person obtaining a
+** copy of this software and associated documentation files (the "Software"),
+** to deal in the Software without restriction, including without limitation
+** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+** and/or sell copies of the Software, and to permit persons to whom the
+** Software is furnished to do so, subject to the following conditions:
+**
+** The above copyright notice and this permission notice shall be included in
+** all copies or substantial portions of the Software.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+*****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "tripleBuffer.h"
+
+TEST(TripleBuffer, LatestWins)
+{
+    TripleBuffer<int> buf;
+    ASSERT_FALSE( buf.update() );
+
+    buf.getWriteBuffer() = 1;
+    buf.publish();
+    buf.getWriteBuffer() = 2;
+    buf.publish();
+
+    ASSERT_TRUE( buf.update() );
+    ASSERT_EQ( buf.getReadBuffer(), 2 );
+
+    // nothing new
+    ASSERT_FALSE( buf.update() );
+    ASSERT_EQ( buf.getReadBuffer(), 2 );
+
+    buf.getWriteBuffer() = 3;
+    buf.publish();
+    ASSERT_TRUE( buf.update() );
+    ASSERT_EQ( buf.getReadBuffer(), 3 );
+}
+
+TEST(TripleBuffer, ConsistentAcrossThreads)
+{
+    struct State
+    {
+        int a = 0;
+        int b = 0;
+    };
+
+    TripleBuffer<State> buf;
+    const int n = 100000;
+
+    std::thread producer( [&buf]
+    {
+        for( int k = 1; k <= n; k++ )
+        {
+            State& s = buf.getWriteBuffer();
+            s.a = k;
+            s.b = -k;
+            buf.publish();
+        }
+    });
+
+    // states are never torn and never go back in time
+    int last = 0;
+    int torn = 0;
+    int backwards = 0;
+    while( last < n )
+    {
+        if( buf.update() )
+        {
+            const State& s = buf.getReadBuffer();
+            if( s.a != -s.b )
+                torn++;
+            if( s.a <= last )
+                backwards++;
+            last = s.a;
+        }
+    }
+
+    // checked after joining, a failing assertion must not leave the producer running
+    producer.join();
+    ASSERT_EQ( torn, 0 );
+    ASSERT_EQ( backwards, 0 );
+}